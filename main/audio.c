@@ -1,28 +1,59 @@
 /*
- * WAV Audio Player
+ * Audio Service
+ * Resident playback task with alert clips preloaded into RAM
 */
 #include <dirent.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include <unistd.h>
 
+#include "audio.h"
 #include "bsp/esp-bsp.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_spiffs.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "radar_budget.h"
+#include "sdkconfig.h"
 
-/* Buffer for reading/writing to I2S driver. Same length as SPIFFS buffer and
-   I2S buffer, for optimal read/write performance. Recording audio data path:
-   I2S peripheral -> I2S buffer (DMA) -> App buffer (RAM) -> SPIFFS buffer ->
-   External SPI Flash. Vice versa for playback. */
-#define BUFFER_SIZE (1024)
+/* Samples handed to I2S per write. Small chunks keep pre-emption and the
+   trigger-to-output latency short: 256 samples are 11.6 ms at 22.05 kHz. */
+#define CHUNK_SAMPLES (256)
 #define SAMPLE_RATE (22050)
-#define DEFAULT_VOLUME (20)
+#define DEFAULT_VOLUME (CONFIG_AUDIO_VOLUME)
+#define CLIP_MAX_BYTES (32 * 1024)  // Larger WAV files are not preloaded
+#define QUEUE_DEPTH (4)
+
+/* Proximity tone: beep period, pitch and beep length limits */
+#define TONE_PERIOD_MIN_MS (120)
+#define TONE_PERIOD_MAX_MS (900)
+#define TONE_BEEP_MS (60)
+#define TONE_FREQ_NEAR_HZ (1800)
+#define TONE_FREQ_FAR_HZ (700)
+#define TONE_AMPLITUDE (10000)
+#define TONE_RAMP (32)	// Samples of fade at each beep edge
+#define TONE_TABLE_SIZE (256)
+
+/* Tone parameters packed in one word so the radar task can update them
+   with a single atomic store: period ms (10 bits), beep ms (10 bits),
+   frequency in 10 Hz steps (12 bits). 0 means silent. */
+#define TONE_PACK(period, on, freq) \
+	(((period) & 0x3FF) | (((on) & 0x3FF) << 10) | ((((freq) / 10) & 0xFFF) << 20))
+#define TONE_PERIOD_MS(w) ((w) & 0x3FF)
+#define TONE_ON_MS(w) (((w) >> 10) & 0x3FF)
+#define TONE_FREQ_HZ(w) ((((w) >> 20) & 0xFFF) * 10)
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
 
 static const char *TAG = "AUDIO";
 static esp_codec_dev_handle_t spk_codec_dev = NULL;
@@ -30,13 +61,6 @@ static esp_codec_dev_handle_t spk_codec_dev = NULL;
 /*******************************************************************************
  * Types definitions
  *******************************************************************************/
-typedef enum {
-	APP_FILE_TYPE_UNKNOWN,
-	APP_FILE_TYPE_TXT,
-	APP_FILE_TYPE_IMG,
-	APP_FILE_TYPE_WAV,
-} app_file_type_t;
-
 // Very simple WAV header, ignores most fields
 typedef struct __attribute__((packed)) {
 	uint8_t ignore_0[22];
@@ -49,90 +73,426 @@ typedef struct __attribute__((packed)) {
 	uint8_t data[];
 } dumb_wav_header_t;
 
+// PCM clip held in RAM: 16 bit mono at SAMPLE_RATE
+typedef struct {
+	const char *path;	// Optional WAV replacement on SPIFFS
+	int16_t *samples;
+	uint32_t count;
+} audio_clip_data_t;
+
+typedef struct {
+	audio_clip_t clip;
+	audio_priority_t priority;
+	int64_t trigger_us;
+} audio_cmd_t;
+
 /* Audio */
-static SemaphoreHandle_t audio_mux;
+static QueueHandle_t audio_queue = NULL;
+static StaticQueue_t audio_queue_buf;
+static uint8_t audio_queue_storage[QUEUE_DEPTH * sizeof(audio_cmd_t)];
+#if CONFIG_RADAR_STATIC_ALLOC
+static int16_t clip_pool[CONFIG_RADAR_STATIC_AUDIO_POOL_KB * 1024 / sizeof(int16_t)];
+static size_t clip_pool_used = 0;	// Samples handed out
+#endif
+static audio_clip_data_t clips[AUDIO_CLIP_COUNT] = {
+	[AUDIO_CLIP_NEAR] = {.path = "/spiffs/alert_near.wav"},
+	[AUDIO_CLIP_ZONE] = {.path = "/spiffs/alert_zone.wav"},
+};
+static audio_stats_t stats;		// Written by the audio task and senders, read from any task
+static int64_t latency_sum_us = 0;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
+/* Proximity tone */
+static _Atomic uint32_t tone_params = 0;
+#ifdef CONFIG_AUDIO_TONE
+static _Atomic bool tone_enabled = true;
+#else
+static _Atomic bool tone_enabled = false;
+#endif
+static int16_t sine_table[TONE_TABLE_SIZE];
+static int16_t tone_buf[CHUNK_SAMPLES];
 
-static void play_file(void *arg) {
-	char *path = arg;
-	FILE *file = NULL;
-	int16_t *wav_bytes = heap_caps_malloc(BUFFER_SIZE, MALLOC_CAP_DEFAULT);
-	if (wav_bytes == NULL) {
-		ESP_LOGE(TAG, "Not enough memory for playing!");
-		goto END;
+/**
+ * @brief Zeroed sample storage for a clip, from the static pool or the heap
+ */
+static int16_t *clip_alloc(size_t count) {
+#if CONFIG_RADAR_STATIC_ALLOC
+	if (count > sizeof(clip_pool) / sizeof(clip_pool[0]) - clip_pool_used) {
+		ESP_LOGW(TAG, "Clip pool full, raise the audio clip pool size");
+		return NULL;
 	}
+	int16_t *samples = clip_pool + clip_pool_used;
+	clip_pool_used += count;
+	memset(samples, 0, count * sizeof(int16_t));
+	return samples;
+#else
+	return heap_caps_calloc(count, sizeof(int16_t), MALLOC_CAP_DEFAULT);
+#endif
+}
+
+/**
+ * @brief Give back the storage of the clip allocated last
+ */
+static void clip_free(int16_t *samples) {
+#if CONFIG_RADAR_STATIC_ALLOC
+	clip_pool_used = samples - clip_pool;
+#else
+	free(samples);
+#endif
+}
 
-	/* Open file */
-	file = fopen(path, "rb");
+/**
+ * @brief Load a WAV file into RAM if it matches the output format
+ */
+static bool load_wav_clip(audio_clip_data_t *clip) {
+	FILE *file = fopen(clip->path, "rb");
 	if (file == NULL) {
-		ESP_LOGE(TAG, "%s file does not exist!", path);
-		goto END;
+		return false;
 	}
 
 	/* Read WAV header file */
 	dumb_wav_header_t wav_header;
-	if (fread((void *)&wav_header, 1, sizeof(wav_header), file) !=
-		sizeof(wav_header)) {
-		ESP_LOGW(TAG, "Error in reading file");
-		goto END;
+	bool ok = false;
+	if (fread((void *)&wav_header, 1, sizeof(wav_header), file) != sizeof(wav_header)) {
+		ESP_LOGW(TAG, "Error in reading %s", clip->path);
+	} else if (wav_header.num_channels != 1 || wav_header.bits_per_sample != 16 ||
+			   wav_header.sample_rate != SAMPLE_RATE ||
+			   wav_header.data_size > CLIP_MAX_BYTES) {
+		ESP_LOGW(TAG, "%s must be mono 16 bit %d Hz, at most %d bytes", clip->path,
+				 SAMPLE_RATE, CLIP_MAX_BYTES);
+	} else {
+		uint32_t count = wav_header.data_size / sizeof(int16_t);
+		clip->samples = clip_alloc(count);
+		if (clip->samples) {
+			clip->count = fread(clip->samples, sizeof(int16_t), count, file);
+			ok = clip->count > 0;
+		}
 	}
-	ESP_LOGI(TAG, "Number of channels: %" PRIu16 "", wav_header.num_channels);
-	ESP_LOGI(TAG, "Bits per sample: %" PRIu16 "", wav_header.bits_per_sample);
-	ESP_LOGI(TAG, "Sample rate: %" PRIu32 "", wav_header.sample_rate);
-	ESP_LOGI(TAG, "Data size: %" PRIu32 "", wav_header.data_size);
 
-	esp_codec_dev_sample_info_t fs = {
-		.sample_rate = wav_header.sample_rate,
-		.channel = wav_header.num_channels,
-		.bits_per_sample = wav_header.bits_per_sample,
-		.mclk_multiple = I2S_MCLK_MULTIPLE_384,
+	fclose(file);
+	if (!ok && clip->samples) {
+		clip_free(clip->samples);
+		clip->samples = NULL;
+		clip->count = 0;
+	}
+	return ok;
+}
+
+/**
+ * @brief Synthesize a tone sequence into a clip
+ *
+ * @param freq_start Frequency at the start of each beep (Hz)
+ * @param freq_end Frequency at the end of each beep (Hz), for chirps
+ * @param beep_ms Length of one beep
+ * @param gap_ms Silence after each beep
+ * @param beeps Number of beeps
+ */
+static bool synth_clip(audio_clip_data_t *clip, float freq_start, float freq_end,
+					   int beep_ms, int gap_ms, int beeps) {
+	uint32_t beep_len = SAMPLE_RATE * beep_ms / 1000;
+	uint32_t gap_len = SAMPLE_RATE * gap_ms / 1000;
+
+	clip->count = (beep_len + gap_len) * beeps;
+	clip->samples = clip_alloc(clip->count);
+	if (clip->samples == NULL) {
+		clip->count = 0;
+		return false;
+	}
+
+	for (int b = 0; b < beeps; b++) {
+		int16_t *out = clip->samples + b * (beep_len + gap_len);
+		float phase = 0.0f;
+		for (uint32_t i = 0; i < beep_len; i++) {
+			float freq = freq_start + (freq_end - freq_start) * i / beep_len;
+			// Short linear fade in/out avoids clicks
+			uint32_t edge = MIN(i, beep_len - 1 - i);
+			float envelope = edge < 64 ? edge / 64.0f : 1.0f;
+			phase += 2.0f * PI * freq / SAMPLE_RATE;
+			out[i] = (int16_t)(sinf(phase) * envelope * 12000.0f);
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Record the trigger to output latency of a clip whose first chunk was just written
+ *
+ * esp_codec_dev_write() returns once the chunk is in an I2S DMA buffer,
+ * so this includes any wait for the DMA to free one.
+ */
+static void note_latency(int64_t trigger_us) {
+	int64_t latency = esp_timer_get_time() - trigger_us;
+
+	portENTER_CRITICAL(&stats_lock);
+	stats.played++;
+	stats.last_latency_us = latency;
+	if (latency > stats.max_latency_us) {
+		stats.max_latency_us = latency;
+	}
+	latency_sum_us += latency;
+	stats.avg_latency_us = latency_sum_us / stats.played;
+	portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief Map the nearest target distance to beep timing and pitch
+ *
+ * Parking sensor style: closer is faster and higher, continuous below
+ * CONFIG_AUDIO_TONE_CONTINUOUS_MM, silent beyond CONFIG_AUDIO_TONE_MAX_MM.
+ *
+ * @param distance_mm Nearest target, or a negative value for none
+ */
+static void tone_set_distance(int32_t distance_mm) {
+	uint32_t word = 0;
+
+	if (tone_enabled && distance_mm >= 0 && distance_mm <= CONFIG_AUDIO_TONE_MAX_MM) {
+		int32_t span = CONFIG_AUDIO_TONE_MAX_MM - CONFIG_AUDIO_TONE_CONTINUOUS_MM;
+		int32_t frac = 0;	// 0 = closest, 1024 = farthest
+		if (distance_mm > CONFIG_AUDIO_TONE_CONTINUOUS_MM && span > 0) {
+			frac = (distance_mm - CONFIG_AUDIO_TONE_CONTINUOUS_MM) * 1024 / span;
+		}
+		uint32_t period_ms = TONE_PERIOD_MIN_MS + frac * (TONE_PERIOD_MAX_MS - TONE_PERIOD_MIN_MS) / 1024;
+		uint32_t on_ms = (frac == 0) ? period_ms : TONE_BEEP_MS;
+		uint32_t freq = TONE_FREQ_NEAR_HZ - frac * (TONE_FREQ_NEAR_HZ - TONE_FREQ_FAR_HZ) / 1024;
+		word = TONE_PACK(period_ms, on_ms, freq);
+	}
+
+	uint32_t previous = atomic_exchange_explicit(&tone_params, word, memory_order_relaxed);
+	if (previous == 0 && word != 0 && audio_queue) {
+		// Wake the idle service; later changes are picked up per chunk
+		audio_cmd_t wake = {.clip = AUDIO_CLIP_COUNT};
+		xQueueSend(audio_queue, &wake, 0);
+	}
+}
+
+/**
+ * @brief Synthesize one chunk of the proximity tone
+ *
+ * Parameters are read once per chunk, so a distance change is heard
+ * within CHUNK_SAMPLES. Phase and beep position carry across chunks.
+ */
+static void tone_fill(uint32_t word) {
+	static uint32_t phase = 0;		// Q32 position in the sine table
+	static uint32_t beep_pos = 0;	// Samples into the current beep period
+	uint32_t period = TONE_PERIOD_MS(word) * SAMPLE_RATE / 1000;
+	uint32_t on = TONE_ON_MS(word) * SAMPLE_RATE / 1000;
+	uint32_t step = (uint32_t)(((uint64_t)TONE_FREQ_HZ(word) << 32) / SAMPLE_RATE);
+
+	for (int i = 0; i < CHUNK_SAMPLES; i++) {
+		int32_t sample = 0;
+		if (beep_pos >= period) {
+			beep_pos = 0;
+		}
+		if (beep_pos < on) {
+#if CONFIG_AUDIO_TONE_SQUARE
+			sample = (phase & 0x80000000u) ? -TONE_AMPLITUDE : TONE_AMPLITUDE;
+#else
+			sample = sine_table[phase >> 24];
+#endif
+			// Ramp the beep edges to avoid clicks
+			uint32_t edge = (on == period) ? TONE_RAMP : MIN(beep_pos, on - 1 - beep_pos);
+			if (edge < TONE_RAMP) {
+				sample = sample * (int32_t)edge / TONE_RAMP;
+			}
+			phase += step;
+		}
+		tone_buf[i] = (int16_t)sample;
+		beep_pos++;
+	}
+}
+
+/**
+ * @brief Audio service task
+ *
+ * Owns the speaker codec and keeps the I2S DMA fed. Clips take precedence
+ * over the proximity tone. The task blocks on the command queue only when
+ * there is nothing to play; otherwise it polls the queue between chunks,
+ * so a higher priority clip takes over within one chunk.
+ */
+static void audio_task(void *arg) {
+	audio_cmd_t current = {0};
+	audio_cmd_t pending = {0};
+	audio_cmd_t cmd;
+	bool playing = false;
+	bool has_pending = false;
+	bool first_chunk = false;
+	uint32_t pos = 0;
+
+	while (1) {
+		uint32_t tone = atomic_load_explicit(&tone_params, memory_order_relaxed);
+		TickType_t wait = (playing || tone != 0) ? 0 : portMAX_DELAY;
+
+		if (xQueueReceive(audio_queue, &cmd, wait) == pdTRUE && cmd.clip < AUDIO_CLIP_COUNT) {
+			if (!playing || cmd.priority > current.priority) {
+				if (playing) {
+					// Pre-empt the playing clip
+					portENTER_CRITICAL(&stats_lock);
+					stats.preempted++;
+					portEXIT_CRITICAL(&stats_lock);
+				}
+				current = cmd;
+				playing = true;
+				first_chunk = true;
+				pos = 0;
+			} else if (cmd.clip != current.clip &&
+					   (!has_pending || cmd.priority > pending.priority)) {
+				// Play after the current clip
+				pending = cmd;
+				has_pending = true;
+			}
+		}
+
+		if (playing) {
+			audio_clip_data_t *clip = &clips[current.clip];
+			uint32_t count = MIN(CHUNK_SAMPLES, clip->count - pos);
+			if (count > 0) {
+				esp_codec_dev_write(spk_codec_dev, clip->samples + pos, count * sizeof(int16_t));
+				pos += count;
+			}
+			if (first_chunk) {
+				note_latency(current.trigger_us);
+				first_chunk = false;
+			}
+			if (pos >= clip->count) {
+				playing = has_pending;
+				if (has_pending) {
+					current = pending;
+					has_pending = false;
+					first_chunk = true;
+					pos = 0;
+				}
+			}
+		} else if (tone != 0) {
+			tone_fill(tone);
+			esp_codec_dev_write(spk_codec_dev, tone_buf, sizeof(tone_buf));
+		}
+	}
+}
+
+bool audio_play_clip(audio_clip_t clip, audio_priority_t priority, int64_t trigger_us) {
+	if (audio_queue == NULL || clip >= AUDIO_CLIP_COUNT || clips[clip].samples == NULL) {
+		return false;
+	}
+
+	audio_cmd_t cmd = {
+		.clip = clip,
+		.priority = priority,
+		.trigger_us = trigger_us,
 	};
-	esp_codec_dev_open(spk_codec_dev, &fs);
+	if (xQueueSend(audio_queue, &cmd, 0) != pdTRUE) {
+		portENTER_CRITICAL(&stats_lock);
+		stats.dropped++;
+		portEXIT_CRITICAL(&stats_lock);
+		return false;
+	}
+	return true;
+}
 
-	uint32_t bytes_send_to_i2s = 0;
+void audio_alert_update(const radar_frame_t *frame) {
+	int64_t frame_us = frame->timestamp_us;
+	int64_t nearest_sq = -1;
+	float nearest = -1.0f;
+	uint8_t zone = 0;
 
-    bytes_send_to_i2s = 0;
-    fseek(file, sizeof(wav_header), SEEK_SET);
-    while (bytes_send_to_i2s < wav_header.data_size) {
-        xSemaphoreTake(audio_mux, portMAX_DELAY);
+	for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+		const radar_point_t *t = &frame->targets[i];
+		if (!radar_frame_detected(frame, i)) {
+			continue;
+		}
+		// Compare squared distances; one square root for the nearest
+		int64_t dist_sq = (int64_t)t->x * t->x + (int64_t)t->y * t->y;
+		if (nearest_sq < 0 || dist_sq < nearest_sq) {
+			nearest_sq = dist_sq;
+		}
+#if CONFIG_AUDIO_ALERTS
+		if (t->x >= CONFIG_AUDIO_ALERT_ZONE_X_MIN_MM &&
+			t->x <= CONFIG_AUDIO_ALERT_ZONE_X_MAX_MM &&
+			t->y >= CONFIG_AUDIO_ALERT_ZONE_Y_MIN_MM &&
+			t->y <= CONFIG_AUDIO_ALERT_ZONE_Y_MAX_MM) {
+			zone |= 1 << i;
+		}
+#endif
+	}
+	if (nearest_sq >= 0) {
+		nearest = sqrtf((float)nearest_sq);
+	}
 
-        /* Get data from SPIFFS */
-        size_t bytes_read_from_spiffs =
-            fread(wav_bytes, 1, BUFFER_SIZE, file);
+	tone_set_distance((int32_t)nearest);
 
-        /* Send it to I2S */
-        esp_codec_dev_write(spk_codec_dev, wav_bytes,
-                            bytes_read_from_spiffs);
-        bytes_send_to_i2s += bytes_read_from_spiffs;
-        xSemaphoreGive(audio_mux);
-    }
-    vTaskDelay(pdMS_TO_TICKS(100));
+#if CONFIG_AUDIO_ALERTS
+	static bool near = false;
+	static uint8_t in_zone = 0;	// Bit per target slot
 
-END:
-	esp_codec_dev_close(spk_codec_dev);
+	if (!near && nearest >= 0.0f && nearest < CONFIG_AUDIO_ALERT_NEAR_MM) {
+		near = true;
+		audio_play_clip(AUDIO_CLIP_NEAR, AUDIO_PRIORITY_HIGH, frame_us);
+	} else if (near && (nearest < 0.0f ||
+						nearest > CONFIG_AUDIO_ALERT_NEAR_MM + CONFIG_AUDIO_ALERT_HYSTERESIS_MM)) {
+		near = false;
+	}
 
-	if (file) {
-		fclose(file);
+	if (zone & ~in_zone) {
+		audio_play_clip(AUDIO_CLIP_ZONE, AUDIO_PRIORITY_NORMAL, frame_us);
 	}
+	in_zone = zone;
+#endif
+}
 
-	if (wav_bytes) {
-		free(wav_bytes);
+void audio_tone_enable(bool enable) {
+	tone_enabled = enable;
+	if (!enable) {
+		tone_set_distance(-1);
 	}
+	ESP_LOGI(TAG, "Proximity tone %s", enable ? "enabled" : "disabled");
+}
 
-	vTaskDelete(NULL);
+bool audio_tone_is_enabled(void) {
+	return tone_enabled;
 }
-void play_wave_file(char *path) {
-	xTaskCreate(play_file, "audio_task", 4096, path, 6, NULL);
+
+void audio_get_stats(audio_stats_t *out) {
+	if (out) {
+		portENTER_CRITICAL(&stats_lock);
+		*out = stats;
+		portEXIT_CRITICAL(&stats_lock);
+	}
 }
 
 void app_audio_init(void) {
-	audio_mux = xSemaphoreCreateMutex();
-	assert(audio_mux);
-
 	/* Initialize speaker */
 	spk_codec_dev = bsp_audio_codec_speaker_init();
 	assert(spk_codec_dev);
 	/* Speaker output volume */
 	esp_codec_dev_set_out_vol(spk_codec_dev, DEFAULT_VOLUME);
 
+	/* Keep the codec open at one fixed format for the life of the service,
+	   so starting a clip is just a write */
+	esp_codec_dev_sample_info_t fs = {
+		.sample_rate = SAMPLE_RATE,
+		.channel = 1,
+		.bits_per_sample = 16,
+		.mclk_multiple = I2S_MCLK_MULTIPLE_384,
+	};
+	esp_codec_dev_open(spk_codec_dev, &fs);
+
+	/* One sine period for the proximity tone generator */
+	for (int i = 0; i < TONE_TABLE_SIZE; i++) {
+		sine_table[i] = (int16_t)(sinf(2.0f * PI * i / TONE_TABLE_SIZE) * TONE_AMPLITUDE);
+	}
+
+	/* Decode every clip once; fall back to built-in tones */
+	for (int i = 0; i < AUDIO_CLIP_COUNT; i++) {
+		if (load_wav_clip(&clips[i])) {
+			ESP_LOGI(TAG, "Loaded %s (%" PRIu32 " samples)", clips[i].path, clips[i].count);
+		} else if (i == AUDIO_CLIP_NEAR) {
+			synth_clip(&clips[i], 1600.0f, 1600.0f, 80, 60, 2);
+		} else {
+			synth_clip(&clips[i], 600.0f, 1200.0f, 150, 0, 1);
+		}
+	}
+
+	audio_queue = xQueueCreateStatic(QUEUE_DEPTH, sizeof(audio_cmd_t), audio_queue_storage,
+									 &audio_queue_buf);
+
+	RADAR_TASK_CREATE(audio_task, "Audio Service", CONFIG_RADAR_STACK_AUDIO, NULL, 9, 0);
 }
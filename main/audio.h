@@ -0,0 +1,98 @@
+/*
+ * audio.h
+ * Resident audio service: preloaded alert clips played from a command queue
+ * and a synthesized proximity tone
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Alert clips, loaded into RAM once by app_audio_init()
+typedef enum {
+    AUDIO_CLIP_NEAR,    // Person within the proximity distance
+    AUDIO_CLIP_ZONE,    // Person entered the alert zone
+    AUDIO_CLIP_COUNT
+} audio_clip_t;
+
+// A clip pre-empts a playing clip of lower priority
+typedef enum {
+    AUDIO_PRIORITY_LOW,
+    AUDIO_PRIORITY_NORMAL,
+    AUDIO_PRIORITY_HIGH,
+} audio_priority_t;
+
+// Playback counters and trigger-to-output latency
+typedef struct {
+    uint32_t played;        // Clips started
+    uint32_t preempted;     // Clips cut short by a higher priority clip
+    uint32_t dropped;       // Requests lost because the queue was full
+    int64_t last_latency_us;  // Trigger to first chunk written into an I2S DMA buffer
+    int64_t max_latency_us;
+    int64_t avg_latency_us;
+} audio_stats_t;
+
+/**
+ * @brief Start the audio service
+ *
+ * Opens the speaker codec once, loads the alert clips into RAM and starts
+ * the playback task. Call after bsp_spiffs_mount() so WAV clips in
+ * /spiffs can replace the built-in tones.
+ */
+void app_audio_init(void);
+
+/**
+ * @brief Queue a clip for playback
+ *
+ * Never blocks; a request is dropped if the queue is full.
+ *
+ * @param clip Clip to play
+ * @param priority Pre-emption priority
+ * @param trigger_us esp_timer time of the triggering event, for latency
+ * @return true if the request was queued
+ */
+bool audio_play_clip(audio_clip_t clip, audio_priority_t priority, int64_t trigger_us);
+
+/**
+ * @brief Evaluate the alert rules against a new radar frame
+ *
+ * Call from the radar task for every frame. Triggers AUDIO_CLIP_NEAR when
+ * the nearest person comes within CONFIG_AUDIO_ALERT_NEAR_MM and
+ * AUDIO_CLIP_ZONE when a person enters the configured zone. Also retunes
+ * the proximity tone to the nearest distance; the audio task picks up the
+ * change within one 256 sample buffer.
+ *
+ * @param frame Radar frame; timestamp_us is the trigger time for latency
+ */
+void audio_alert_update(const radar_frame_t *frame);
+
+/**
+ * @brief Switch the proximity tone on or off
+ *
+ * @param enable true to beep as people approach
+ */
+void audio_tone_enable(bool enable);
+
+/**
+ * @brief Whether the proximity tone is switched on
+ */
+bool audio_tone_is_enabled(void);
+
+/**
+ * @brief Copy the playback statistics
+ *
+ * Safe from any task.
+ *
+ * @param stats Filled with the statistics since boot
+ */
+void audio_get_stats(audio_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
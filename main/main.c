@@ -9,6 +9,7 @@
 #include "esp_log.h"
 #include "esp_lv_decoder.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "freertos/idf_additions.h"
@@ -17,6 +18,17 @@
 #include "lvgl.h"
 #include "nvs_flash.h"
 #include "protocol_examples_common.h"
+#include "audio.h"
+#include "radar_analytics.h"
+#include "radar_budget.h"
+#include "radar_history.h"
+#include "radar_mirror.h"
+#include "radar_mqtt.h"
+#include "radar_multi.h"
+#include "radar_refresh.h"
+#include "radar_web.h"
+#include "radar_bench.h"
+#include "radar_soak.h"
 #include "ui_radar_integration.h"
 #include <dirent.h>
 #include <esp_heap_caps.h>
@@ -26,6 +38,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 
 extern void	ui_skoona_page(lv_obj_t *scr);
 extern void start_mmwave(void *pvParameters);
@@ -34,7 +47,8 @@ bool logoDone = false; // control when radar screen is created
 static lv_display_t *g_disp = NULL;
 
 void logMemoryStats(char *message) {
-	char buffer[1024] = {0};
+	// Static so callers need no 1 KB of stack; used at boot and from the button callback
+	static char buffer[1024];
 
 	vTaskList(buffer);
 
@@ -43,8 +57,8 @@ void logMemoryStats(char *message) {
 			 esp_get_free_heap_size());
 	ESP_LOGI(TAG, "Internal free heap size: %ld bytes",
 			 esp_get_free_internal_heap_size());
-	ESP_LOGI(TAG, "PSRAM    free heap size: %ld bytes",
-			 esp_get_free_heap_size() - esp_get_free_internal_heap_size());
+	ESP_LOGI(TAG, "PSRAM    free heap size: %u bytes",
+			 (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 	ESP_LOGI(TAG, "Total    free heap size: %ld bytes",
 			 esp_get_free_heap_size());
 	ESP_LOGI(TAG,
@@ -59,6 +73,10 @@ void btn_handler(void *button_handle, void *usr_data) {
 	radar_btn_handler_example(button_handle, usr_data, g_disp);
 }
 
+void btn_long_handler(void *button_handle, void *usr_data) {
+	radar_btn_long_press_example(button_handle, usr_data, g_disp);
+}
+
 // serivce lvgl events time requirements
 uint32_t milliseconds() {
     int64_t v64 = esp_timer_get_time();
@@ -72,7 +90,13 @@ void app_main(void)
     esp_log_level_set("*", ESP_LOG_INFO);
     esp_log_level_set("transport", ESP_LOG_VERBOSE);
 
-    ESP_ERROR_CHECK(nvs_flash_init());
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // Partition full or written by a newer format; saved analytics are lost
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
@@ -86,9 +110,21 @@ void app_main(void)
 			.buff_spiram = false,
 	    },
 	};
+	cfg.lvgl_port_cfg.task_affinity = CONFIG_RADAR_LVGL_TASK_CORE;
+#if CONFIG_RADAR_LVGL_ON_DEMAND
+	cfg.lvgl_port_cfg.task_max_sleep_ms = CONFIG_RADAR_LVGL_MAX_SLEEP_MS;
+#endif
 	g_disp = bsp_display_start_with_config(&cfg);
+	lv_tick_set_cb(milliseconds);
+	radar_budget_add_task("taskLVGL", cfg.lvgl_port_cfg.task_stack, false);
 
 	ESP_ERROR_CHECK(example_connect());
+
+	/* Wall clock for the history log; syncs in the background */
+	setenv("TZ", CONFIG_RADAR_TIMEZONE, 1);
+	tzset();
+	esp_sntp_config_t sntp_cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_RADAR_SNTP_SERVER);
+	esp_netif_sntp_init(&sntp_cfg);
 	
     /* Set display brightness to 100% */
     // bsp_display_backlight_on();
@@ -96,10 +132,15 @@ void app_main(void)
     
     esp_lv_decoder_handle_t decoder_handle = NULL;
     esp_lv_decoder_init(&decoder_handle); //Initialize this after lvgl starts
-    lv_tick_set_cb(milliseconds);
 	
 	/* Mount SPIFFS */
 	bsp_spiffs_mount();
+
+	/* Index the flash history log before any view can query it */
+	radar_history_init();
+
+	/* Start the audio service; alert clips are loaded from SPIFFS */
+	app_audio_init();
 		
 	/* Initialize all available buttons */
 #define BUTTON_NUM 3
@@ -108,7 +149,10 @@ void app_main(void)
 
 	/* Register a callback for button press */
 	for (int i = 0; i < BUTTON_NUM; i++) {
-		iot_button_register_cb(btns[i], BUTTON_PRESS_DOWN, NULL, btn_handler, (void *) i);
+		// Every button also has a long press, so short presses are taken once
+		// a run of quick taps ends; the handler reads how many there were
+		iot_button_register_cb(btns[i], BUTTON_PRESS_REPEAT_DONE, NULL, btn_handler, (void *) i);
+		iot_button_register_cb(btns[i], BUTTON_LONG_PRESS_START, NULL, btn_long_handler, (void *) i);
 	}
 
 	// Show splash screen with Skoona logo animation
@@ -136,6 +180,32 @@ void app_main(void)
 	// Initialize radar display system (starts in SWEEP mode)
 	radar_display_init(g_disp, DISPLAY_MODE_SWEEP);
 
+#if CONFIG_RADAR_SOAK
+	radar_soak_start(g_disp);
+#elif CONFIG_RADAR_BENCH
+	radar_bench_start(g_disp);
+#else
+	radar_display_service_start();
+	radar_analytics_start();
+#if CONFIG_RADAR_WEB
+	radar_web_start();
+#endif
+#if CONFIG_RADAR_MQTT
+	radar_mqtt_start();
+#endif
+#if CONFIG_RADAR_MIRROR
+	radar_mirror_start(g_disp);
+#endif
+	radar_multi_start();
 	start_mmwave(NULL);
+#endif
 	logMemoryStats("App Main startup complete");
+	radar_budget_report("boot");
+
+#if CONFIG_RADAR_BUDGET_REPORT_S
+	// Stack peaks once the views, sensor and network have been busy a while
+	vTaskDelay(pdMS_TO_TICKS(CONFIG_RADAR_BUDGET_REPORT_S * 1000));
+	radar_budget_report("steady state");
+	radar_refresh_log_stats();
+#endif
 }
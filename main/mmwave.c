@@ -5,17 +5,24 @@
  * file: main.c
  */
 
+#include "audio.h"
 #include "bsp/esp-bsp.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/idf_additions.h"
 #include "freertos/projdefs.h"
 #include "freertos/task.h"
 #include "humanRadarRD_03D.h"
 #include "math.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_emulator.h"
+#include "radar_multi.h"
+#include "ui_radar_diag.h"
 #include "ui_radar_integration.h"
 #include "ui_radar_sweep.h"
 #include <math.h>
@@ -28,10 +35,10 @@
 extern bool logoDone;
 
 void vRadarTask(void *pvParameters) {
-    radar_sensor_t radar;
-	radar_target_t targets[RADAR_MAX_TARGETS];
-	radar_target_t priorTargets[RADAR_MAX_TARGETS] = {0};
-    char versionString[32] = {0};
+	// Sensor state lives for the life of the task; static keeps it off the stack
+	static radar_sensor_t radar;
+	static radar_frame_t frame;
+	static radar_target_t targets[RADAR_MAX_TARGETS];
 
 	// Initialize radar sensor
 	esp_err_t ret = radar_sensor_init(&radar, CONFIG_UART_PORT,
@@ -47,54 +54,48 @@ void vRadarTask(void *pvParameters) {
 		vTaskDelete(NULL);
 	}
 
+#if CONFIG_RADAR_EMULATOR
+	// Report frames come from the emulator through the UART loopback
+	radar_emulator_start(CONFIG_UART_PORT);
+#else
+    char versionString[32] = {0};
+
 	// Configure radar
 	radar_sensor_set_config_mode(&radar, true);	
         radar_sensor_set_retention_times(&radar, 10000, 500);
         radar_sensor_get_firmware_version(&radar, versionString);
         ESP_LOGI("Radar", "Radar Firmware Version: %s", versionString);
 	radar_sensor_set_config_mode(&radar, false);
+#endif
 
 	ESP_LOGI("Radar", "starting main loop.");
 
-	int target_count = 0;
-
 	while (1) {
 		if (radar_sensor_update(&radar)) {
-			// Save previous state
-			memcpy(priorTargets, targets, sizeof(targets));
+			frame.timestamp_us = esp_timer_get_time();
+			radar_diag_note_sensor_frame();
 
 			// Get current targets, target_count = highest index + 1, from 0
-			target_count = radar_sensor_get_targets(&radar, targets);
-
-			// Update each target
-            bool hasMoved = false;
-			for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
-				hasMoved = radar_sensor_hasTargetMoved(targets, priorTargets, idx);
-
-                // Update display
-                radar_update_current_display(targets, idx, hasMoved);
+			int target_count = radar_sensor_get_targets(&radar, targets);
+			radar_frame_pack(&frame, targets, target_count);
+			radar_frame_keep_text(&frame, targets);
 
-                if (hasMoved) {
-					ESP_LOGI("Radar", "[%d] X:%.0f Y:%.0f D:%.0f A:%.1f S:%.0f %s",
-								 idx, targets[idx].x, targets[idx].y,
-								 targets[idx].distance, targets[idx].angle,
-								 targets[idx].speed,
-								 targets[idx].position_description);
-				}
-			}
+			// Proximity and zone alerts first, they are latency critical
+			audio_alert_update(&frame);
 
-			// Update target count info (for sweep display)
-			if (radar_get_display_mode() == DISPLAY_MODE_SWEEP) {
-				bsp_display_lock(0);
-				radar_sweep_update_info(target_count);
-				bsp_display_unlock();
-			}
+#if CONFIG_RADAR_MULTI_COLLECTOR
+			// The bus carries the merged tracks; this sensor is one more unit
+			radar_multi_local_frame(&frame);
+#else
+			// Everything else (display, logging, ...) consumes the frame from the bus
+			radar_bus_publish(&frame);
+#endif
 		}
-		vTaskDelay(pdMS_TO_TICKS(110)); // 10hz refresh rate and device has space for 2 32bytes records
+		vTaskDelay(pdMS_TO_TICKS(CONFIG_RADAR_POLL_MS)); // 10hz refresh rate and device has space for 2 32bytes records
 	}
 }
 
 void start_mmwave(void *pvParameters)
 {
-	xTaskCreatePinnedToCore(vRadarTask, "Radar Service", 4096, pvParameters, 10, NULL, 1);
+	RADAR_TASK_CREATE(vRadarTask, "Radar Service", CONFIG_RADAR_STACK_RADAR, pvParameters, 10, 1);
 }
@@ -0,0 +1,373 @@
+/*
+ * radar_activity.c
+ * Coarse activity of each target (walking, standing, sitting, fall) from its trajectory
+ *
+ * The RD-03D reports a position in the floor plane and a radial Doppler
+ * speed. Each target keeps a short ring of per-frame samples and running
+ * sums over it: Doppler speed, heading change between steps, and a
+ * vertical proxy, the part of the Doppler speed that the change in range
+ * does not explain. Someone sitting down or falling moves fast without
+ * their floor position moving much, so the proxy peaks just before they
+ * become still. Stillness is timed against an anchor position rather
+ * than the previous frame, so a slow drift still counts as moving, and
+ * Doppler speed alone also ends it, so sitting down in place does too.
+ *
+ * The features go through a small decision tree with integer thresholds,
+ * stored as a table so a tree trained offline can replace it.
+ */
+
+#include "radar_activity.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#else
+#include <stdio.h>
+#define ESP_LOGI(tag, format, ...) printf("%s: " format "\n", tag, ##__VA_ARGS__)
+#endif
+
+static const char *TAG = "RadarActivity";
+
+#define STILL_MM            150         // Moving further from the anchor ends stillness
+#define STILL_SPEED         200         // mm/s, faster Doppler speed also ends it
+#define STEP_MM             40          // Shorter steps carry no usable heading
+#define SPEED_CLAMP         4000        // mm/s, keeps squared sums within 32 bits
+#define MIN_FRAMES          4           // Frames before the first label
+#define CONFIRM_FRAMES      3           // Frames a new label must win before it is shown
+#define DROP_DECAY_SHIFT    3           // drop_peak loses 1/8 per moving frame
+#define MIN_DT_MS           20
+#define MAX_DT_MS           1000
+
+// Features of one target over the last RADAR_ACTIVITY_WINDOW frames
+typedef struct {
+    uint16_t speed_mean;        // mm/s, mean |Doppler speed|
+    uint16_t speed_sd;          // mm/s, standard deviation of |Doppler speed|
+    uint16_t turn_mean;         // Mean heading change per frame, 1/1024 turn
+    uint16_t vert_mean;         // mm/s, mean Doppler speed not explained by range change
+    uint16_t drop_peak;         // mm/s, largest vertical proxy in the motion before this stillness
+    uint32_t still_ms;          // Time since the target last moved from where it stands
+} radar_activity_features_t;
+
+// Feature indices used by the decision tree
+enum {
+    F_SPEED_MEAN,
+    F_SPEED_SD,
+    F_TURN,
+    F_VERT,
+    F_DROP_PEAK,
+    F_STILL_MS,
+    F_COUNT
+};
+
+// Go left if feature <= threshold; children below zero are leaves
+typedef struct {
+    uint8_t feature;
+    int32_t threshold;
+    int8_t left;
+    int8_t right;
+} tree_node_t;
+
+#define LEAF(activity)      ((int8_t)(-1 - (activity)))
+
+static const tree_node_t tree[] = {
+    /* 0 */ {F_STILL_MS,   1200, 1, 2},                                    // Moved in the last 1.2 s?
+    /* 1 */ {F_SPEED_MEAN, 250,  LEAF(RADAR_ACTIVITY_STANDING), 3},
+    /* 2 */ {F_DROP_PEAK,  400,  LEAF(RADAR_ACTIVITY_STANDING), 4},       // Came down before keeping still?
+    /* 3 */ {F_TURN,       160,  LEAF(RADAR_ACTIVITY_WALKING), LEAF(RADAR_ACTIVITY_STANDING)},
+    /* 4 */ {F_DROP_PEAK,  1500, LEAF(RADAR_ACTIVITY_SITTING), LEAF(RADAR_ACTIVITY_FALL)},
+};
+
+typedef struct {
+    bool active;                // Tracking; false until the first detected frame
+    uint8_t head;               // Next ring slot to write
+    uint8_t fill;               // Valid ring slots
+    bool has_heading;
+    uint16_t heading;           // Heading of the last long enough step, 1/1024 turn
+    int16_t x;                  // Position in the previous frame
+    int16_t y;
+    int16_t step_x;             // Start of the step in progress
+    int16_t step_y;
+    int16_t anchor_x;           // Where the current stillness began
+    int16_t anchor_y;
+    uint16_t distance;          // mm, previous frame
+    int64_t last_us;
+    int64_t still_since_us;
+
+    uint16_t speed[RADAR_ACTIVITY_WINDOW];
+    uint16_t turn[RADAR_ACTIVITY_WINDOW];
+    uint16_t vert[RADAR_ACTIVITY_WINDOW];
+    uint32_t speed_sum;
+    uint32_t speed_sq_sum;
+    uint32_t turn_sum;
+    uint32_t vert_sum;
+    uint16_t drop_peak;
+
+    radar_activity_t candidate;
+    uint8_t candidate_frames;
+} activity_track_t;
+
+static activity_track_t tracks[RADAR_MAX_TARGETS];
+static volatile uint8_t labels[RADAR_MAX_TARGETS];      // radar_activity_t, read from any task
+
+/**
+ * @brief Integer square root
+ */
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Direction of a step without trigonometry, 1024 per turn
+ *
+ * Diamond angle: monotonic in the true angle and exact at multiples of
+ * 45 degrees, which is enough to compare headings.
+ */
+static uint16_t heading_of(int32_t dx, int32_t dy)
+{
+    int32_t ax = abs(dx);
+    int32_t ay = abs(dy);
+    int32_t sum = ax + ay;
+
+    if (dx >= 0 && dy >= 0) {
+        return (uint16_t)(ay * 256 / sum);
+    }
+    if (dx < 0 && dy >= 0) {
+        return (uint16_t)(256 + ax * 256 / sum);
+    }
+    if (dx < 0) {
+        return (uint16_t)(512 + ay * 256 / sum);
+    }
+    return (uint16_t)((768 + ax * 256 / sum) & 1023);
+}
+
+static inline uint16_t clamp_u16(int32_t v, int32_t max)
+{
+    return (uint16_t)(v < 0 ? 0 : (v > max ? max : v));
+}
+
+/**
+ * @brief Add one frame's samples to a target's window
+ */
+static void track_push(activity_track_t *t, uint16_t speed, uint16_t turn, uint16_t vert)
+{
+    uint8_t slot = t->head;
+
+    if (t->fill == RADAR_ACTIVITY_WINDOW) {
+        t->speed_sum -= t->speed[slot];
+        t->speed_sq_sum -= (uint32_t)t->speed[slot] * t->speed[slot];
+        t->turn_sum -= t->turn[slot];
+        t->vert_sum -= t->vert[slot];
+    } else {
+        t->fill++;
+    }
+    t->speed[slot] = speed;
+    t->turn[slot] = turn;
+    t->vert[slot] = vert;
+    t->speed_sum += speed;
+    t->speed_sq_sum += (uint32_t)speed * speed;
+    t->turn_sum += turn;
+    t->vert_sum += vert;
+    t->head = (slot + 1) % RADAR_ACTIVITY_WINDOW;
+}
+
+/**
+ * @brief Features of a target from its window sums
+ */
+static void track_features(const activity_track_t *t, int64_t now_us, radar_activity_features_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!t->active || t->fill == 0) {
+        return;
+    }
+
+    uint32_t mean = t->speed_sum / t->fill;
+    uint32_t mean_sq = t->speed_sq_sum / t->fill;
+    out->speed_mean = (uint16_t)mean;
+    out->speed_sd = (uint16_t)isqrt32(mean_sq > mean * mean ? mean_sq - mean * mean : 0);
+    out->turn_mean = (uint16_t)(t->turn_sum / t->fill);
+    out->vert_mean = (uint16_t)(t->vert_sum / t->fill);
+    out->drop_peak = t->drop_peak;
+    out->still_ms = (uint32_t)((now_us - t->still_since_us) / 1000);
+}
+
+/**
+ * @brief Walk the decision tree
+ */
+static radar_activity_t classify(const radar_activity_features_t *f)
+{
+    const int32_t values[F_COUNT] = {
+        [F_SPEED_MEAN] = f->speed_mean,
+        [F_SPEED_SD] = f->speed_sd,
+        [F_TURN] = f->turn_mean,
+        [F_VERT] = f->vert_mean,
+        [F_DROP_PEAK] = f->drop_peak,
+        [F_STILL_MS] = (int32_t)f->still_ms,
+    };
+    int node = 0;
+
+    while (node >= 0) {
+        const tree_node_t *n = &tree[node];
+        node = values[n->feature] <= n->threshold ? n->left : n->right;
+    }
+    return (radar_activity_t)(-1 - node);
+}
+
+/**
+ * @brief Start tracking a newly detected target
+ */
+static void track_begin(activity_track_t *t, const radar_point_t *point, uint16_t distance, int64_t now_us)
+{
+    memset(t, 0, sizeof(*t));
+    t->active = true;
+    t->x = t->step_x = t->anchor_x = point->x;
+    t->y = t->step_y = t->anchor_y = point->y;
+    t->distance = distance;
+    t->last_us = now_us;
+    t->still_since_us = now_us;
+}
+
+/**
+ * @brief Update one detected target
+ */
+static void track_update(activity_track_t *t, const radar_point_t *point, uint16_t distance, int64_t now_us)
+{
+    int32_t dt_ms = (int32_t)((now_us - t->last_us) / 1000);
+    if (dt_ms < MIN_DT_MS) {
+        dt_ms = MIN_DT_MS;
+    } else if (dt_ms > MAX_DT_MS) {
+        dt_ms = MAX_DT_MS;
+    }
+
+    // Vertical proxy: Doppler speed the range change does not account for
+    int32_t doppler = abs(point->speed);
+    int32_t range_rate = abs((int32_t)distance - t->distance) * 1000 / dt_ms;
+    uint16_t vert = clamp_u16(doppler - range_rate, SPEED_CLAMP);
+
+    // Heading change, only between steps long enough to have a direction
+    uint16_t turn = 0;
+    int32_t sx = point->x - t->step_x;
+    int32_t sy = point->y - t->step_y;
+    if (abs(sx) + abs(sy) >= STEP_MM) {
+        uint16_t heading = heading_of(sx, sy);
+        if (t->has_heading) {
+            turn = (heading - t->heading) & 1023;
+            if (turn > 512) {
+                turn = 1024 - turn;
+            }
+        }
+        t->heading = heading;
+        t->has_heading = true;
+        t->step_x = point->x;
+        t->step_y = point->y;
+    }
+
+    track_push(t, clamp_u16(doppler, SPEED_CLAMP), turn, vert);
+
+    // Stillness against an anchor; the drop peak fades with walking and is frozen while still
+    if (abs(point->x - t->anchor_x) > STILL_MM || abs(point->y - t->anchor_y) > STILL_MM) {
+        t->anchor_x = point->x;
+        t->anchor_y = point->y;
+        t->still_since_us = now_us;
+        t->drop_peak -= t->drop_peak >> DROP_DECAY_SHIFT;
+    } else if (doppler > STILL_SPEED) {
+        t->still_since_us = now_us;     // Moving in place, such as sitting down
+    }
+    if ((now_us - t->still_since_us) / 1000 < MAX_DT_MS && vert > t->drop_peak) {
+        t->drop_peak = vert;
+    }
+
+    t->x = point->x;
+    t->y = point->y;
+    t->distance = distance;
+    t->last_us = now_us;
+}
+
+/**
+ * @brief Feed one frame to the per-target feature windows and classify
+ */
+void radar_activity_update(const radar_frame_t *frame)
+{
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        activity_track_t *t = &tracks[idx];
+
+        if (!radar_frame_detected(frame, idx)) {
+            if (t->active) {
+                memset(t, 0, sizeof(*t));
+                labels[idx] = RADAR_ACTIVITY_NONE;
+            }
+            continue;
+        }
+
+        const radar_point_t *point = &frame->targets[idx];
+        uint16_t distance = (uint16_t)isqrt32((uint32_t)(point->x * point->x) +
+                                              (uint32_t)(point->y * point->y));
+        if (!t->active) {
+            track_begin(t, point, distance, frame->timestamp_us);
+            continue;
+        }
+        track_update(t, point, distance, frame->timestamp_us);
+        if (t->fill < MIN_FRAMES) {
+            continue;
+        }
+
+        radar_activity_features_t features;
+        track_features(t, frame->timestamp_us, &features);
+        radar_activity_t activity = classify(&features);
+
+        // Debounce: show a new label once it has won a few frames in a row
+        if (activity == labels[idx]) {
+            t->candidate_frames = 0;
+            continue;
+        }
+        if (activity != t->candidate) {
+            t->candidate = activity;
+            t->candidate_frames = 0;
+        }
+        if (++t->candidate_frames >= CONFIRM_FRAMES) {
+            labels[idx] = (uint8_t)activity;
+            t->candidate_frames = 0;
+            ESP_LOGI(TAG, "T%d %s (speed %u sd %u turn %u vert %u drop %u still %lu ms)", idx,
+                     radar_activity_name(activity), features.speed_mean, features.speed_sd,
+                     features.turn_mean, features.vert_mean, features.drop_peak,
+                     (unsigned long)features.still_ms);
+        }
+    }
+}
+
+/**
+ * @brief Current activity of a target
+ */
+radar_activity_t radar_activity_get(int idx)
+{
+    if (idx < 0 || idx >= RADAR_MAX_TARGETS) {
+        return RADAR_ACTIVITY_NONE;
+    }
+    return (radar_activity_t)labels[idx];
+}
+
+/**
+ * @brief Display name of an activity, "" for RADAR_ACTIVITY_NONE
+ */
+const char *radar_activity_name(radar_activity_t activity)
+{
+    static const char *names[RADAR_ACTIVITY_COUNT] = {"", "Walking", "Standing", "Sitting", "Fall"};
+
+    return activity < RADAR_ACTIVITY_COUNT ? names[activity] : "";
+}
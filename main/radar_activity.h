@@ -0,0 +1,52 @@
+/*
+ * radar_activity.h
+ * Coarse activity of each target (walking, standing, sitting, fall) from its trajectory
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_ACTIVITY_WINDOW   16      // Frames in the sliding feature window
+
+typedef enum {
+    RADAR_ACTIVITY_NONE = 0,            // No target, or not enough frames yet
+    RADAR_ACTIVITY_WALKING,
+    RADAR_ACTIVITY_STANDING,
+    RADAR_ACTIVITY_SITTING,
+    RADAR_ACTIVITY_FALL,
+    RADAR_ACTIVITY_COUNT
+} radar_activity_t;
+
+/**
+ * @brief Feed one frame to the per-target feature windows and classify
+ *
+ * O(1) per target with no allocation: window sums are updated by adding
+ * the new sample and subtracting the one it replaces. A target that is
+ * not detected is reset. Call for every frame, in order, from one task.
+ *
+ * @param frame Radar frame
+ */
+void radar_activity_update(const radar_frame_t *frame);
+
+/**
+ * @brief Current activity of a target
+ *
+ * A label changes only after the classifier agreed on it for a few
+ * frames. Safe from any task.
+ */
+radar_activity_t radar_activity_get(int idx);
+
+/**
+ * @brief Display name of an activity, "" for RADAR_ACTIVITY_NONE
+ */
+const char *radar_activity_name(radar_activity_t activity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,408 @@
+/*
+ * radar_analytics.c
+ * People counting, dwell time and hourly occupancy from the frame bus
+ *
+ * Every frame updates the aggregates in RAM. They are written to NVS as
+ * one blob, and only in batches: after CONFIG_RADAR_ANALYTICS_SAVE_S
+ * seconds, or sooner once CONFIG_RADAR_ANALYTICS_SAVE_EVENTS crossings
+ * and visits are unsaved. At 10 frames/s a write per event would wear
+ * the 16 KB nvs partition out in months and stall the flash cache on
+ * both cores each time; batching bounds what a power cut can lose.
+ */
+
+#include "radar_analytics.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_history.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "RadarAnalytics";
+
+#define NVS_NAMESPACE       "analytics"
+#define NVS_KEY             "totals_v1"     // Rename when radar_analytics_t changes
+#define MAX_GAP_US          1000000         // Longest frame gap counted as occupied time
+
+// One visit per sensor target slot
+typedef struct {
+    bool present;               // Visit in progress
+    int8_t side;                // -1 near the sensor, +1 beyond the line, 0 not yet known
+    int64_t first_us;           // Visit start
+    int64_t last_us;            // Last frame the target was detected in
+} analytics_track_t;
+
+static radar_analytics_t totals;
+static analytics_track_t tracks[RADAR_MAX_TARGETS];
+static uint8_t present_now = 0;
+static portMUX_TYPE totals_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Analytics task only
+static int64_t last_frame_us = 0;
+static uint32_t occupied_ms = 0;
+static uint32_t boot_hour = 0;
+static bool dirty = false;
+static uint32_t unsaved_events = 0;
+static int64_t last_save_us = 0;
+static uint32_t save_count = 0;
+static bool started = false;
+
+/**
+ * @brief Current hour number
+ *
+ * Wall clock hours once the clock is set; until then the hours since
+ * boot, continuing from the last saved hour.
+ */
+static uint32_t analytics_hour(void)
+{
+    time_t now = time(NULL);
+
+    if (now >= RADAR_CLOCK_VALID_EPOCH) {
+        return (uint32_t)(now / 3600);
+    }
+    return boot_hour + (uint32_t)(esp_timer_get_time() / 3600000000LL);
+}
+
+/**
+ * @brief Move the newest occupancy bucket to hour, clearing the hours skipped
+ *
+ * Call with totals_lock held.
+ */
+static void roll_hour(uint32_t hour)
+{
+    if (hour == totals.hour) {
+        return;
+    }
+    if (hour < totals.hour || hour - totals.hour >= RADAR_ANALYTICS_HOURS) {
+        // Clock stepped, nothing in the buckets belongs to the last day
+        memset(totals.occupied_s, 0, sizeof(totals.occupied_s));
+        memset(totals.peak, 0, sizeof(totals.peak));
+    } else {
+        for (uint32_t h = totals.hour + 1; h <= hour; h++) {
+            totals.occupied_s[h % RADAR_ANALYTICS_HOURS] = 0;
+            totals.peak[h % RADAR_ANALYTICS_HOURS] = 0;
+        }
+    }
+    totals.hour = hour;
+}
+
+/**
+ * @brief Close a visit and add its dwell time
+ *
+ * Call with totals_lock held.
+ */
+static void end_visit(analytics_track_t *track)
+{
+    uint32_t dwell_s = (uint32_t)((track->last_us - track->first_us) / 1000000);
+
+    totals.visits++;
+    totals.dwell_total_s += dwell_s;
+    totals.dwell_last_s = dwell_s;
+    if (dwell_s > totals.dwell_max_s) {
+        totals.dwell_max_s = dwell_s;
+    }
+    track->present = false;
+    track->side = 0;
+}
+
+/**
+ * @brief Close visits whose target has been gone longer than the grace time
+ *
+ * The sensor loses people for a frame or two, so a visit only ends after
+ * CONFIG_RADAR_ANALYTICS_LOST_MS without a detection.
+ */
+static void analytics_expire(int64_t now_us)
+{
+    uint8_t present = 0;
+    int ended = 0;
+
+    portENTER_CRITICAL(&totals_lock);
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        analytics_track_t *track = &tracks[idx];
+        if (track->present &&
+            now_us - track->last_us > (int64_t)CONFIG_RADAR_ANALYTICS_LOST_MS * 1000) {
+            end_visit(track);
+            unsaved_events++;
+            dirty = true;
+            ended++;
+        }
+        present += track->present;
+    }
+    present_now = present;
+    portEXIT_CRITICAL(&totals_lock);
+
+    // History may write flash, so never from inside the critical section
+    while (ended-- > 0) {
+        radar_history_note_event(RADAR_HISTORY_VISIT);
+    }
+}
+
+/**
+ * @brief Which side of the counting line a target is on
+ *
+ * @return -1 near the sensor, +1 beyond the line, 0 inside the hysteresis band
+ */
+static int8_t line_side(int16_t y)
+{
+    if (y < CONFIG_RADAR_ANALYTICS_LINE_Y_MM - CONFIG_RADAR_ANALYTICS_LINE_HYST_MM) {
+        return -1;
+    }
+    if (y > CONFIG_RADAR_ANALYTICS_LINE_Y_MM + CONFIG_RADAR_ANALYTICS_LINE_HYST_MM) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Update crossings, visits and occupancy from one frame
+ */
+static void analytics_frame(const radar_frame_t *frame)
+{
+    int64_t now = frame->timestamp_us;
+    int64_t gap = last_frame_us ? now - last_frame_us : 0;
+    uint32_t hour = analytics_hour();
+    uint8_t detected = 0;
+    uint8_t entries = 0;
+    uint8_t exits = 0;
+
+    last_frame_us = now;
+    if (gap < 0 || gap > MAX_GAP_US) {
+        gap = 0;
+    }
+
+    portENTER_CRITICAL(&totals_lock);
+    roll_hour(hour);
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        analytics_track_t *track = &tracks[idx];
+
+        if (!radar_frame_detected(frame, idx)) {
+            continue;
+        }
+        detected++;
+        if (!track->present) {
+            track->present = true;
+            track->side = 0;
+            track->first_us = now;
+        }
+        track->last_us = now;
+
+        int8_t side = line_side(frame->targets[idx].y);
+        if (side == 0) {
+            continue;
+        }
+        if (track->side != 0 && side != track->side) {
+#if CONFIG_RADAR_ANALYTICS_ENTRY_TOWARDS_SENSOR
+            bool inwards = side < 0;
+#else
+            bool inwards = side > 0;
+#endif
+            if (inwards) {
+                totals.entries++;
+                entries++;
+            } else {
+                totals.exits++;
+                exits++;
+            }
+            unsaved_events++;
+            dirty = true;
+        }
+        track->side = side;
+    }
+
+    // Occupancy: whole seconds with anyone detected, and the peak count
+    uint32_t bucket = hour % RADAR_ANALYTICS_HOURS;
+    if (detected) {
+        occupied_ms += (uint32_t)(gap / 1000);
+        if (occupied_ms >= 1000) {
+            uint32_t seconds = totals.occupied_s[bucket] + occupied_ms / 1000;
+            totals.occupied_s[bucket] = seconds > 3600 ? 3600 : seconds;
+            occupied_ms %= 1000;
+            dirty = true;
+        }
+    }
+    if (detected > totals.peak[bucket]) {
+        totals.peak[bucket] = detected;
+        dirty = true;
+    }
+    portEXIT_CRITICAL(&totals_lock);
+
+    radar_history_note_frame(frame, detected, (uint32_t)(gap / 1000));
+    while (entries-- > 0) {
+        radar_history_note_event(RADAR_HISTORY_ENTRY);
+    }
+    while (exits-- > 0) {
+        radar_history_note_event(RADAR_HISTORY_EXIT);
+    }
+}
+
+/**
+ * @brief Write the aggregates to NVS
+ */
+static void analytics_write(void)
+{
+    radar_analytics_t copy;
+    nvs_handle_t nvs;
+
+    portENTER_CRITICAL(&totals_lock);
+    copy = totals;
+    dirty = false;
+    unsaved_events = 0;
+    portEXIT_CRITICAL(&totals_lock);
+    last_save_us = esp_timer_get_time();
+
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, NVS_KEY, &copy, sizeof(copy));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Saving aggregates failed: %s", esp_err_to_name(err));
+        return;
+    }
+    save_count++;
+    ESP_LOGD(TAG, "Saved aggregates (%" PRIu32 " saves since boot)", save_count);
+}
+
+/**
+ * @brief Save when the batch is due
+ */
+static void analytics_flush(void)
+{
+    if (!dirty) {
+        return;
+    }
+    if (unsaved_events < CONFIG_RADAR_ANALYTICS_SAVE_EVENTS &&
+        esp_timer_get_time() - last_save_us < (int64_t)CONFIG_RADAR_ANALYTICS_SAVE_S * 1000000) {
+        return;
+    }
+    analytics_write();
+}
+
+/**
+ * @brief Restore the aggregates saved before the last reboot
+ */
+static void analytics_load(void)
+{
+    nvs_handle_t nvs;
+    size_t size = sizeof(totals);
+
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_get_blob(nvs, NVS_KEY, &totals, &size);
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK || size != sizeof(totals)) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "No usable saved aggregates (%s), starting from zero",
+                     esp_err_to_name(err));
+        }
+        memset(&totals, 0, sizeof(totals));
+    }
+    boot_hour = totals.hour;
+
+    ESP_LOGI(TAG, "Restored: in %" PRIu32 " out %" PRIu32 " visits %" PRIu32
+             " dwell max %" PRIu32 " s",
+             totals.entries, totals.exits, totals.visits, totals.dwell_max_s);
+}
+
+/**
+ * @brief Analytics task
+ */
+static void analytics_task(void *pvParameters)
+{
+    radar_bus_sub_t *sub = radar_bus_subscribe("analytics", RADAR_BUS_DROP_OLDEST, 4, 1);
+
+    if (sub == NULL) {
+        vTaskDelete(NULL);
+    }
+
+    while (1) {
+        // Wake at least once a second so visits end and batches save without frames
+        const radar_frame_t *frame = radar_bus_receive(sub, pdMS_TO_TICKS(1000));
+        if (frame) {
+            analytics_frame(frame);
+            radar_bus_release(sub, frame);
+        }
+        analytics_expire(esp_timer_get_time());
+        analytics_flush();
+        radar_history_tick();
+    }
+}
+
+/**
+ * @brief Restore the saved aggregates and start the analytics task
+ */
+void radar_analytics_start(void)
+{
+    if (started) {
+        return;
+    }
+    started = true;
+
+    analytics_load();
+    last_save_us = esp_timer_get_time();
+    // Every software restart, OTA included, goes through esp_restart()
+    esp_err_t err = esp_register_shutdown_handler(radar_analytics_save);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No shutdown handler, a restart loses unsaved data: %s", esp_err_to_name(err));
+    }
+    RADAR_TASK_CREATE(analytics_task, "Analytics", CONFIG_RADAR_STACK_ANALYTICS, NULL, 4, 0);
+}
+
+/**
+ * @brief Copy the current aggregates
+ */
+void radar_analytics_get(radar_analytics_t *out, uint8_t *present)
+{
+    portENTER_CRITICAL(&totals_lock);
+    *out = totals;
+    if (present) {
+        *present = present_now;
+    }
+    portEXIT_CRITICAL(&totals_lock);
+}
+
+/**
+ * @brief Save unsaved aggregates now
+ */
+void radar_analytics_save(void)
+{
+    if (started && dirty) {
+        analytics_write();
+    }
+    radar_history_flush();
+}
+
+/**
+ * @brief Clear all aggregates, in RAM and in NVS
+ */
+void radar_analytics_reset(void)
+{
+    nvs_handle_t nvs;
+
+    portENTER_CRITICAL(&totals_lock);
+    uint32_t hour = totals.hour;
+    memset(&totals, 0, sizeof(totals));
+    totals.hour = hour;
+    dirty = false;
+    unsaved_events = 0;
+    portEXIT_CRITICAL(&totals_lock);
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        nvs_erase_key(nvs, NVS_KEY);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    ESP_LOGI(TAG, "Aggregates cleared");
+}
@@ -0,0 +1,68 @@
+/*
+ * radar_analytics.h
+ * People counting, dwell time and hourly occupancy from the frame bus
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_ANALYTICS_HOURS   24
+
+// Aggregates kept in RAM and saved to NVS; layout is the stored format
+typedef struct {
+    uint32_t entries;           // Crossings of the counting line inwards
+    uint32_t exits;             // Crossings of the counting line outwards
+    uint32_t visits;            // Completed visits
+    uint32_t dwell_total_s;     // Sum of completed visit durations
+    uint32_t dwell_max_s;       // Longest completed visit
+    uint32_t dwell_last_s;      // Most recent completed visit
+    uint32_t hour;              // Hour number of the newest occupancy bucket
+    uint16_t occupied_s[RADAR_ANALYTICS_HOURS];    // Seconds with anyone present, by hour % 24
+    uint8_t peak[RADAR_ANALYTICS_HOURS];           // Most people at once, by hour % 24
+} radar_analytics_t;
+
+/**
+ * @brief Restore the saved aggregates and start the analytics task
+ *
+ * Subscribes to the radar frame bus without blocking the radar task.
+ * Counters are updated in RAM for every frame and saved to NVS every
+ * CONFIG_RADAR_ANALYTICS_SAVE_S seconds, or sooner after
+ * CONFIG_RADAR_ANALYTICS_SAVE_EVENTS unsaved crossings and visits.
+ * Registers radar_analytics_save() as a shutdown handler, so
+ * esp_restart() from any path, OTA included, saves first.
+ * Call after nvs_flash_init() and before start_mmwave().
+ */
+void radar_analytics_start(void);
+
+/**
+ * @brief Copy the current aggregates
+ *
+ * Safe from any task, including the LVGL task.
+ *
+ * @param out Copy of the aggregates
+ * @param present Number of people currently tracked, or NULL
+ */
+void radar_analytics_get(radar_analytics_t *out, uint8_t *present);
+
+/**
+ * @brief Save unsaved aggregates now
+ *
+ * Also writes the history minutes still in RAM. Runs from esp_restart()
+ * on its own; does nothing to the aggregates if nothing changed.
+ */
+void radar_analytics_save(void);
+
+/**
+ * @brief Clear all aggregates, in RAM and in NVS
+ */
+void radar_analytics_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
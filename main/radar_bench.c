@@ -0,0 +1,547 @@
+/*
+ * radar_bench.c
+ * On-device render benchmark for the radar views, replaces the radar task
+ * when CONFIG_RADAR_BENCH is set
+ *
+ * Golden images live in the repository under spiffs/golden/ and are
+ * flashed with the storage image, so every checkout checks against the
+ * same pictures. Recording writes them to SPIFFS and also logs them as
+ * hex; tools/golden_pull.py turns a monitor log back into the files to
+ * commit. A checkpoint without a golden image is reported as unchecked
+ * rather than failed, so a checkout without recorded images still gets
+ * its timings and a result from the checks it can make.
+ */
+
+#include "radar_bench.h"
+#include "bsp/esp-bsp.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "humanRadarRD_03D.h"
+#include "radar_budget.h"
+#include "sdkconfig.h"
+#include "ui_radar_integration.h"
+#include "ui_radar_sweep.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_RADAR_BENCH
+
+static const char *TAG = "RadarBench";
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define SCREEN_W        320
+#define SCREEN_H        240
+#define THUMB_SCALE     4                       // Thumbnail keeps every 4th pixel
+#define THUMB_W         (SCREEN_W / THUMB_SCALE)
+#define THUMB_H         (SCREEN_H / THUMB_SCALE)
+#define CHECKPOINTS     4                       // Golden image checks per view
+#define BENCH_VIEWS     2                       // List and sweep
+#define FRAME_MS        100                     // Scripted sensor frame period
+#define FULL_REDRAWS    20                      // Full-screen redraws timed per view
+#define GOLDEN_HEX_ROW  64                      // Thumbnail bytes per logged hex line
+#define BENCH_SCRIPT_FRAMES 64                  // Frames worked out ahead for the representation bench
+
+#if CONFIG_LV_OS_FREERTOS
+#define DRAW_THREADS    "FreeRTOS draw threads"
+#else
+#define DRAW_THREADS    "no OS, LVGL task draws"
+#endif
+
+// Render statistics for one phase, updated from display events
+typedef struct {
+    uint32_t refreshes;         // Refreshes that rendered something
+    int64_t render_us_total;
+    int64_t render_us_max;
+    uint64_t invalidated_px;    // Sum of requested invalidation areas
+} bench_stats_t;
+
+static lv_display_t *bench_disp = NULL;
+static bench_stats_t stats;
+static int64_t render_start_us = 0;
+static bool capture = false;
+static radar_frame_t bench_frame;
+static radar_frame_t bench_prior;
+
+// Thumbnail of the last full refresh, and the golden image it is checked against
+static uint16_t thumb[THUMB_H][THUMB_W];
+static uint16_t golden[THUMB_H][THUMB_W];
+static int golden_missing = 0;      // Checkpoints with no golden image to compare
+
+/**
+ * @brief Display event tap: render time, invalidated area and flushed pixels
+ */
+static void bench_display_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_RENDER_START:
+        render_start_us = esp_timer_get_time();
+        break;
+    case LV_EVENT_RENDER_READY: {
+        int64_t us = esp_timer_get_time() - render_start_us;
+        stats.refreshes++;
+        stats.render_us_total += us;
+        if (us > stats.render_us_max) {
+            stats.render_us_max = us;
+        }
+        break;
+    }
+    case LV_EVENT_INVALIDATE_AREA: {
+        const lv_area_t *area = lv_event_get_param(e);
+        stats.invalidated_px += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+        break;
+    }
+    case LV_EVENT_FLUSH_START: {
+        if (!capture) {
+            break;
+        }
+        // The flushed pixels are the active draw buffer, RGB565, one row per stride
+        const lv_area_t *area = lv_event_get_param(e);
+        const uint8_t *px_map = lv_display_get_buf_active(bench_disp)->data;
+        uint32_t stride = lv_draw_buf_width_to_stride(lv_area_get_width(area), LV_COLOR_FORMAT_RGB565);
+        int32_t x_first = (area->x1 + THUMB_SCALE - 1) / THUMB_SCALE * THUMB_SCALE;
+        for (int32_t y = area->y1; y <= area->y2 && y < SCREEN_H; y++) {
+            if (y % THUMB_SCALE) {
+                continue;
+            }
+            const uint16_t *row = (const uint16_t *)(px_map + (y - area->y1) * stride);
+            for (int32_t x = x_first; x <= area->x2 && x < SCREEN_W; x += THUMB_SCALE) {
+                thumb[y / THUMB_SCALE][x / THUMB_SCALE] = row[x - area->x1];
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Scripted target positions for a frame
+ *
+ * Three people walking arcs at different ranges; target 2 appears for the
+ * middle half of the script, so loss and re-detection are covered.
+ */
+static void bench_script_frame(int frame, radar_target_t *targets)
+{
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        radar_target_t *t = &targets[i];
+        float range = 1500.0f + 1500.0f * i + 600.0f * sinf(frame * 0.05f + i);
+        float angle = 45.0f * sinf(frame * 0.03f + i * 2.0f);
+
+        t->detected = (i != 2) ||
+                      (frame >= CONFIG_RADAR_BENCH_FRAMES / 4 && frame < 3 * CONFIG_RADAR_BENCH_FRAMES / 4);
+        t->x = roundf(range * sinf(angle * PI / 180.0f));
+        t->y = roundf(range * cosf(angle * PI / 180.0f));
+        t->distance = range;
+        t->angle = angle;
+        t->speed = roundf(300.0f * cosf(frame * 0.05f + i));
+        snprintf(t->position_description, sizeof(t->position_description),
+                 "Bench %d %s", i, angle < 0 ? "left" : "right");
+    }
+}
+
+/**
+ * @brief Feed one scripted frame through the same path as the radar task
+ */
+static void bench_feed_frame(int frame, radar_target_t *targets)
+{
+    int target_count = 0;
+
+    bench_prior = bench_frame;
+    bench_script_frame(frame, targets);
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        if (targets[idx].detected) {
+            target_count = idx + 1;
+        }
+    }
+    radar_frame_pack(&bench_frame, targets, target_count);
+    bench_frame.timestamp_us = esp_timer_get_time();
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        radar_update_current_display(&bench_frame, idx,
+                                     radar_frame_target_moved(&bench_frame, &bench_prior, idx));
+    }
+
+    if (radar_get_display_mode() == DISPLAY_MODE_SWEEP) {
+        bsp_display_lock(0);
+        radar_sweep_update_info(target_count);
+        bsp_display_unlock();
+    }
+}
+
+/**
+ * @brief Recreate the active view so every phase starts from the same state
+ */
+static void bench_reset_view(radar_target_t *targets)
+{
+    radar_set_display_mode(bench_disp, radar_get_display_mode());
+    memset(targets, 0, sizeof(radar_target_t) * RADAR_MAX_TARGETS);
+    vTaskDelay(pdMS_TO_TICKS(FRAME_MS));
+}
+
+/**
+ * @brief Redraw the whole screen and capture it into thumb[]
+ */
+static void bench_capture(void)
+{
+    bsp_display_lock(0);
+    lv_obj_invalidate(lv_display_get_screen_active(bench_disp));
+    capture = true;
+    lv_refr_now(bench_disp);
+    capture = false;
+    bsp_display_unlock();
+}
+
+/**
+ * @brief Time full-screen redraws of the active view
+ *
+ * Every object drawn into every band of the draw buffer, as after a mode
+ * switch. The sweep animation is stopped so only the redraws are counted.
+ */
+static void bench_full_redraw(const char *view)
+{
+    bool sweep = radar_get_display_mode() == DISPLAY_MODE_SWEEP;
+    int64_t wall_total = 0;
+    int64_t wall_max = 0;
+
+    bsp_display_lock(0);
+    if (sweep) {
+        radar_sweep_stop_animation();
+    }
+    lv_refr_now(bench_disp);
+    memset(&stats, 0, sizeof(stats));
+    bsp_display_unlock();
+
+    for (int n = 0; n < FULL_REDRAWS; n++) {
+        bsp_display_lock(0);
+        int64_t start = esp_timer_get_time();
+        lv_obj_invalidate(lv_display_get_screen_active(bench_disp));
+        lv_refr_now(bench_disp);
+        int64_t us = esp_timer_get_time() - start;
+        bsp_display_unlock();
+
+        wall_total += us;
+        if (us > wall_max) {
+            wall_max = us;
+        }
+        vTaskDelay(1);
+    }
+
+    bsp_display_lock(0);
+    bench_stats_t result = stats;
+    if (sweep) {
+        radar_sweep_start_animation();
+    }
+    bsp_display_unlock();
+
+    // Render time stops at the last band drawn; the redraw also waits for its flush
+    ESP_LOGI(TAG, "%s full redraw: render avg %d us max %d us, with flush avg %d us max %d us",
+             view,
+             result.refreshes ? (int)(result.render_us_total / result.refreshes) : 0,
+             (int)result.render_us_max, (int)(wall_total / FULL_REDRAWS), (int)wall_max);
+}
+
+/**
+ * @brief Switch view and time it up to the first complete frame
+ */
+static void bench_switch_mode(display_mode_t mode, const char *view)
+{
+    int64_t start = esp_timer_get_time();
+
+    radar_set_display_mode(bench_disp, mode);
+    bsp_display_lock(0);
+    lv_refr_now(bench_disp);
+    bsp_display_unlock();
+
+    ESP_LOGI(TAG, "Switch to %s: %d us to first frame", view, (int)(esp_timer_get_time() - start));
+}
+
+#if CONFIG_RADAR_BENCH_RECORD_GOLDEN
+/**
+ * @brief Log thumb[] as hex lines for tools/golden_pull.py
+ *
+ * "GOLDEN <name> <offset> <hex>", then "GOLDEN <name> end <length>".
+ */
+static void bench_log_golden(const char *name)
+{
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t *bytes = (const uint8_t *)thumb;
+    char hex[GOLDEN_HEX_ROW * 2 + 1];
+
+    for (size_t offset = 0; offset < sizeof(thumb); offset += GOLDEN_HEX_ROW) {
+        size_t n = sizeof(thumb) - offset < GOLDEN_HEX_ROW ? sizeof(thumb) - offset : GOLDEN_HEX_ROW;
+        for (size_t i = 0; i < n; i++) {
+            hex[2 * i] = digits[bytes[offset + i] >> 4];
+            hex[2 * i + 1] = digits[bytes[offset + i] & 0xF];
+        }
+        hex[2 * n] = 0;
+        ESP_LOGI(TAG, "GOLDEN %s %u %s", name, (unsigned)offset, hex);
+    }
+    ESP_LOGI(TAG, "GOLDEN %s end %u", name, (unsigned)sizeof(thumb));
+}
+#endif
+
+/**
+ * @brief Record thumb[] as a golden image, or compare it with the recorded one
+ *
+ * Images are named by view, script length and checkpoint, since the
+ * checkpoints fall on different frames for another script length.
+ *
+ * @return false if the images differ by more than the tolerance; a
+ *         missing golden image is counted in golden_missing, not failed
+ */
+static bool bench_check_golden(const char *view, int checkpoint)
+{
+    char name[32];
+    char path[64];
+    FILE *f;
+
+    snprintf(name, sizeof(name), "%s_%d_%d", view, CONFIG_RADAR_BENCH_FRAMES, checkpoint);
+    snprintf(path, sizeof(path), CONFIG_BSP_SPIFFS_MOUNT_POINT "/golden/%s.bin", name);
+
+#if CONFIG_RADAR_BENCH_RECORD_GOLDEN
+    f = fopen(path, "wb");
+    if (f == NULL || fwrite(thumb, sizeof(thumb), 1, f) != 1) {
+        ESP_LOGE(TAG, "Failed to record %s", path);
+        if (f) {
+            fclose(f);
+        }
+        return false;
+    }
+    fclose(f);
+    ESP_LOGI(TAG, "Recorded %s", path);
+    bench_log_golden(name);
+    return true;
+#else
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "No golden image %s, not checked; record one and commit it under spiffs/golden/", path);
+        golden_missing++;
+        return true;
+    }
+    size_t read = fread(golden, sizeof(golden), 1, f);
+    fclose(f);
+    if (read != 1) {
+        ESP_LOGE(TAG, "Golden image %s is truncated", path);
+        return false;
+    }
+
+    // Count pixels where any RGB565 channel differs by more than the tolerance
+    uint32_t mismatched = 0;
+    for (int y = 0; y < THUMB_H; y++) {
+        for (int x = 0; x < THUMB_W; x++) {
+            uint16_t a = thumb[y][x];
+            uint16_t b = golden[y][x];
+            if (abs((a >> 11) - (b >> 11)) > CONFIG_RADAR_BENCH_GOLDEN_TOLERANCE ||
+                abs(((a >> 5) & 0x3F) - ((b >> 5) & 0x3F)) > CONFIG_RADAR_BENCH_GOLDEN_TOLERANCE ||
+                abs((a & 0x1F) - (b & 0x1F)) > CONFIG_RADAR_BENCH_GOLDEN_TOLERANCE) {
+                mismatched++;
+            }
+        }
+    }
+
+    bool ok = mismatched <= CONFIG_RADAR_BENCH_GOLDEN_MAX_PIXELS;
+    ESP_LOGI(TAG, "%s checkpoint %d: %u of %d pixels differ, %s",
+             view, checkpoint, (unsigned)mismatched, THUMB_W * THUMB_H, ok ? "match" : "MISMATCH");
+    return ok;
+#endif
+}
+
+/**
+ * @brief Benchmark and check the active view
+ *
+ * @return false if any golden image check failed
+ */
+static bool bench_view(const char *view, radar_target_t *targets)
+{
+    bool ok = true;
+
+    // Timing phase, views running as in normal operation
+    bench_reset_view(targets);
+    bsp_display_lock(0);
+    memset(&stats, 0, sizeof(stats));
+    bsp_display_unlock();
+
+    for (int frame = 0; frame < CONFIG_RADAR_BENCH_FRAMES; frame++) {
+        bench_feed_frame(frame, targets);
+        vTaskDelay(pdMS_TO_TICKS(FRAME_MS));
+    }
+
+    bsp_display_lock(0);
+    bench_stats_t result = stats;
+    bsp_display_unlock();
+
+    ESP_LOGI(TAG, "%s: %d frames, %u refreshes, render avg %d us max %d us, "
+             "invalidated %u px/frame (%u%% of screen)",
+             view, CONFIG_RADAR_BENCH_FRAMES, (unsigned)result.refreshes,
+             result.refreshes ? (int)(result.render_us_total / result.refreshes) : 0,
+             (int)result.render_us_max,
+             (unsigned)(result.invalidated_px / CONFIG_RADAR_BENCH_FRAMES),
+             (unsigned)(result.invalidated_px * 100 / CONFIG_RADAR_BENCH_FRAMES / (SCREEN_W * SCREEN_H)));
+
+    bench_full_redraw(view);
+
+    // Golden phase, nothing moves except in response to the script
+    bench_reset_view(targets);
+    radar_motion_mode_t motion_mode = radar_sweep_get_motion_mode();
+    if (radar_get_display_mode() == DISPLAY_MODE_SWEEP) {
+        bsp_display_lock(0);
+        radar_sweep_stop_animation();
+        radar_sweep_set_motion_mode(RADAR_MOTION_SNAP);
+        bsp_display_unlock();
+    }
+
+    // Checkpoints at the end of each quarter of the script
+    int checkpoint = 0;
+    for (int frame = 0; frame < CONFIG_RADAR_BENCH_FRAMES; frame++) {
+        bench_feed_frame(frame, targets);
+        if (frame == (checkpoint + 1) * CONFIG_RADAR_BENCH_FRAMES / CHECKPOINTS - 1) {
+            bench_capture();
+            ok &= bench_check_golden(view, checkpoint);
+            checkpoint++;
+        }
+        vTaskDelay(1);
+    }
+
+    if (radar_get_display_mode() == DISPLAY_MODE_SWEEP) {
+        bsp_display_lock(0);
+        radar_sweep_set_motion_mode(motion_mode);
+        radar_sweep_start_animation();
+        bsp_display_unlock();
+    }
+    return ok;
+}
+
+/**
+ * @brief Compare the old full-target pipeline with packed frames
+ *
+ * Both loops take targets as radar_sensor_get_targets() hands them over,
+ * with the library's distance, angle and description already filled in;
+ * that work happens in radar_sensor_update() either way and is not timed.
+ * Old: copy the radar_target_t array out and for the prior state, then
+ * radar_sensor_hasTargetMoved() per target, as the radar task did.
+ * New: pack into radar_frame_t, keep the library text, then for targets
+ * that moved derive distance and angle and fetch the text, as the list
+ * view does; the sweep view needs no derived values at all. The script is
+ * worked out before timing, so its trig and formatting are not counted.
+ */
+static void bench_frame_representation(void)
+{
+    static radar_target_t targets[RADAR_MAX_TARGETS];
+    static radar_target_t prior_targets[RADAR_MAX_TARGETS];
+    static radar_frame_t frame;
+    static radar_frame_t prior;
+    static radar_target_derived_t derived[RADAR_MAX_TARGETS];
+    static int script_count[BENCH_SCRIPT_FRAMES];
+    char text[RADAR_SENSOR_TEXT_LEN];
+    volatile uint32_t sink = 0;
+    int64_t start;
+
+    radar_target_t (*script)[RADAR_MAX_TARGETS] = malloc(BENCH_SCRIPT_FRAMES * sizeof(*script));
+    if (script == NULL) {
+        ESP_LOGE(TAG, "No memory for the frame script, skipped");
+        return;
+    }
+    for (int n = 0; n < BENCH_SCRIPT_FRAMES; n++) {
+        bench_script_frame(n, script[n]);
+        script_count[n] = 0;
+        for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+            if (script[n][i].detected) {
+                script_count[n] = i + 1;
+            }
+        }
+    }
+
+    // Every other frame is stationary, as with people standing still
+    start = esp_timer_get_time();
+    for (int n = 0; n < CONFIG_RADAR_BENCH_FRAMES * 10; n++) {
+        memcpy(prior_targets, targets, sizeof(targets));
+        memcpy(targets, script[(n / 2) % BENCH_SCRIPT_FRAMES], sizeof(targets));
+        for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+            if (radar_sensor_hasTargetMoved(targets, prior_targets, i)) {
+                sink += (uint32_t)targets[i].distance + (uint8_t)targets[i].position_description[0];
+            }
+        }
+    }
+    int64_t old_us = esp_timer_get_time() - start;
+
+    memset(derived, 0, sizeof(derived));
+    start = esp_timer_get_time();
+    for (int n = 0; n < CONFIG_RADAR_BENCH_FRAMES * 10; n++) {
+        int k = (n / 2) % BENCH_SCRIPT_FRAMES;
+        prior = frame;
+        radar_frame_pack(&frame, script[k], script_count[k]);
+        radar_frame_keep_text(&frame, script[k]);
+        for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+            if (radar_frame_target_moved(&frame, &prior, i)) {
+                sink += radar_frame_derive(&frame, i, &derived[i])->distance;
+                if (radar_frame_sensor_text(&frame, i, text, sizeof(text))) {
+                    sink += (uint8_t)text[0];
+                }
+            }
+        }
+    }
+    int64_t new_us = esp_timer_get_time() - start;
+    free(script);
+
+    ESP_LOGI(TAG, "Frame copy: %u bytes as radar_target_t[], %u bytes as radar_frame_t",
+             (unsigned)sizeof(targets), (unsigned)sizeof(frame));
+    ESP_LOGI(TAG, "Derived cache: %u bytes per view",
+             (unsigned)sizeof(derived));
+    ESP_LOGI(TAG, "Per 100 frames: %d us full targets, %d us packed + lazy derive (sink %u)",
+             (int)(old_us * 100 / (CONFIG_RADAR_BENCH_FRAMES * 10)),
+             (int)(new_us * 100 / (CONFIG_RADAR_BENCH_FRAMES * 10)), (unsigned)sink);
+}
+
+/**
+ * @brief Benchmark task
+ */
+static void bench_task(void *pvParameters)
+{
+    static radar_target_t targets[RADAR_MAX_TARGETS];
+    bool ok = true;
+
+    // Compare runs with sdkconfig.defaults.parallel on and off
+    ESP_LOGI(TAG, "Software draw units: %d, %s", CONFIG_LV_DRAW_SW_DRAW_UNIT_CNT, DRAW_THREADS);
+
+    bench_frame_representation();
+
+    bsp_display_lock(0);
+    lv_display_add_event_cb(bench_disp, bench_display_cb, LV_EVENT_ALL, NULL);
+    bsp_display_unlock();
+
+    bench_switch_mode(DISPLAY_MODE_LIST, "list");
+    ok &= bench_view("list", targets);
+    bench_switch_mode(DISPLAY_MODE_SWEEP, "sweep");
+    ok &= bench_view("sweep", targets);
+
+    bsp_display_lock(0);
+    lv_display_remove_event_cb_with_user_data(bench_disp, bench_display_cb, NULL);
+    bsp_display_unlock();
+
+    if (ok && golden_missing) {
+        ESP_LOGW(TAG, "Bench PASSED, %d of %d checkpoints unchecked without golden images",
+                 golden_missing, BENCH_VIEWS * CHECKPOINTS);
+    } else if (ok) {
+        ESP_LOGI(TAG, "Bench PASSED");
+    } else {
+        ESP_LOGE(TAG, "Bench FAILED");
+    }
+    vTaskDelete(NULL);
+}
+
+void radar_bench_start(lv_display_t *disp)
+{
+    bench_disp = disp;
+    RADAR_TASK_CREATE(bench_task, "Render Bench", 4096, NULL, 10, 1);
+}
+
+#endif // CONFIG_RADAR_BENCH
@@ -0,0 +1,37 @@
+/*
+ * radar_bench.h
+ * On-device render benchmark and golden image check for both radar views
+ */
+
+#pragma once
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the render benchmark task in place of the radar task
+ *
+ * First compares the per-frame cost of the full radar_target_t pipeline
+ * with packed frames and lazily derived values. Then, for the list view
+ * and then the sweep view, it:
+ * - Plays CONFIG_RADAR_BENCH_FRAMES scripted target frames at the sensor
+ *   rate, with the sweep animation running, and logs the render time per
+ *   refresh and the invalidated area per frame
+ * - Replays the script with the animation stopped and markers snapping,
+ *   and at four checkpoints captures an 80x60 thumbnail of the full
+ *   screen from the flush path
+ * - Records the thumbnails as golden images in SPIFFS, or compares them
+ *   with the recorded ones within CONFIG_RADAR_BENCH_GOLDEN_TOLERANCE
+ *
+ * Ends with "Bench PASSED" or "Bench FAILED" in the log.
+ *
+ * @param disp LVGL display handle, after radar_display_init()
+ */
+void radar_bench_start(lv_display_t *disp);
+
+#ifdef __cplusplus
+}
+#endif
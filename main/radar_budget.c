@@ -0,0 +1,111 @@
+/*
+ * radar_budget.c
+ * Service task creation and the boot-time stack and heap budget report
+ */
+
+#include "radar_budget.h"
+#include "bsp/esp-bsp.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "lvgl.h"
+#include <inttypes.h>
+
+static const char *TAG = "RadarBudget";
+
+#define BUDGET_MAX_TASKS    32      // About twice the tasks registered in a full build
+#define STACK_MARGIN        512     // Bytes above the peak in the suggested size
+#define STACK_ROUND         256
+
+typedef struct {
+    const char *name;
+    uint32_t stack_bytes;
+    bool is_static;
+} budget_task_t;
+
+static budget_task_t tasks[BUDGET_MAX_TASKS];
+static uint8_t task_count = 0;
+static uint8_t task_dropped = 0;    // Registrations past BUDGET_MAX_TASKS
+static portMUX_TYPE tasks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief List a task in the budget report
+ */
+void radar_budget_add_task(const char *name, uint32_t stack_bytes, bool is_static)
+{
+    bool listed = false;
+
+    portENTER_CRITICAL(&tasks_lock);
+    if (task_count < BUDGET_MAX_TASKS) {
+        tasks[task_count++] = (budget_task_t){name, stack_bytes, is_static};
+        listed = true;
+    } else {
+        task_dropped++;
+    }
+    portEXIT_CRITICAL(&tasks_lock);
+
+    if (!listed) {
+        ESP_LOGW(TAG, "No budget slot left for %s; raise BUDGET_MAX_TASKS", name);
+    }
+}
+
+/**
+ * @brief Log the stack and heap budget
+ */
+void radar_budget_report(const char *when)
+{
+    uint32_t static_bytes = 0;
+    uint8_t count;
+    uint8_t dropped;
+
+    portENTER_CRITICAL(&tasks_lock);
+    count = task_count;
+    dropped = task_dropped;
+    portEXIT_CRITICAL(&tasks_lock);
+
+    ESP_LOGI(TAG, "Stack and heap budget at %s", when);
+    ESP_LOGI(TAG, "  %-16s %6s %6s %6s %8s", "Task", "Stack", "Peak", "Free", "Suggest");
+    for (int i = 0; i < count; i++) {
+        const budget_task_t *t = &tasks[i];
+        TaskHandle_t handle = xTaskGetHandle(t->name);
+
+        if (t->is_static) {
+            static_bytes += t->stack_bytes;
+        }
+        if (handle == NULL) {
+            ESP_LOGI(TAG, "  %-16s %6" PRIu32 "  not running", t->name, t->stack_bytes);
+            continue;
+        }
+        // The high-water mark is the least free stack ever seen, in bytes
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(handle);
+        uint32_t peak = t->stack_bytes > free_bytes ? t->stack_bytes - free_bytes : 0;
+        uint32_t suggest = (peak + STACK_MARGIN + STACK_ROUND - 1) / STACK_ROUND * STACK_ROUND;
+
+        if (free_bytes * 4 < t->stack_bytes) {
+            ESP_LOGW(TAG, "  %-16s %6" PRIu32 " %6" PRIu32 " %6" PRIu32 " %8" PRIu32 " %s",
+                     t->name, t->stack_bytes, peak, free_bytes, suggest, t->is_static ? "static" : "heap");
+        } else {
+            ESP_LOGI(TAG, "  %-16s %6" PRIu32 " %6" PRIu32 " %6" PRIu32 " %8" PRIu32 " %s",
+                     t->name, t->stack_bytes, peak, free_bytes, suggest, t->is_static ? "static" : "heap");
+        }
+    }
+    if (dropped) {
+        ESP_LOGW(TAG, "  %u more tasks not listed, past BUDGET_MAX_TASKS", dropped);
+    }
+    if (static_bytes) {
+        ESP_LOGI(TAG, "  %" PRIu32 " bytes of task stacks are static", static_bytes);
+    }
+
+    ESP_LOGI(TAG, "  Internal heap: %u free, %u lowest ever, %u largest block",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    ESP_LOGI(TAG, "  PSRAM heap: %u free", (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+
+    lv_mem_monitor_t mon;
+    bsp_display_lock(0);
+    lv_mem_monitor(&mon);
+    bsp_display_unlock();
+    ESP_LOGI(TAG, "  LVGL pool: %u of %u used, %u at most, %u%% fragmented",
+             (unsigned)(mon.total_size - mon.free_size), (unsigned)mon.total_size,
+             (unsigned)mon.max_used, mon.frag_pct);
+}
@@ -0,0 +1,70 @@
+/*
+ * radar_budget.h
+ * Service task creation and the boot-time stack and heap budget report
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create a pinned service task and list it in the budget report
+ *
+ * With CONFIG_RADAR_STATIC_ALLOC the stack and task control block are
+ * static buffers, one pair per call site, so they show in the image's
+ * .bss instead of coming out of the heap at run time. Stack sizes are in
+ * bytes, as everywhere in ESP-IDF.
+ */
+#if CONFIG_RADAR_STATIC_ALLOC
+#define RADAR_TASK_CREATE(fn, name, stack_bytes, arg, prio, core)                           \
+    do {                                                                                    \
+        static StackType_t fn##_stack[(stack_bytes) / sizeof(StackType_t)];                 \
+        static StaticTask_t fn##_tcb;                                                       \
+        xTaskCreateStaticPinnedToCore(fn, name, stack_bytes, arg, prio, fn##_stack,         \
+                                      &fn##_tcb, core);                                     \
+        radar_budget_add_task(name, stack_bytes, true);                                     \
+    } while (0)
+#else
+#define RADAR_TASK_CREATE(fn, name, stack_bytes, arg, prio, core)                           \
+    do {                                                                                    \
+        xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, prio, NULL, core);              \
+        radar_budget_add_task(name, stack_bytes, false);                                    \
+    } while (0)
+#endif
+
+/**
+ * @brief List a task in the budget report
+ *
+ * Called by RADAR_TASK_CREATE(); call directly for tasks created
+ * elsewhere, such as the LVGL port task.
+ *
+ * @param name Task name, looked up when the report is printed
+ * @param stack_bytes Stack size the task was created with
+ * @param is_static Whether the stack is a static buffer
+ */
+void radar_budget_add_task(const char *name, uint32_t stack_bytes, bool is_static);
+
+/**
+ * @brief Log the stack and heap budget
+ *
+ * One line per listed task with its stack size, peak use from the
+ * high-water mark and a suggested size with 512 bytes of margin, then
+ * internal heap free, lowest ever free and largest block, PSRAM free and
+ * LVGL pool use. Tasks with less than a quarter of their stack left are
+ * logged as warnings. Call from a task other than the LVGL task.
+ *
+ * @param when Shown in the heading, e.g. "boot"
+ */
+void radar_budget_report(const char *when);
+
+#ifdef __cplusplus
+}
+#endif
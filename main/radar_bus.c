@@ -0,0 +1,335 @@
+/*
+ * radar_bus.c
+ * Publish/subscribe fan-out of radar frames from the radar task
+ *
+ * Frames live in a fixed pool of reference counted slots. Each subscriber
+ * has a ring of slot indexes written only by the publisher and read only
+ * by the subscriber. Ring cells are swapped atomically, so when the
+ * publisher overwrites an unread cell exactly one side gets the old slot
+ * and releases it; neither side ever waits on the other.
+ */
+
+#include "radar_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "RadarBus";
+
+#define SLOT_NONE UINT32_MAX
+
+typedef struct {
+    _Atomic uint32_t refs;      // Publisher plus every queue holding the slot
+    radar_frame_t frame;
+} bus_slot_t;
+
+struct radar_bus_sub {
+    const char *name;
+    TaskHandle_t task;
+    radar_bus_notify_t notify;
+    radar_bus_policy_t policy;
+    uint8_t depth;
+    uint8_t decimation;
+    uint8_t decimate_count;     // Publisher only
+    _Atomic uint32_t cells[CONFIG_RADAR_BUS_MAX_DEPTH];
+    _Atomic uint32_t head;      // Frames queued, written by the publisher
+    _Atomic uint32_t tail;      // Frames taken, written by the subscriber
+    uint32_t last_seq;          // Subscriber only
+    uint32_t stale;             // Subscriber only, frames older than one already taken
+    SemaphoreHandle_t space;    // BLOCK only, given when a cell is freed
+    StaticSemaphore_t space_buf;
+    radar_bus_stats_t stats;
+};
+
+static bus_slot_t slots[CONFIG_RADAR_BUS_SLOTS];
+static radar_bus_sub_t subs[CONFIG_RADAR_BUS_MAX_SUBSCRIBERS];
+static _Atomic uint32_t sub_count = 0;
+static portMUX_TYPE sub_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t bus_seq = 0;
+static uint32_t pool_dropped = 0;
+
+/**
+ * @brief Drop one reference to a slot; the last one frees it
+ */
+static inline void slot_release(uint32_t idx)
+{
+    atomic_fetch_sub_explicit(&slots[idx].refs, 1, memory_order_release);
+}
+
+/**
+ * @brief Claim a free slot for the publisher
+ */
+static int slot_claim(void)
+{
+    for (int i = 0; i < CONFIG_RADAR_BUS_SLOTS; i++) {
+        uint32_t expected = 0;
+        if (atomic_compare_exchange_strong_explicit(&slots[i].refs, &expected, 1,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Take a subscriber slot; task is notified, or notify called, on new frames unless NULL
+ */
+static radar_bus_sub_t *bus_subscribe(const char *name, radar_bus_policy_t policy,
+                                      uint8_t depth, uint8_t decimation, TaskHandle_t task,
+                                      radar_bus_notify_t notify)
+{
+    radar_bus_sub_t *sub = NULL;
+
+    if (policy == RADAR_BUS_LATEST_ONLY || depth == 0) {
+        depth = 1;
+    } else if (depth > CONFIG_RADAR_BUS_MAX_DEPTH) {
+        depth = CONFIG_RADAR_BUS_MAX_DEPTH;
+    }
+
+    portENTER_CRITICAL(&sub_lock);
+    uint32_t count = atomic_load_explicit(&sub_count, memory_order_relaxed);
+    if (count < CONFIG_RADAR_BUS_MAX_SUBSCRIBERS) {
+        sub = &subs[count];
+        memset(sub, 0, sizeof(*sub));
+        sub->name = name;
+        sub->task = task;
+        sub->notify = notify;
+        sub->policy = policy;
+        sub->depth = depth;
+        sub->decimation = decimation ? decimation : 1;
+        for (int i = 0; i < CONFIG_RADAR_BUS_MAX_DEPTH; i++) {
+            atomic_init(&sub->cells[i], SLOT_NONE);
+        }
+        if (policy == RADAR_BUS_BLOCK) {
+            sub->space = xSemaphoreCreateBinaryStatic(&sub->space_buf);
+        }
+        // Publish the fully set up subscriber
+        atomic_store_explicit(&sub_count, count + 1, memory_order_release);
+    }
+    portEXIT_CRITICAL(&sub_lock);
+
+    if (sub == NULL) {
+        ESP_LOGE(TAG, "No subscriber slot for %s", name);
+    } else {
+        ESP_LOGI(TAG, "%s subscribed: policy %d, depth %u, every %u frame(s)",
+                 name, policy, depth, sub->decimation);
+    }
+    return sub;
+}
+
+/**
+ * @brief Subscribe the calling task to radar frames
+ */
+radar_bus_sub_t *radar_bus_subscribe(const char *name, radar_bus_policy_t policy,
+                                     uint8_t depth, uint8_t decimation)
+{
+    return bus_subscribe(name, policy, depth, decimation, xTaskGetCurrentTaskHandle(), NULL);
+}
+
+/**
+ * @brief Subscribe a consumer that polls instead of waiting
+ */
+radar_bus_sub_t *radar_bus_subscribe_polled(const char *name, radar_bus_policy_t policy,
+                                            uint8_t depth, uint8_t decimation, radar_bus_notify_t notify)
+{
+    return bus_subscribe(name, policy, depth, decimation, NULL, notify);
+}
+
+/**
+ * @brief Wait, up to the BLOCK timeout, for the next ring cell to be free
+ *
+ * @return true if the cell is free
+ */
+static bool wait_for_space(radar_bus_sub_t *sub, _Atomic uint32_t *cell)
+{
+    TickType_t limit = pdMS_TO_TICKS(CONFIG_RADAR_BUS_BLOCK_MS);
+    TickType_t start = xTaskGetTickCount();
+
+    while (atomic_load_explicit(cell, memory_order_acquire) != SLOT_NONE) {
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (waited >= limit || xSemaphoreTake(sub->space, limit - waited) != pdTRUE) {
+            return atomic_load_explicit(cell, memory_order_acquire) == SLOT_NONE;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Publish a frame to every subscriber
+ */
+bool radar_bus_publish(const radar_frame_t *frame)
+{
+    int idx = slot_claim();
+    if (idx < 0) {
+        // Every slot is held by a subscriber that is behind
+        pool_dropped++;
+        return false;
+    }
+
+    bus_slot_t *slot = &slots[idx];
+    slot->frame = *frame;
+    slot->frame.seq = ++bus_seq;
+
+    uint32_t count = atomic_load_explicit(&sub_count, memory_order_acquire);
+    for (uint32_t n = 0; n < count; n++) {
+        radar_bus_sub_t *sub = &subs[n];
+
+        if (++sub->decimate_count < sub->decimation) {
+            sub->stats.decimated++;
+            continue;
+        }
+        sub->decimate_count = 0;
+
+        uint32_t head = atomic_load_explicit(&sub->head, memory_order_relaxed);
+        _Atomic uint32_t *cell = &sub->cells[head % sub->depth];
+
+        if (sub->policy == RADAR_BUS_BLOCK && !wait_for_space(sub, cell)) {
+            sub->stats.dropped++;
+            continue;
+        }
+
+        atomic_fetch_add_explicit(&slot->refs, 1, memory_order_relaxed);
+        uint32_t old = atomic_exchange_explicit(cell, (uint32_t)idx, memory_order_acq_rel);
+        atomic_store_explicit(&sub->head, head + 1, memory_order_release);
+        if (old != SLOT_NONE) {
+            // Overwrote the oldest unread frame
+            slot_release(old);
+            sub->stats.dropped++;
+        }
+        sub->stats.delivered++;
+
+        uint32_t lag = head + 1 - atomic_load_explicit(&sub->tail, memory_order_relaxed);
+        if (lag > sub->depth) {
+            lag = sub->depth;
+        }
+        if (lag > sub->stats.max_lag) {
+            sub->stats.max_lag = lag;
+        }
+
+        if (sub->task) {
+            xTaskNotifyGive(sub->task);
+        } else if (sub->notify) {
+            sub->notify();
+        }
+    }
+
+    slot_release(idx);
+    return true;
+}
+
+/**
+ * @brief Take the oldest unread frame without waiting
+ */
+static const radar_frame_t *bus_take(radar_bus_sub_t *sub)
+{
+    uint32_t head = atomic_load_explicit(&sub->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&sub->tail, memory_order_relaxed);
+    const radar_frame_t *frame = NULL;
+
+    while (frame == NULL && tail != head) {
+        if (head - tail > sub->depth) {
+            // Lapped by the publisher, the skipped cells were overwritten
+            tail = head - sub->depth;
+        }
+        uint32_t idx = atomic_exchange_explicit(&sub->cells[tail % sub->depth], SLOT_NONE,
+                                                memory_order_acq_rel);
+        tail++;
+        if (idx == SLOT_NONE) {
+            continue;
+        }
+        if (sub->space) {
+            xSemaphoreGive(sub->space);
+        }
+
+        // A lapped cell can hold a newer frame than the ones after it
+        if (sub->last_seq != 0 && (int32_t)(slots[idx].frame.seq - sub->last_seq) <= 0) {
+            slot_release(idx);
+            sub->stale++;
+            continue;
+        }
+        frame = &slots[idx].frame;
+    }
+    atomic_store_explicit(&sub->tail, tail, memory_order_relaxed);
+
+    if (frame) {
+        int64_t latency = esp_timer_get_time() - frame->timestamp_us;
+        sub->last_seq = frame->seq;
+        sub->stats.received++;
+        sub->stats.last_latency_us = latency;
+        if (latency > sub->stats.max_latency_us) {
+            sub->stats.max_latency_us = latency;
+        }
+    }
+    return frame;
+}
+
+/**
+ * @brief Take the next frame for a subscriber
+ */
+const radar_frame_t *radar_bus_receive(radar_bus_sub_t *sub, TickType_t timeout)
+{
+    while (1) {
+        const radar_frame_t *frame = bus_take(sub);
+        if (frame || timeout == 0) {
+            return frame;
+        }
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return bus_take(sub);
+        }
+    }
+}
+
+/**
+ * @brief Give a received frame back to the bus
+ */
+void radar_bus_release(radar_bus_sub_t *sub, const radar_frame_t *frame)
+{
+    if (frame == NULL) {
+        return;
+    }
+    const bus_slot_t *slot = (const bus_slot_t *)((const char *)frame - offsetof(bus_slot_t, frame));
+    slot_release(slot - slots);
+}
+
+/**
+ * @brief Copy a subscriber's statistics
+ */
+void radar_bus_get_stats(radar_bus_sub_t *sub, radar_bus_stats_t *stats)
+{
+    if (sub == NULL || stats == NULL) {
+        return;
+    }
+    // Counters are written without locks; a copy may be one frame stale
+    *stats = sub->stats;
+    stats->dropped += sub->stale;
+    stats->lag = atomic_load(&sub->head) - atomic_load(&sub->tail);
+    if (stats->lag > sub->depth) {
+        stats->lag = sub->depth;
+    }
+}
+
+/**
+ * @brief Log the statistics of every subscriber
+ */
+void radar_bus_log_stats(void)
+{
+    uint32_t count = atomic_load_explicit(&sub_count, memory_order_acquire);
+    radar_bus_stats_t stats;
+
+    ESP_LOGI(TAG, "Published %" PRIu32 " frames, %" PRIu32 " dropped for want of a slot",
+             bus_seq, pool_dropped);
+    for (uint32_t n = 0; n < count; n++) {
+        radar_bus_get_stats(&subs[n], &stats);
+        ESP_LOGI(TAG, "%-10s delivered %" PRIu32 " received %" PRIu32 " dropped %" PRIu32
+                 " decimated %" PRIu32 " lag %" PRIu32 "/%" PRIu32 " latency %lld/%lld us",
+                 subs[n].name, stats.delivered, stats.received, stats.dropped,
+                 stats.decimated, stats.lag, stats.max_lag,
+                 stats.last_latency_us, stats.max_latency_us);
+    }
+}
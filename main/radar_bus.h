@@ -0,0 +1,120 @@
+/*
+ * radar_bus.h
+ * Publish/subscribe fan-out of radar frames from the radar task
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What happens when a subscriber's queue is full
+typedef enum {
+    RADAR_BUS_LATEST_ONLY,  // Queue of one, a new frame replaces the unread one
+    RADAR_BUS_DROP_OLDEST,  // The oldest unread frame is dropped
+    RADAR_BUS_BLOCK,        // Publisher waits up to CONFIG_RADAR_BUS_BLOCK_MS, then drops the new frame
+} radar_bus_policy_t;
+
+typedef struct radar_bus_sub radar_bus_sub_t;
+
+// Called by the publisher after queueing a frame for a polled subscriber; must not block
+typedef void (*radar_bus_notify_t)(void);
+
+// Per-subscriber counters since subscribing
+typedef struct {
+    uint32_t delivered;         // Frames queued to the subscriber
+    uint32_t dropped;           // Frames the subscriber never received
+    uint32_t decimated;         // Frames skipped by the decimation rate
+    uint32_t received;          // Frames taken by the subscriber
+    uint32_t lag;               // Unread frames right now
+    uint32_t max_lag;           // Most unread frames seen at publish
+    int64_t last_latency_us;    // Publish to receive of the latest frame
+    int64_t max_latency_us;
+} radar_bus_stats_t;
+
+/**
+ * @brief Subscribe the calling task to radar frames
+ *
+ * Subscribers are fixed-size slots; call once per consumer during startup
+ * from the task that will receive. Frames are announced with a task
+ * notification, so the task should not use its notification value for
+ * anything else.
+ *
+ * @param name Name used in the statistics log
+ * @param policy What to do when the queue is full
+ * @param depth Queue length, 1..CONFIG_RADAR_BUS_MAX_DEPTH (1 for LATEST_ONLY)
+ * @param decimation Deliver every Nth frame, 1 for every frame
+ * @return Subscriber handle, or NULL when all slots are used
+ */
+radar_bus_sub_t *radar_bus_subscribe(const char *name, radar_bus_policy_t policy,
+                                     uint8_t depth, uint8_t decimation);
+
+/**
+ * @brief Subscribe a consumer that polls instead of waiting
+ *
+ * As radar_bus_subscribe(), but frames are taken with
+ * radar_bus_receive(sub, 0) from whatever context polls, for example an
+ * LVGL timer, and the consumer's own notifications are left alone. BLOCK
+ * is not useful here: the publisher would wait on a poller.
+ *
+ * @param notify Called on the radar task after each new frame, e.g. to wake the poller, or NULL
+ */
+radar_bus_sub_t *radar_bus_subscribe_polled(const char *name, radar_bus_policy_t policy,
+                                            uint8_t depth, uint8_t decimation, radar_bus_notify_t notify);
+
+/**
+ * @brief Publish a frame to every subscriber
+ *
+ * Called from the radar task. Copies the frame once into a preallocated
+ * slot and queues a reference per subscriber; O(subscribers), no locks
+ * and no allocation. Only BLOCK subscribers can make it wait, and never
+ * longer than CONFIG_RADAR_BUS_BLOCK_MS each.
+ *
+ * @param frame Frame to publish; seq is assigned here
+ * @return false if no slot was free and the frame was dropped for everyone
+ */
+bool radar_bus_publish(const radar_frame_t *frame);
+
+/**
+ * @brief Take the next frame for a subscriber
+ *
+ * The frame stays valid until radar_bus_release(); release it before
+ * taking the next one, or the slot pool runs dry.
+ *
+ * @param sub Subscriber handle
+ * @param timeout Ticks to wait for a frame
+ * @return Frame, or NULL if none arrived in time
+ */
+const radar_frame_t *radar_bus_receive(radar_bus_sub_t *sub, TickType_t timeout);
+
+/**
+ * @brief Give a received frame back to the bus
+ *
+ * @param sub Subscriber handle
+ * @param frame Frame returned by radar_bus_receive()
+ */
+void radar_bus_release(radar_bus_sub_t *sub, const radar_frame_t *frame);
+
+/**
+ * @brief Copy a subscriber's statistics
+ *
+ * @param sub Subscriber handle
+ * @param stats Filled with the counters
+ */
+void radar_bus_get_stats(radar_bus_sub_t *sub, radar_bus_stats_t *stats);
+
+/**
+ * @brief Log the statistics of every subscriber
+ */
+void radar_bus_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,267 @@
+/*
+ * radar_emulator.c
+ * Synthetic RD-03D report frames from scripted walkers
+ *
+ * Each walker follows one of four scripted paths, offset in time by its
+ * index: crossing the room (leaving the field of view at both ends),
+ * walking to and from the sensor, circling, and loitering in place.
+ * Faults are drawn from a seeded xorshift generator so a run can be
+ * replayed byte for byte.
+ */
+
+#include "radar_emulator.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radar_budget.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#endif
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define EMU_RANGE_MM        8000
+#define EMU_TAN60_X1000     1732        // Field of view is +-60 degrees
+#define EMU_RESOLUTION_MM   360         // Distance resolution the sensor reports
+#define EMU_SPEED_DT_MS     100         // mm moved in 100 ms is numerically cm/s
+#define EMU_PHASE_MS        2300        // Time offset between walkers
+
+static const uint8_t frame_header[4] = {0xAA, 0xFF, 0x03, 0x00};
+static const uint8_t frame_tail[2] = {0x55, 0xCC};
+
+/**
+ * @brief xorshift32
+ */
+static uint32_t emu_rand(radar_emu_t *emu)
+{
+    uint32_t x = emu->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    emu->rng = x;
+    return x;
+}
+
+static bool emu_chance(radar_emu_t *emu, uint8_t pct)
+{
+    return pct && (emu_rand(emu) % 100) < pct;
+}
+
+/**
+ * @brief Triangle wave from 0 up to 1 and back over a period
+ */
+static float triangle(uint32_t t_ms, uint32_t period_ms)
+{
+    float phase = (float)(t_ms % period_ms) / period_ms;
+    return phase < 0.5f ? phase * 2.0f : 2.0f - phase * 2.0f;
+}
+
+/**
+ * @brief Scripted position of a walker, mm
+ */
+void radar_emu_walker_position(int walker, uint32_t t_ms, int32_t *x, int32_t *y)
+{
+    uint32_t t = t_ms + walker * EMU_PHASE_MS;
+    int lane = walker / 4;
+
+    switch (walker % 4) {
+    case 0:     // Crossing the room, out of view at both ends
+        *x = -4000 + (int32_t)(8000 * triangle(t, 16000));
+        *y = 1500 + lane * 600;
+        break;
+    case 1:     // To and from the sensor
+        *x = -600 + lane * 400;
+        *y = 600 + (int32_t)(5400 * triangle(t, 11000));
+        break;
+    case 2: {   // Circling
+        float a = 2.0f * PI * (t % 12000) / 12000.0f;
+        *x = (int32_t)(1200 * sinf(a)) + lane * 300;
+        *y = 3500 + (int32_t)(1200 * cosf(a));
+        break;
+    }
+    default: {  // Loitering, swaying in place
+        float a = 2.0f * PI * (t % 3000) / 3000.0f;
+        *x = 900 - lane * 1800 + (int32_t)(150 * sinf(a));
+        *y = 2500 + lane * 800;
+        break;
+    }
+    }
+}
+
+static bool in_view(int32_t x, int32_t y)
+{
+    return y > 0 && abs(x) * 1000 <= y * EMU_TAN60_X1000 &&
+           (int64_t)x * x + (int64_t)y * y <= (int64_t)EMU_RANGE_MM * EMU_RANGE_MM;
+}
+
+/**
+ * @brief Put a value in the sensor's sign-magnitude format
+ */
+static uint8_t *put_signed(uint8_t *p, int32_t v)
+{
+    uint16_t raw = v >= 0 ? (uint16_t)((v & 0x7FFF) | 0x8000) : (uint16_t)(-v & 0x7FFF);
+    p[0] = raw & 0xFF;
+    p[1] = raw >> 8;
+    return p + 2;
+}
+
+/**
+ * @brief Set up an emulator
+ */
+void radar_emu_init(radar_emu_t *emu, const radar_emu_config_t *config)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->config = *config;
+    if (emu->config.walkers > RADAR_EMU_MAX_WALKERS) {
+        emu->config.walkers = RADAR_EMU_MAX_WALKERS;
+    }
+    emu->rng = config->seed ? config->seed : 0x2545F491;
+}
+
+/**
+ * @brief Build the report frame for a point in time
+ */
+size_t radar_emu_frame(radar_emu_t *emu, uint32_t t_ms, uint8_t *out)
+{
+    const radar_emu_config_t *cfg = &emu->config;
+    int32_t slot_xy[RADAR_EMU_SLOTS][3];    // x, y, speed
+    int slots = 0;
+
+    // The first walkers in view take the slots, as the sensor keeps its tracks
+    for (int w = 0; w < cfg->walkers && slots < RADAR_EMU_SLOTS; w++) {
+        int32_t x, y, px, py;
+        radar_emu_walker_position(w, t_ms, &x, &y);
+        if (!in_view(x, y)) {
+            continue;
+        }
+        radar_emu_walker_position(w, t_ms >= EMU_SPEED_DT_MS ? t_ms - EMU_SPEED_DT_MS : 0, &px, &py);
+        int32_t dist = (int32_t)sqrtf((float)x * x + (float)y * y);
+        int32_t prev = (int32_t)sqrtf((float)px * px + (float)py * py);
+
+        if (cfg->noise_mm) {
+            int32_t span = 2 * cfg->noise_mm + 1;
+            x += (int32_t)((emu_rand(emu) % span + emu_rand(emu) % span) / 2) - cfg->noise_mm;
+            y += (int32_t)((emu_rand(emu) % span + emu_rand(emu) % span) / 2) - cfg->noise_mm;
+        }
+        slot_xy[slots][0] = x;
+        slot_xy[slots][1] = y;
+        slot_xy[slots][2] = dist - prev;
+        slots++;
+    }
+
+    if (slots >= 2 && emu_chance(emu, cfg->swap_pct)) {
+        int a = emu_rand(emu) % slots;
+        int b = (a + 1 + emu_rand(emu) % (slots - 1)) % slots;
+        int32_t tmp[3];
+        memcpy(tmp, slot_xy[a], sizeof(tmp));
+        memcpy(slot_xy[a], slot_xy[b], sizeof(tmp));
+        memcpy(slot_xy[b], tmp, sizeof(tmp));
+        emu->stats.swaps++;
+    }
+
+    uint8_t *p = out;
+    memcpy(p, frame_header, sizeof(frame_header));
+    p += sizeof(frame_header);
+    for (int s = 0; s < RADAR_EMU_SLOTS; s++) {
+        if (s >= slots || emu_chance(emu, cfg->dropout_pct)) {
+            if (s < slots) {
+                emu->stats.dropouts++;
+            }
+            memset(p, 0, 8);
+            p += 8;
+            continue;
+        }
+        p = put_signed(p, slot_xy[s][0]);
+        p = put_signed(p, slot_xy[s][1]);
+        p = put_signed(p, slot_xy[s][2]);
+        *p++ = EMU_RESOLUTION_MM & 0xFF;
+        *p++ = EMU_RESOLUTION_MM >> 8;
+    }
+    memcpy(p, frame_tail, sizeof(frame_tail));
+
+    emu->stats.frames++;
+    if (emu_chance(emu, cfg->corrupt_pct)) {
+        if (emu_rand(emu) & 1) {
+            out[emu_rand(emu) % RADAR_EMU_FRAME_LEN] ^= (uint8_t)(1 + emu_rand(emu) % 255);
+            emu->stats.corrupted++;
+        } else {
+            emu->stats.truncated++;
+            return 1 + emu_rand(emu) % (RADAR_EMU_FRAME_LEN - 1);
+        }
+    }
+    return RADAR_EMU_FRAME_LEN;
+}
+
+#if defined(ESP_PLATFORM) && CONFIG_RADAR_EMULATOR
+
+static const char *TAG = "RadarEmulator";
+
+/**
+ * @brief Emulator task, writes one frame per period
+ */
+static void emulator_task(void *pvParameters)
+{
+    int port = (int)pvParameters;
+    static radar_emu_t emu;
+    const radar_emu_config_t config = {
+        .walkers = CONFIG_RADAR_EMULATOR_WALKERS,
+        .noise_mm = CONFIG_RADAR_EMULATOR_NOISE_MM,
+        .dropout_pct = CONFIG_RADAR_EMULATOR_DROPOUT_PCT,
+        .swap_pct = CONFIG_RADAR_EMULATOR_SWAP_PCT,
+        .corrupt_pct = CONFIG_RADAR_EMULATOR_CORRUPT_PCT,
+        .seed = CONFIG_RADAR_EMULATOR_SEED,
+    };
+    uint8_t buf[RADAR_EMU_FRAME_LEN];
+    TickType_t period = pdMS_TO_TICKS(1000 / CONFIG_RADAR_EMULATOR_HZ);
+    TickType_t wake = xTaskGetTickCount();
+    uint64_t n = 0;
+
+    if (period == 0) {
+        period = 1;
+    }
+    radar_emu_init(&emu, &config);
+
+    while (1) {
+        // Scene time advances 1/hz per frame, as in tools/rd03d_emu.c, so a
+        // late wake does not change the stream and a seed replays exactly
+        uint32_t t_ms = (uint32_t)(n++ * 1000 / CONFIG_RADAR_EMULATOR_HZ);
+        size_t len = radar_emu_frame(&emu, t_ms, buf);
+        uart_write_bytes(port, buf, len);
+
+        if (emu.stats.frames % (CONFIG_RADAR_EMULATOR_HZ * 60) == 0) {
+            ESP_LOGI(TAG, "%" PRIu32 " frames, %" PRIu32 " dropouts, %" PRIu32 " swaps, "
+                     "%" PRIu32 " corrupted, %" PRIu32 " truncated",
+                     emu.stats.frames, emu.stats.dropouts, emu.stats.swaps,
+                     emu.stats.corrupted, emu.stats.truncated);
+        }
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+/**
+ * @brief Feed emulated frames into the sensor UART through its internal loopback
+ */
+void radar_emulator_start(int uart_port)
+{
+    esp_err_t err = uart_set_loopback(uart_port, true);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UART %d loopback failed: %s", uart_port, esp_err_to_name(err));
+        return;
+    }
+
+    // Same core and just above the radar task, so frames arrive on schedule
+    RADAR_TASK_CREATE(emulator_task, "Radar Emulator", 3072, (void *)uart_port, 11, 1);
+    ESP_LOGI(TAG, "%d walkers at %d Hz on UART %d", CONFIG_RADAR_EMULATOR_WALKERS,
+             CONFIG_RADAR_EMULATOR_HZ, uart_port);
+}
+
+#endif // CONFIG_RADAR_EMULATOR
@@ -0,0 +1,101 @@
+/*
+ * radar_emulator.h
+ * Synthetic RD-03D report frames from scripted walkers
+ *
+ * The generator is plain C with no ESP-IDF dependency, so the same code
+ * feeds the UART loopback on the device and tools/rd03d_emu.c on a Linux
+ * host.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_EMU_FRAME_LEN     30      // Header, 3 targets of 8 bytes, tail
+#define RADAR_EMU_SLOTS         3
+#define RADAR_EMU_MAX_WALKERS   8
+
+typedef struct {
+    uint8_t walkers;            // People in the scene; at most 3 in the field of view are reported
+    uint16_t noise_mm;          // Peak position noise
+    uint8_t dropout_pct;        // Chance a reported target is missing from a frame
+    uint8_t swap_pct;           // Chance two slots trade targets for a frame
+    uint8_t corrupt_pct;        // Chance a frame has a flipped byte or is cut short
+    uint32_t seed;              // Same seed, same byte stream
+} radar_emu_config_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t dropouts;
+    uint32_t swaps;
+    uint32_t corrupted;
+    uint32_t truncated;
+} radar_emu_stats_t;
+
+typedef struct {
+    radar_emu_config_t config;
+    radar_emu_stats_t stats;
+    uint32_t rng;
+} radar_emu_t;
+
+/**
+ * @brief Set up an emulator
+ *
+ * @param emu Emulator state
+ * @param config Scene and fault settings; walkers is clamped to RADAR_EMU_MAX_WALKERS
+ */
+void radar_emu_init(radar_emu_t *emu, const radar_emu_config_t *config);
+
+/**
+ * @brief Build the report frame for a point in time
+ *
+ * Walker positions are a function of t_ms only, so any frame rate
+ * replays the same trajectories. Targets are encoded as the sensor does:
+ * little endian, bit 15 set for positive values, position in mm, speed
+ * in cm/s (positive moving away), distance resolution 360 mm.
+ *
+ * @param emu Emulator state
+ * @param t_ms Scene time
+ * @param out At least RADAR_EMU_FRAME_LEN bytes
+ * @return Bytes to send; less than RADAR_EMU_FRAME_LEN for a truncated frame
+ */
+size_t radar_emu_frame(radar_emu_t *emu, uint32_t t_ms, uint8_t *out);
+
+/**
+ * @brief Scripted position of a walker, mm
+ *
+ * The path radar_emu_frame() reports for the walker, in sensor
+ * coordinates before noise: x to the right, y away from the sensor. The
+ * multi-unit tool places the same walkers on a floor plan.
+ *
+ * @param walker Walker index, 0..RADAR_EMU_MAX_WALKERS-1
+ * @param t_ms Scene time
+ * @param x Filled with the position across the field of view
+ * @param y Filled with the position away from the sensor
+ */
+void radar_emu_walker_position(int walker, uint32_t t_ms, int32_t *x, int32_t *y);
+
+#ifdef ESP_PLATFORM
+
+/**
+ * @brief Feed emulated frames into the sensor UART through its internal loopback
+ *
+ * Call after the sensor driver is installed on the port. Frames are
+ * written at CONFIG_RADAR_EMULATOR_HZ with the scene and faults set in
+ * idf.py menuconfig → HumanRadar Sensor. Commands sent to the sensor
+ * loop back unanswered, so skip sensor configuration when this runs.
+ *
+ * @param uart_port Sensor UART
+ */
+void radar_emulator_start(int uart_port);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,164 @@
+/*
+ * radar_frame.c
+ * Packing of sensor targets and lazily derived per-target values
+ */
+
+#include "radar_frame.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+/**
+ * @brief Round and clamp a sensor value into an int16
+ */
+static inline int16_t pack_i16(float value)
+{
+    if (value >= INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value <= INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)lroundf(value);
+}
+
+/**
+ * @brief Pack the sensor's targets into a frame
+ */
+void radar_frame_pack(radar_frame_t *frame, const radar_target_t *targets, int target_count)
+{
+    frame->detected = 0;
+    frame->target_count = (uint8_t)target_count;
+
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        radar_point_t *point = &frame->targets[i];
+        if (targets[i].detected) {
+            frame->detected |= 1u << i;
+        }
+        point->x = pack_i16(targets[i].x);
+        point->y = pack_i16(targets[i].y);
+        point->speed = pack_i16(targets[i].speed);
+    }
+}
+
+// Sensor text of recent frames, written by the radar task
+typedef struct {
+    int64_t timestamp_us;
+    char text[RADAR_MAX_TARGETS][RADAR_SENSOR_TEXT_LEN];
+} frame_text_t;
+
+static frame_text_t kept_text[RADAR_FRAME_TEXT_KEPT];
+static uint32_t kept_next = 0;
+static portMUX_TYPE kept_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Keep the sensor library's position text for a packed frame
+ */
+void radar_frame_keep_text(const radar_frame_t *frame, const radar_target_t *targets)
+{
+    portENTER_CRITICAL(&kept_lock);
+    frame_text_t *kept = &kept_text[kept_next++ % RADAR_FRAME_TEXT_KEPT];
+    kept->timestamp_us = frame->timestamp_us;
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        if (radar_frame_detected(frame, i)) {
+            snprintf(kept->text[i], RADAR_SENSOR_TEXT_LEN, "%s", targets[i].position_description);
+        } else {
+            kept->text[i][0] = '\0';
+        }
+    }
+    portEXIT_CRITICAL(&kept_lock);
+}
+
+/**
+ * @brief The sensor library's position text for a target of a frame
+ */
+bool radar_frame_sensor_text(const radar_frame_t *frame, int idx, char *text, size_t len)
+{
+    bool found = false;
+
+    portENTER_CRITICAL(&kept_lock);
+    for (int i = 0; i < RADAR_FRAME_TEXT_KEPT; i++) {
+        const frame_text_t *kept = &kept_text[i];
+        if (kept->timestamp_us == frame->timestamp_us && kept->text[idx][0] != '\0') {
+            snprintf(text, len, "%s", kept->text[idx]);
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&kept_lock);
+    return found;
+}
+
+/**
+ * @brief Whether a target appeared, disappeared or moved since a prior frame
+ */
+bool radar_frame_target_moved(const radar_frame_t *frame, const radar_frame_t *prior, int idx)
+{
+    bool detected = radar_frame_detected(frame, idx);
+
+    if (detected != radar_frame_detected(prior, idx)) {
+        return true;
+    }
+    if (!detected) {
+        return false;
+    }
+    return abs(frame->targets[idx].x - prior->targets[idx].x) >= RADAR_FRAME_MOVE_MM ||
+           abs(frame->targets[idx].y - prior->targets[idx].y) >= RADAR_FRAME_MOVE_MM;
+}
+
+/**
+ * @brief Distance and angle of a target, computed only if its position changed
+ */
+const radar_target_derived_t *radar_frame_derive(const radar_frame_t *frame, int idx,
+                                                 radar_target_derived_t *cache)
+{
+    const radar_point_t *point = &frame->targets[idx];
+
+    if (cache->valid && cache->x == point->x && cache->y == point->y) {
+        return cache;
+    }
+
+    float x = point->x;
+    float y = point->y;
+    cache->x = point->x;
+    cache->y = point->y;
+    cache->distance = (uint16_t)lroundf(sqrtf(x * x + y * y));
+    cache->angle = (int16_t)lroundf(atan2f(x, y) * 1800.0f / PI);
+    cache->valid = true;
+    cache->described = false;
+    return cache;
+}
+
+/**
+ * @brief Position text of a target, generated only if its position changed
+ */
+const char *radar_frame_describe(const radar_frame_t *frame, int idx, radar_target_derived_t *cache)
+{
+    radar_frame_derive(frame, idx, cache);
+    if (cache->described) {
+        return cache->description;
+    }
+
+    const char *sector;
+    if (cache->angle < -300) {
+        sector = "Far left";
+    } else if (cache->angle < -100) {
+        sector = "Left";
+    } else if (cache->angle <= 100) {
+        sector = "Ahead";
+    } else if (cache->angle <= 300) {
+        sector = "Right";
+    } else {
+        sector = "Far right";
+    }
+    snprintf(cache->description, sizeof(cache->description), "%s %u.%u m",
+             sector, cache->distance / 1000, (cache->distance % 1000) / 100);
+    cache->described = true;
+    return cache->description;
+}
@@ -0,0 +1,143 @@
+/*
+ * radar_frame.h
+ * One sensor frame as passed between the radar task and its consumers
+ *
+ * Frames carry only what the sensor measures, packed: position and speed
+ * as int16 and a detected bitmask. Distance, angle and the position text
+ * are derived from x/y on demand by the consumers that show them, and
+ * cached until the position changes.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#ifdef ESP_PLATFORM
+#include "humanRadarRD_03D.h"
+#else
+#define RADAR_MAX_TARGETS           3       // As in the sensor library, for host tools
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_FRAME_MOVE_MM         50      // Smaller changes do not count as movement
+#define RADAR_DESCRIPTION_LEN       24
+#define RADAR_FRAME_TEXT_KEPT       8       // Recent sensor frames whose position text is kept
+
+typedef struct {
+    int16_t x;                  // mm, positive to the right
+    int16_t y;                  // mm, away from the sensor
+    int16_t speed;              // mm/s as reported by the sensor
+} radar_point_t;
+
+typedef struct {
+    uint32_t seq;               // Assigned by radar_bus_publish()
+    int64_t timestamp_us;       // esp_timer time the frame was received
+    uint8_t detected;           // Bit per target
+    uint8_t target_count;       // Highest detected index + 1
+    radar_point_t targets[RADAR_MAX_TARGETS];
+} radar_frame_t;
+
+// Values derived from one target's position, owned by the consumer that shows them
+typedef struct {
+    bool valid;                 // distance and angle belong to x/y
+    bool described;             // description belongs to x/y
+    int16_t x;
+    int16_t y;
+    uint16_t distance;          // mm
+    int16_t angle;              // Tenths of a degree, positive to the right
+    char description[RADAR_DESCRIPTION_LEN];
+} radar_target_derived_t;
+
+/**
+ * @brief Whether a target is detected in a frame
+ */
+static inline bool radar_frame_detected(const radar_frame_t *frame, int idx)
+{
+    return (frame->detected >> idx) & 1;
+}
+
+#ifdef ESP_PLATFORM
+
+#define RADAR_SENSOR_TEXT_LEN       sizeof(((radar_target_t *)0)->position_description)
+
+/**
+ * @brief Pack the sensor's targets into a frame
+ *
+ * Only x, y, speed and the detected flags are kept. seq and timestamp_us
+ * are left to the caller and the bus.
+ *
+ * @param frame Frame to fill
+ * @param targets Array of RADAR_MAX_TARGETS targets from the sensor
+ * @param target_count Highest detected index + 1
+ */
+void radar_frame_pack(radar_frame_t *frame, const radar_target_t *targets, int target_count);
+
+/**
+ * @brief Keep the sensor library's position text for a packed frame
+ *
+ * The packed frame has no room for text, so the radar task hands the
+ * library's position_description here after packing, keyed by the
+ * frame's timestamp_us. The last RADAR_FRAME_TEXT_KEPT frames are kept,
+ * enough for a view that runs a few frames behind. Three short copies
+ * under a spinlock.
+ *
+ * @param frame Frame just packed, with timestamp_us set
+ * @param targets The targets it was packed from
+ */
+void radar_frame_keep_text(const radar_frame_t *frame, const radar_target_t *targets);
+
+#endif // ESP_PLATFORM
+
+/**
+ * @brief The sensor library's position text for a target of a frame
+ *
+ * Safe from any task.
+ *
+ * @param frame Frame from the bus
+ * @param idx Target index
+ * @param text Filled with the text
+ * @param len Size of text
+ * @return false if the frame did not come from this sensor, or is too old;
+ *         merged and replayed frames have no sensor text
+ */
+bool radar_frame_sensor_text(const radar_frame_t *frame, int idx, char *text, size_t len);
+
+/**
+ * @brief Whether a target appeared, disappeared or moved since a prior frame
+ *
+ * Integer compare; a move of less than RADAR_FRAME_MOVE_MM on both axes
+ * does not count.
+ */
+bool radar_frame_target_moved(const radar_frame_t *frame, const radar_frame_t *prior, int idx);
+
+/**
+ * @brief Distance and angle of a target, computed only if its position changed
+ *
+ * @param frame Frame holding the target
+ * @param idx Target index
+ * @param cache The consumer's cache for this target index
+ * @return cache, up to date for the target's position
+ */
+const radar_target_derived_t *radar_frame_derive(const radar_frame_t *frame, int idx,
+                                                 radar_target_derived_t *cache);
+
+/**
+ * @brief Position text of a target, generated only if its position changed
+ *
+ * For frames without sensor text, see radar_frame_sensor_text(): a
+ * sector and range worked out from x/y.
+ *
+ * @param frame Frame holding the target
+ * @param idx Target index
+ * @param cache The consumer's cache for this target index
+ * @return Text such as "Left 2.4 m", valid until the cache changes
+ */
+const char *radar_frame_describe(const radar_frame_t *frame, int idx, radar_target_derived_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,180 @@
+/*
+ * radar_governor.c
+ * Sheds display work when frames fall behind the latency budget
+ *
+ * Two measurements are compared with their budgets once per window: the
+ * worst time from sensor read to the view update finishing, taken by the
+ * display service on the LVGL task, and the worst LVGL render time, taken from the
+ * display's render events. Work is shed one level at a time, cheapest
+ * visual loss first, and given back one level at a time once both are
+ * well inside budget, so the display does not flap between levels.
+ */
+
+#include "radar_governor.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "ui_radar_sweep.h"
+#include <inttypes.h>
+
+#if CONFIG_RADAR_GOVERNOR
+
+static const char *TAG = "RadarGovernor";
+
+#define SHED_WINDOWS        2       // Windows over budget before shedding a level
+#define RESTORE_MS          3000    // Time well within budget before restoring a level
+#define HEADROOM_PCT        60      // "Well within" is below this share of the budget
+#define SHORT_TRAIL         12      // Segments per trail at RADAR_QUALITY_SHORT_TRAILS
+#define SLOW_SWEEP_MS       100     // Sweep timer period at RADAR_QUALITY_SLOW_SWEEP
+
+static const char *level_names[RADAR_QUALITY_COUNT] = {
+    "full", "short trails", "slow sweep", "no info label", "half frame rate"
+};
+
+static volatile uint8_t level = RADAR_QUALITY_FULL;
+static volatile uint32_t latency_max_us = 0;    // Display service, this window
+
+// LVGL task only
+static lv_timer_t *timer = NULL;
+static int64_t render_start_us = 0;
+static uint32_t render_max_us = 0;
+static uint8_t over_windows = 0;
+static uint32_t under_ms = 0;
+static bool idle = false;                       // Timer paused until the next render
+
+/**
+ * @brief Display event tap: render time of each refresh
+ */
+static void render_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        render_start_us = esp_timer_get_time();
+        if (idle) {
+            idle = false;
+            lv_timer_resume(timer);
+        }
+    } else if (render_start_us) {
+        uint32_t us = (uint32_t)(esp_timer_get_time() - render_start_us);
+        if (us > render_max_us) {
+            render_max_us = us;
+        }
+    }
+}
+
+/**
+ * @brief Apply the settings of the current level
+ */
+static void apply_level(void)
+{
+    radar_sweep_set_trail_limit(level >= RADAR_QUALITY_SHORT_TRAILS ? SHORT_TRAIL : 0);
+    radar_sweep_set_sweep_period(level >= RADAR_QUALITY_SLOW_SWEEP ? SLOW_SWEEP_MS : 50);
+}
+
+/**
+ * @brief Compare the window's worst case with the budgets and step the level
+ */
+static void governor_timer_cb(lv_timer_t *t)
+{
+    const uint32_t latency_budget_us = CONFIG_RADAR_GOVERNOR_LATENCY_MS * 1000;
+    const uint32_t render_budget_us = CONFIG_RADAR_GOVERNOR_RENDER_MS * 1000;
+    uint32_t latency_us = latency_max_us;
+    uint32_t render_us = render_max_us;
+
+    latency_max_us = 0;
+    render_max_us = 0;
+
+    // Nothing drawn and nothing to restore: sleep until the next render
+    if (latency_us == 0 && render_us == 0 && level == RADAR_QUALITY_FULL) {
+        idle = true;
+        under_ms = 0;
+        lv_timer_pause(t);
+        return;
+    }
+
+    bool latency_over = latency_us > latency_budget_us;
+    bool render_over = render_us > render_budget_us;
+
+    if (latency_over || render_over) {
+        under_ms = 0;
+        if (++over_windows < SHED_WINDOWS || level == RADAR_QUALITY_COUNT - 1) {
+            return;
+        }
+        over_windows = 0;
+        level++;
+        apply_level();
+        if (latency_over) {
+            ESP_LOGW(TAG, "Quality down to %s: latency %" PRIu32 " ms over %d ms budget",
+                     level_names[level], latency_us / 1000, CONFIG_RADAR_GOVERNOR_LATENCY_MS);
+        } else {
+            ESP_LOGW(TAG, "Quality down to %s: render %" PRIu32 " ms over %d ms budget",
+                     level_names[level], render_us / 1000, CONFIG_RADAR_GOVERNOR_RENDER_MS);
+        }
+        return;
+    }
+
+    over_windows = 0;
+    if (latency_us * 100 > latency_budget_us * HEADROOM_PCT ||
+        render_us * 100 > render_budget_us * HEADROOM_PCT) {
+        under_ms = 0;
+        return;
+    }
+    under_ms += CONFIG_RADAR_GOVERNOR_PERIOD_MS;
+    if (under_ms < RESTORE_MS || level == RADAR_QUALITY_FULL) {
+        return;
+    }
+    under_ms = 0;
+    level--;
+    apply_level();
+    ESP_LOGI(TAG, "Quality up to %s: latency %" PRIu32 " ms, render %" PRIu32 " ms",
+             level_names[level], latency_us / 1000, render_us / 1000);
+}
+
+/**
+ * @brief Start watching latency and render time
+ */
+void radar_governor_start(lv_display_t *disp)
+{
+    if (timer) {
+        return;
+    }
+    lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_READY, NULL);
+    timer = lv_timer_create(governor_timer_cb, CONFIG_RADAR_GOVERNOR_PERIOD_MS, NULL);
+    ESP_LOGI(TAG, "Budgets: latency %d ms, render %d ms", CONFIG_RADAR_GOVERNOR_LATENCY_MS,
+             CONFIG_RADAR_GOVERNOR_RENDER_MS);
+}
+
+/**
+ * @brief Record the latency of a frame just applied to the view
+ */
+void radar_governor_note_latency(int64_t latency_us)
+{
+    if (latency_us > latency_max_us) {
+        latency_max_us = (uint32_t)latency_us;
+    }
+}
+
+/**
+ * @brief Current quality level
+ */
+radar_quality_t radar_governor_level(void)
+{
+    return (radar_quality_t)level;
+}
+
+#else
+
+void radar_governor_start(lv_display_t *disp)
+{
+}
+
+void radar_governor_note_latency(int64_t latency_us)
+{
+}
+
+radar_quality_t radar_governor_level(void)
+{
+    return RADAR_QUALITY_FULL;
+}
+
+#endif // CONFIG_RADAR_GOVERNOR
@@ -0,0 +1,57 @@
+/*
+ * radar_governor.h
+ * Sheds display work when frames fall behind the latency budget
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Quality levels, in the order work is shed; each includes the ones before it
+typedef enum {
+    RADAR_QUALITY_FULL,
+    RADAR_QUALITY_SHORT_TRAILS,     // Sweep trails cut to a quarter
+    RADAR_QUALITY_SLOW_SWEEP,       // Sweep animation at half rate
+    RADAR_QUALITY_NO_INFO,          // Sweep info label no longer updated
+    RADAR_QUALITY_HALF_RATE,        // Every other sensor frame applied to the view
+    RADAR_QUALITY_COUNT
+} radar_quality_t;
+
+/**
+ * @brief Start watching latency and render time
+ *
+ * Hooks the display's render events and starts an LVGL timer that
+ * compares the worst sensor-to-view latency and render time of each
+ * CONFIG_RADAR_GOVERNOR_PERIOD_MS window with their budgets. Over budget
+ * for two windows sheds one more level; comfortably within budget for
+ * three seconds restores one. Every change is logged with its cause.
+ * Call with the display locked.
+ *
+ * @param disp Display to watch
+ */
+void radar_governor_start(lv_display_t *disp);
+
+/**
+ * @brief Record the latency of a frame just applied to the view
+ *
+ * Call from the display service task.
+ *
+ * @param latency_us Time from sensor read to the view update finishing
+ */
+void radar_governor_note_latency(int64_t latency_us);
+
+/**
+ * @brief Current quality level
+ *
+ * Safe from any task.
+ */
+radar_quality_t radar_governor_level(void);
+
+#ifdef __cplusplus
+}
+#endif
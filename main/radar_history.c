@@ -0,0 +1,423 @@
+/*
+ * radar_history.c
+ * Per-minute occupancy history in a circular log on the raw history partition
+ *
+ * The partition is a ring of 4 KB sectors. Each sector starts with a
+ * 16 byte header (magic, sequence number, first minute) followed by up to
+ * 255 fixed size records in time order. Records are buffered in RAM and
+ * appended CONFIG_RADAR_HISTORY_BATCH at a time; a sector is erased only
+ * when the log moves into it, so every byte of flash is written once and
+ * erased once per 255 minutes of history, whatever the batch size.
+ *
+ * The RAM index is the first minute of every sector, rebuilt at boot from
+ * the headers, so a range query reads only the sectors it overlaps.
+ */
+
+#include "radar_history.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "RadarHistory";
+
+#define HISTORY_SECTOR      4096
+#define HISTORY_MAGIC       0x31534948      // "HIS1"
+#define ERASED_MINUTE       UINT32_MAX
+#define READ_CHUNK          16              // Records read from flash at a time
+#define HISTORY_MAX_SECTORS 1024            // Index size in the static allocation profile
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;               // Incremented each time the log opens a sector
+    uint32_t first_minute;      // Minute of the sector's first record
+    uint32_t check;             // ~seq
+} history_header_t;
+
+#define RECORDS_PER_SECTOR  ((HISTORY_SECTOR - sizeof(history_header_t)) / sizeof(radar_history_record_t))
+
+_Static_assert(sizeof(radar_history_record_t) == 16, "history record layout changed");
+
+static const esp_partition_t *part = NULL;
+static uint32_t sector_count = 0;
+static uint32_t *first_minute = NULL;   // Per sector, 0 when erased or unused
+static uint32_t head = 0;               // Sector being appended to
+static uint32_t head_seq = 0;           // 0 while the log is empty
+static uint32_t head_used = 0;          // Records in the head sector
+
+// Records waiting for the next batch write
+static radar_history_record_t pending[CONFIG_RADAR_HISTORY_BATCH];
+static uint32_t pending_count = 0;
+static SemaphoreHandle_t lock = NULL;
+static StaticSemaphore_t lock_buf;
+
+// Minute being accumulated, writer task only
+static radar_history_record_t cur;
+static uint32_t cur_occupied_ms = 0;
+static uint32_t cur_min_sq = 0;
+static uint32_t cur_max_sq = 0;
+
+/**
+ * @brief Fletcher-16 of a record, excluding the check field
+ */
+static uint16_t record_check(const radar_history_record_t *record)
+{
+    const uint8_t *p = (const uint8_t *)record;
+    uint16_t a = 0;
+    uint16_t b = 0;
+
+    for (size_t i = 0; i < offsetof(radar_history_record_t, check); i++) {
+        a = (a + p[i]) % 255;
+        b = (b + a) % 255;
+    }
+    return (uint16_t)((b << 8) | a);
+}
+
+/**
+ * @brief Erase the next sector of the ring and start it with a header
+ *
+ * Call with the lock held.
+ */
+static esp_err_t open_sector(uint32_t minute)
+{
+    uint32_t next = head_seq == 0 ? head : (head + 1) % sector_count;
+    history_header_t header = {
+        .magic = HISTORY_MAGIC,
+        .seq = head_seq + 1,
+        .first_minute = minute,
+        .check = ~(head_seq + 1),
+    };
+
+    // The oldest sector leaves the index before its flash is touched
+    first_minute[next] = 0;
+    esp_err_t err = esp_partition_erase_range(part, next * HISTORY_SECTOR, HISTORY_SECTOR);
+    if (err == ESP_OK) {
+        err = esp_partition_write(part, next * HISTORY_SECTOR, &header, sizeof(header));
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    first_minute[next] = minute;
+    head = next;
+    head_seq = header.seq;
+    head_used = 0;
+    ESP_LOGD(TAG, "Opened sector %" PRIu32 " (seq %" PRIu32 ")", head, head_seq);
+    return ESP_OK;
+}
+
+/**
+ * @brief Append the pending records, splitting the batch at sector ends
+ *
+ * Call with the lock held.
+ */
+static void write_pending(void)
+{
+    uint32_t i = 0;
+
+    while (i < pending_count) {
+        if (head_seq == 0 || head_used >= RECORDS_PER_SECTOR) {
+            esp_err_t err = open_sector(pending[i].minute);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Opening sector failed: %s", esp_err_to_name(err));
+                break;
+            }
+        }
+
+        uint32_t run = pending_count - i;
+        if (run > RECORDS_PER_SECTOR - head_used) {
+            run = RECORDS_PER_SECTOR - head_used;
+        }
+        size_t offset = head * HISTORY_SECTOR + sizeof(history_header_t) +
+                        head_used * sizeof(radar_history_record_t);
+        esp_err_t err = esp_partition_write(part, offset, &pending[i],
+                                            run * sizeof(radar_history_record_t));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Writing %" PRIu32 " records failed: %s", run, esp_err_to_name(err));
+            break;
+        }
+        head_used += run;
+        i += run;
+    }
+    pending_count = 0;
+}
+
+/**
+ * @brief Move the finished minute into the batch, writing it when full
+ */
+static void close_minute(void)
+{
+    if (cur.minute == 0) {
+        return;
+    }
+
+    uint32_t occupied_s = cur_occupied_ms / 1000;
+    cur.occupied_s = occupied_s > 60 ? 60 : occupied_s;
+    cur.min_mm = cur_max_sq ? (uint16_t)lroundf(sqrtf((float)cur_min_sq)) : 0;
+    cur.max_mm = cur_max_sq ? (uint16_t)lroundf(sqrtf((float)cur_max_sq)) : 0;
+    cur.check = record_check(&cur);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    pending[pending_count++] = cur;
+    if (pending_count >= CONFIG_RADAR_HISTORY_BATCH) {
+        write_pending();
+    }
+    xSemaphoreGive(lock);
+
+    cur.minute = 0;
+}
+
+/**
+ * @brief Start accumulating a new minute if the minute changed
+ */
+static bool roll_minute(uint32_t minute)
+{
+    if (part == NULL || minute == 0) {
+        return false;
+    }
+    if (cur.minute != minute) {
+        close_minute();
+        memset(&cur, 0, sizeof(cur));
+        cur.minute = minute;
+        cur_occupied_ms = 0;
+        cur_min_sq = UINT32_MAX;
+        cur_max_sq = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Current minute, or 0 while the clock is not set
+ */
+uint32_t radar_history_now_minute(void)
+{
+    time_t now = time(NULL);
+
+    return now >= RADAR_CLOCK_VALID_EPOCH ? (uint32_t)(now / 60) : 0;
+}
+
+/**
+ * @brief Find the history partition and rebuild the sector index
+ */
+void radar_history_init(void)
+{
+    history_header_t header;
+    radar_history_record_t chunk[READ_CHUNK];
+
+    if (part != NULL) {
+        return;
+    }
+    const esp_partition_t *found = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                            ESP_PARTITION_SUBTYPE_ANY, "history");
+    if (found == NULL) {
+        ESP_LOGW(TAG, "No history partition, history is not recorded");
+        return;
+    }
+    sector_count = found->size / HISTORY_SECTOR;
+#if CONFIG_RADAR_STATIC_ALLOC
+    static uint32_t first_minute_buf[HISTORY_MAX_SECTORS];
+    if (sector_count > HISTORY_MAX_SECTORS) {
+        ESP_LOGW(TAG, "Only the first %d of %" PRIu32 " sectors are used", HISTORY_MAX_SECTORS, sector_count);
+        sector_count = HISTORY_MAX_SECTORS;
+    }
+    first_minute = first_minute_buf;
+#else
+    first_minute = calloc(sector_count, sizeof(uint32_t));
+#endif
+    if (first_minute == NULL) {
+        ESP_LOGE(TAG, "No memory for the index of %" PRIu32 " sectors", sector_count);
+        return;
+    }
+    lock = xSemaphoreCreateMutexStatic(&lock_buf);
+
+    // Index: one header per sector; the highest sequence number is the head
+    for (uint32_t s = 0; s < sector_count; s++) {
+        if (esp_partition_read(found, s * HISTORY_SECTOR, &header, sizeof(header)) != ESP_OK ||
+            header.magic != HISTORY_MAGIC || header.check != ~header.seq) {
+            continue;
+        }
+        first_minute[s] = header.first_minute;
+        if (header.seq > head_seq) {
+            head_seq = header.seq;
+            head = s;
+        }
+    }
+
+    // Append position: the first erased record of the head sector
+    head_used = 0;
+    while (head_seq != 0 && head_used < RECORDS_PER_SECTOR) {
+        uint32_t n = RECORDS_PER_SECTOR - head_used;
+        if (n > READ_CHUNK) {
+            n = READ_CHUNK;
+        }
+        esp_partition_read(found, head * HISTORY_SECTOR + sizeof(history_header_t) +
+                           head_used * sizeof(radar_history_record_t), chunk, n * sizeof(chunk[0]));
+        uint32_t i = 0;
+        while (i < n && chunk[i].minute != ERASED_MINUTE) {
+            i++;
+        }
+        head_used += i;
+        if (i < n) {
+            break;
+        }
+    }
+
+    part = found;
+    ESP_LOGI(TAG, "%" PRIu32 " sectors, room for %" PRIu32 " days; head sector %" PRIu32
+             " (seq %" PRIu32 ") holds %" PRIu32 " records",
+             sector_count, (uint32_t)(sector_count * RECORDS_PER_SECTOR / 1440),
+             head, head_seq, head_used);
+}
+
+/**
+ * @brief Add one frame to the current minute
+ */
+void radar_history_note_frame(const radar_frame_t *frame, uint8_t detected, uint32_t gap_ms)
+{
+    if (!roll_minute(radar_history_now_minute())) {
+        return;
+    }
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        if (!radar_frame_detected(frame, idx)) {
+            continue;
+        }
+        int32_t x = frame->targets[idx].x;
+        int32_t y = frame->targets[idx].y;
+        uint32_t sq = (uint32_t)(x * x) + (uint32_t)(y * y);
+        if (sq < cur_min_sq) {
+            cur_min_sq = sq;
+        }
+        if (sq > cur_max_sq) {
+            cur_max_sq = sq;
+        }
+    }
+    if (detected) {
+        cur_occupied_ms += gap_ms;
+    }
+    if (detected > cur.peak) {
+        cur.peak = detected;
+    }
+}
+
+/**
+ * @brief Count a crossing or finished visit in the current minute
+ */
+void radar_history_note_event(radar_history_event_t event)
+{
+    uint8_t *count;
+
+    if (!roll_minute(radar_history_now_minute())) {
+        return;
+    }
+    switch (event) {
+    case RADAR_HISTORY_ENTRY:
+        count = &cur.entries;
+        break;
+    case RADAR_HISTORY_EXIT:
+        count = &cur.exits;
+        break;
+    default:
+        count = &cur.visits;
+        break;
+    }
+    if (*count < UINT8_MAX) {
+        (*count)++;
+    }
+}
+
+/**
+ * @brief Close the minute once it is over and write full batches
+ */
+void radar_history_tick(void)
+{
+    uint32_t minute = radar_history_now_minute();
+
+    if (part != NULL && cur.minute != 0 && minute != cur.minute) {
+        close_minute();
+    }
+}
+
+/**
+ * @brief Write the records still held in RAM
+ */
+void radar_history_flush(void)
+{
+    if (part == NULL) {
+        return;
+    }
+    close_minute();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    write_pending();
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief Visit the records between two minutes, oldest first
+ */
+int radar_history_query(uint32_t from_minute, uint32_t to_minute, radar_history_cb_t cb, void *ctx)
+{
+    radar_history_record_t chunk[READ_CHUNK];
+    int sectors_read = 0;
+
+    if (part == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    // Oldest sector first: the one after the head, round to the head
+    for (uint32_t n = 1; head_seq != 0 && n <= sector_count; n++) {
+        uint32_t s = (head + n) % sector_count;
+        if (first_minute[s] == 0 || first_minute[s] > to_minute) {
+            continue;
+        }
+        // Records end before the next (newer) sector begins
+        uint32_t next = (s + 1) % sector_count;
+        if (s != head && first_minute[next] != 0 && first_minute[next] <= from_minute) {
+            continue;
+        }
+
+        uint32_t count = s == head ? head_used : RECORDS_PER_SECTOR;
+        sectors_read++;
+        for (uint32_t r = 0; r < count; r += READ_CHUNK) {
+            uint32_t n_read = count - r < READ_CHUNK ? count - r : READ_CHUNK;
+            if (esp_partition_read(part, s * HISTORY_SECTOR + sizeof(history_header_t) +
+                                   r * sizeof(radar_history_record_t),
+                                   chunk, n_read * sizeof(chunk[0])) != ESP_OK) {
+                break;
+            }
+            for (uint32_t i = 0; i < n_read; i++) {
+                const radar_history_record_t *rec = &chunk[i];
+                if (rec->minute == ERASED_MINUTE) {
+                    r = count;
+                    break;
+                }
+                if (rec->minute < from_minute || rec->minute > to_minute ||
+                    rec->check != record_check(rec)) {
+                    continue;
+                }
+                if (!cb(rec, ctx)) {
+                    goto done;
+                }
+            }
+        }
+    }
+
+    // Then the minutes not yet written
+    for (uint32_t i = 0; i < pending_count; i++) {
+        if (pending[i].minute >= from_minute && pending[i].minute <= to_minute &&
+            !cb(&pending[i], ctx)) {
+            break;
+        }
+    }
+
+done:
+    xSemaphoreGive(lock);
+    return sectors_read;
+}
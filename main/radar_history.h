@@ -0,0 +1,111 @@
+/*
+ * radar_history.h
+ * Per-minute occupancy history in a circular log on the raw history partition
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_CLOCK_VALID_EPOCH 1704067200  // 2024-01-01, earlier means the clock is not set
+
+// One minute of activity; 16 bytes, 255 to a 4 KB flash sector
+typedef struct {
+    uint32_t minute;            // Minutes since the Unix epoch
+    uint16_t min_mm;            // Nearest person seen, 0 if nobody
+    uint16_t max_mm;            // Farthest person seen, 0 if nobody
+    uint8_t occupied_s;         // Seconds with anyone detected, 0-60
+    uint8_t peak;               // Most people at once
+    uint8_t entries;            // Counting line crossings inwards
+    uint8_t exits;              // Counting line crossings outwards
+    uint8_t visits;             // Visits that ended in this minute
+    uint8_t reserved;
+    uint16_t check;             // Fletcher-16 of the bytes above
+} radar_history_record_t;
+
+typedef enum {
+    RADAR_HISTORY_ENTRY,
+    RADAR_HISTORY_EXIT,
+    RADAR_HISTORY_VISIT,
+} radar_history_event_t;
+
+/**
+ * @brief Called by radar_history_query() for each record in range, oldest first
+ *
+ * @return false to stop the query
+ */
+typedef bool (*radar_history_cb_t)(const radar_history_record_t *record, void *ctx);
+
+/**
+ * @brief Find the history partition and rebuild the sector index
+ *
+ * Reads one 16 byte header per sector and the records of the newest
+ * sector only. Safe to call once from app_main; without a "history"
+ * partition every other call does nothing.
+ */
+void radar_history_init(void);
+
+/**
+ * @brief Add one frame to the current minute
+ *
+ * Call from a single task, for every frame. Frames received before the
+ * clock is set are not recorded.
+ *
+ * @param frame Radar frame
+ * @param detected Number of people detected in the frame
+ * @param gap_ms Time since the previous frame, counted as occupied if detected
+ */
+void radar_history_note_frame(const radar_frame_t *frame, uint8_t detected, uint32_t gap_ms);
+
+/**
+ * @brief Count a crossing or finished visit in the current minute
+ *
+ * Call from the same task as radar_history_note_frame().
+ */
+void radar_history_note_event(radar_history_event_t event);
+
+/**
+ * @brief Close the minute once it is over and write full batches
+ *
+ * Call at least once a second from the same task as
+ * radar_history_note_frame(), also when no frames arrive.
+ */
+void radar_history_tick(void);
+
+/**
+ * @brief Write the records still held in RAM
+ *
+ * radar_analytics_save() calls this, and runs from esp_restart(); a power
+ * cut still loses up to CONFIG_RADAR_HISTORY_BATCH minutes.
+ */
+void radar_history_flush(void);
+
+/**
+ * @brief Visit the records between two minutes, oldest first
+ *
+ * Reads only the sectors whose time span overlaps the range, plus the
+ * records not yet written. Safe from any task; it holds the history lock
+ * while reading, so keep the callback short.
+ *
+ * @param from_minute First minute, inclusive
+ * @param to_minute Last minute, inclusive
+ * @param cb Called for each record
+ * @param ctx Passed to cb
+ * @return Number of flash sectors read
+ */
+int radar_history_query(uint32_t from_minute, uint32_t to_minute, radar_history_cb_t cb, void *ctx);
+
+/**
+ * @brief Current minute, or 0 while the clock is not set
+ */
+uint32_t radar_history_now_minute(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,329 @@
+/*
+ * radar_merge.c
+ * Merges target reports from several radar units into one set of tracks
+ *
+ * Each unit keeps only its latest report, already moved onto the floor
+ * plan, so taking in a report is constant time whatever the number of
+ * units. Tracks are rebuilt from those reports at the output rate.
+ */
+
+#include "radar_merge.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+#define MERGE_VERSION       1
+#define OFFSET_CREEP_SHIFT  10      // Offset follows later arrivals at 1/1024 of the gap per report
+#define RESTART_SEQ_GAP     50      // A sequence this far behind is a restarted sender
+
+static const uint8_t packet_magic[4] = {'R', 'D', 'M', 'U'};
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) {
+        *p++ = (uint8_t)(v >> (8 * i));
+    }
+    return p;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * @brief Set up a merge with no units
+ */
+void radar_merge_init(radar_merge_t *merge, uint16_t radius_mm, uint32_t max_age_ms)
+{
+    memset(merge, 0, sizeof(*merge));
+    merge->radius_mm = radius_mm;
+    merge->max_age_us = (int64_t)max_age_ms * 1000;
+}
+
+/**
+ * @brief Place a unit on the floor plan
+ */
+bool radar_merge_set_pose(radar_merge_t *merge, uint8_t unit, const radar_merge_pose_t *pose)
+{
+    if (unit >= RADAR_MERGE_MAX_UNITS) {
+        return false;
+    }
+    radar_merge_unit_t *u = &merge->units[unit];
+    float a = pose->heading_deg * PI / 180.0f;
+
+    u->configured = true;
+    u->pose = *pose;
+    u->cos_q14 = (int32_t)lroundf(cosf(a) * 16384.0f);
+    u->sin_q14 = (int32_t)lroundf(sinf(a) * 16384.0f);
+    return true;
+}
+
+/**
+ * @brief Place units from a text list
+ */
+int radar_merge_parse_poses(radar_merge_t *merge, const char *spec)
+{
+    const char *p = spec;
+    char *end;
+    int placed = 0;
+
+    while (*p) {
+        radar_merge_pose_t pose;
+        long unit = strtol(p, &end, 10);
+        if (end == p || *end != ':') {
+            return -1;
+        }
+        p = end + 1;
+        pose.x_mm = (int32_t)strtol(p, &end, 10);
+        if (end == p || *end != ',') {
+            return -1;
+        }
+        p = end + 1;
+        pose.y_mm = (int32_t)strtol(p, &end, 10);
+        if (end == p || *end != ',') {
+            return -1;
+        }
+        p = end + 1;
+        pose.heading_deg = (int16_t)strtol(p, &end, 10);
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == ';') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+        if (unit < 0 || !radar_merge_set_pose(merge, (uint8_t)unit, &pose)) {
+            return -1;
+        }
+        placed++;
+    }
+    return placed;
+}
+
+/**
+ * @brief Encode a report for sending
+ */
+size_t radar_merge_encode(const radar_merge_report_t *report, uint8_t *out)
+{
+    uint8_t *p = out;
+
+    memcpy(p, packet_magic, sizeof(packet_magic));
+    p += sizeof(packet_magic);
+    *p++ = MERGE_VERSION;
+    *p++ = report->unit;
+    p = put_u32(p, report->seq);
+    p = put_u32(p, (uint32_t)report->sent_us);
+    p = put_u32(p, (uint32_t)((uint64_t)report->sent_us >> 32));
+    *p++ = report->detected;
+    for (int s = 0; s < RADAR_MERGE_SLOTS; s++) {
+        const radar_merge_point_t *t = &report->targets[s];
+        *p++ = (uint8_t)t->x;
+        *p++ = (uint8_t)((uint16_t)t->x >> 8);
+        *p++ = (uint8_t)t->y;
+        *p++ = (uint8_t)((uint16_t)t->y >> 8);
+        *p++ = (uint8_t)t->speed;
+        *p++ = (uint8_t)((uint16_t)t->speed >> 8);
+    }
+    return (size_t)(p - out);
+}
+
+/**
+ * @brief Decode a received packet
+ */
+bool radar_merge_decode(const uint8_t *buf, size_t len, radar_merge_report_t *report)
+{
+    const uint8_t *p = buf;
+
+    if (len != RADAR_MERGE_PACKET_LEN || memcmp(p, packet_magic, sizeof(packet_magic)) != 0 ||
+        p[4] != MERGE_VERSION) {
+        return false;
+    }
+    p += sizeof(packet_magic) + 1;
+    report->unit = *p++;
+    report->seq = get_u32(p);
+    p += 4;
+    report->sent_us = (int64_t)((uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32);
+    p += 8;
+    report->detected = *p++;
+    for (int s = 0; s < RADAR_MERGE_SLOTS; s++) {
+        radar_merge_point_t *t = &report->targets[s];
+        t->x = (int16_t)(p[0] | p[1] << 8);
+        t->y = (int16_t)(p[2] | p[3] << 8);
+        t->speed = (int16_t)(p[4] | p[5] << 8);
+        p += 6;
+    }
+    return true;
+}
+
+/**
+ * @brief Take in one unit's report
+ */
+bool radar_merge_ingest(radar_merge_t *merge, const radar_merge_report_t *report, int64_t recv_us)
+{
+    if (report->unit >= RADAR_MERGE_MAX_UNITS || !merge->units[report->unit].configured) {
+        merge->rejected++;
+        return false;
+    }
+    radar_merge_unit_t *u = &merge->units[report->unit];
+    int32_t ahead = (int32_t)(report->seq - u->last_seq);
+    bool restart = u->seen && ahead < -RESTART_SEQ_GAP;
+    int64_t gap = recv_us - report->sent_us;
+
+    if (u->seen && !restart && ahead <= 0) {
+        u->out_of_order++;
+        return false;
+    }
+
+    // The smallest gap is the clock offset plus the quickest delivery
+    if (!u->seen || restart || gap < u->offset_us) {
+        u->offset_us = gap;
+    } else {
+        u->offset_us += (gap - u->offset_us) >> OFFSET_CREEP_SHIFT;
+    }
+    u->seen = true;
+    u->last_seq = report->seq;
+    u->aligned_us = report->sent_us + u->offset_us;
+    u->detected = report->detected;
+    u->reports++;
+
+    for (int s = 0; s < RADAR_MERGE_SLOTS; s++) {
+        const radar_merge_point_t *t = &report->targets[s];
+        // The unit's right and forward axes turned by its heading
+        u->world[s][0] = u->pose.x_mm + ((t->x * u->cos_q14 + t->y * u->sin_q14) >> 14);
+        u->world[s][1] = u->pose.y_mm + ((t->y * u->cos_q14 - t->x * u->sin_q14) >> 14);
+        u->speed[s] = t->speed;
+    }
+    return true;
+}
+
+static int64_t dist_sq(int32_t ax, int32_t ay, int32_t bx, int32_t by)
+{
+    int64_t dx = ax - bx;
+    int64_t dy = ay - by;
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Rebuild the tracks from the latest report of every unit
+ */
+int radar_merge_update(radar_merge_t *merge, int64_t now_us)
+{
+    const int64_t join_sq = (int64_t)merge->radius_mm * merge->radius_mm;
+    const int64_t keep_sq = join_sq * 4;
+    int32_t sum_x[RADAR_MERGE_MAX_TRACKS];
+    int32_t sum_y[RADAR_MERGE_MAX_TRACKS];
+    int32_t sum_speed[RADAR_MERGE_MAX_TRACKS];
+    int32_t cx[RADAR_MERGE_MAX_TRACKS];
+    int32_t cy[RADAR_MERGE_MAX_TRACKS];
+    uint8_t count[RADAR_MERGE_MAX_TRACKS];
+    uint16_t seen_by[RADAR_MERGE_MAX_TRACKS];
+    bool claimed[RADAR_MERGE_MAX_TRACKS] = {false};
+    int clusters = 0;
+    int64_t oldest = now_us;
+
+    // Cluster every fresh target with the nearest person another unit sees
+    for (int id = 0; id < RADAR_MERGE_MAX_UNITS; id++) {
+        const radar_merge_unit_t *u = &merge->units[id];
+        if (!u->seen || now_us - u->aligned_us > merge->max_age_us) {
+            continue;
+        }
+        for (int s = 0; s < RADAR_MERGE_SLOTS; s++) {
+            if (!((u->detected >> s) & 1)) {
+                continue;
+            }
+            int32_t x = u->world[s][0];
+            int32_t y = u->world[s][1];
+            int best = -1;
+            int64_t best_sq = join_sq;
+            for (int c = 0; c < clusters; c++) {
+                int64_t d = dist_sq(x, y, cx[c], cy[c]);
+                if (!((seen_by[c] >> id) & 1) && d <= best_sq) {
+                    best = c;
+                    best_sq = d;
+                }
+            }
+            if (best < 0) {
+                if (clusters == RADAR_MERGE_MAX_TRACKS) {
+                    continue;
+                }
+                best = clusters++;
+                sum_x[best] = sum_y[best] = sum_speed[best] = 0;
+                count[best] = 0;
+                seen_by[best] = 0;
+            }
+            sum_x[best] += x;
+            sum_y[best] += y;
+            sum_speed[best] += u->speed[s];
+            count[best]++;
+            seen_by[best] |= 1u << id;
+            cx[best] = sum_x[best] / count[best];
+            cy[best] = sum_y[best] / count[best];
+            if (u->aligned_us < oldest) {
+                oldest = u->aligned_us;
+            }
+        }
+    }
+
+    // People still near a track keep its slot
+    for (int t = 0; t < RADAR_MERGE_MAX_TRACKS; t++) {
+        radar_merge_track_t *track = &merge->tracks[t];
+        if (!track->active) {
+            continue;
+        }
+        int best = -1;
+        int64_t best_sq = keep_sq;
+        for (int c = 0; c < clusters; c++) {
+            int64_t d = dist_sq(track->x, track->y, cx[c], cy[c]);
+            if (!claimed[c] && d <= best_sq) {
+                best = c;
+                best_sq = d;
+            }
+        }
+        if (best < 0) {
+            track->active = false;
+            continue;
+        }
+        claimed[best] = true;
+        track->x = cx[best];
+        track->y = cy[best];
+        track->speed = (int16_t)(sum_speed[best] / count[best]);
+        track->units = seen_by[best];
+    }
+
+    // New people take the lowest free slots
+    int free_slot = 0;
+    for (int c = 0; c < clusters; c++) {
+        if (claimed[c]) {
+            continue;
+        }
+        while (merge->tracks[free_slot].active) {
+            free_slot++;
+        }
+        radar_merge_track_t *track = &merge->tracks[free_slot];
+        track->active = true;
+        track->x = cx[c];
+        track->y = cy[c];
+        track->speed = (int16_t)(sum_speed[c] / count[c]);
+        track->units = seen_by[c];
+    }
+
+    merge->oldest_us = oldest;
+    int highest = 0;
+    for (int t = 0; t < RADAR_MERGE_MAX_TRACKS; t++) {
+        if (merge->tracks[t].active) {
+            highest = t + 1;
+        }
+    }
+    return highest;
+}
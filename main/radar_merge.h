@@ -0,0 +1,153 @@
+/*
+ * radar_merge.h
+ * Merges target reports from several radar units into one set of tracks
+ *
+ * The merge is plain C with no ESP-IDF dependency, so the same code runs
+ * in a collector unit and in tools/radar_multi.c on a Linux host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_MERGE_SLOTS           3       // Targets per report, as the sensor sends
+#define RADAR_MERGE_MAX_UNITS       16      // Unit ids 0..15
+#define RADAR_MERGE_MAX_TRACKS      8
+#define RADAR_MERGE_PACKET_LEN      37      // Magic, version, unit, seq, time, detected, 3 targets
+#define RADAR_MERGE_DEFAULT_PORT    5005
+
+typedef struct {
+    int16_t x;                  // mm, positive to the unit's right
+    int16_t y;                  // mm, away from the unit
+    int16_t speed;              // mm/s as reported by the sensor
+} radar_merge_point_t;
+
+// One frame from one unit, as sent over UDP
+typedef struct {
+    uint8_t unit;
+    uint32_t seq;
+    int64_t sent_us;            // Sensor read time on the sender's clock
+    uint8_t detected;           // Bit per slot
+    radar_merge_point_t targets[RADAR_MERGE_SLOTS];
+} radar_merge_report_t;
+
+// Where a unit is mounted on the floor plan
+typedef struct {
+    int32_t x_mm;
+    int32_t y_mm;
+    int16_t heading_deg;        // Direction the unit faces, clockwise from the floor's +y
+} radar_merge_pose_t;
+
+typedef struct {
+    bool configured;            // Has a pose; reports from other units are rejected
+    bool seen;
+    radar_merge_pose_t pose;
+    int32_t cos_q14;
+    int32_t sin_q14;
+    uint32_t last_seq;
+    int64_t offset_us;          // Local minus sender clock, minimum filtered
+    int64_t aligned_us;         // Latest report's sensor read time on the local clock
+    uint8_t detected;
+    int32_t world[RADAR_MERGE_SLOTS][2];    // Latest targets on the floor plan, mm
+    int16_t speed[RADAR_MERGE_SLOTS];
+    uint32_t reports;
+    uint32_t out_of_order;      // Late or duplicate reports dropped
+} radar_merge_unit_t;
+
+typedef struct {
+    bool active;
+    int32_t x;                  // mm on the floor plan
+    int32_t y;
+    int16_t speed;
+    uint16_t units;             // Bit per unit that sees this person
+} radar_merge_track_t;
+
+typedef struct {
+    uint16_t radius_mm;
+    int64_t max_age_us;
+    radar_merge_unit_t units[RADAR_MERGE_MAX_UNITS];
+    radar_merge_track_t tracks[RADAR_MERGE_MAX_TRACKS];
+    int64_t oldest_us;          // Oldest report merged into the tracks
+    uint32_t rejected;          // Malformed reports and reports from unknown units
+} radar_merge_t;
+
+/**
+ * @brief Set up a merge with no units
+ *
+ * @param merge Merge state
+ * @param radius_mm Reports from different units closer than this are one person
+ * @param max_age_ms Reports older than this on the local clock are left out
+ */
+void radar_merge_init(radar_merge_t *merge, uint16_t radius_mm, uint32_t max_age_ms);
+
+/**
+ * @brief Place a unit on the floor plan
+ *
+ * @return false if the unit id is out of range
+ */
+bool radar_merge_set_pose(radar_merge_t *merge, uint8_t unit, const radar_merge_pose_t *pose);
+
+/**
+ * @brief Place units from a text list
+ *
+ * The list is "unit:x,y,heading" entries separated by semicolons, with x
+ * and y in mm and heading in degrees, e.g. "0:0,0,0;1:6000,0,-90".
+ *
+ * @return Units placed, or -1 if the list is malformed
+ */
+int radar_merge_parse_poses(radar_merge_t *merge, const char *spec);
+
+/**
+ * @brief Encode a report for sending
+ *
+ * @param out At least RADAR_MERGE_PACKET_LEN bytes
+ * @return Bytes to send
+ */
+size_t radar_merge_encode(const radar_merge_report_t *report, uint8_t *out);
+
+/**
+ * @brief Decode a received packet
+ *
+ * @return false if the packet is not a report of this version
+ */
+bool radar_merge_decode(const uint8_t *buf, size_t len, radar_merge_report_t *report);
+
+/**
+ * @brief Take in one unit's report
+ *
+ * Constant time: the report replaces the unit's previous one. The unit's
+ * clock offset is the minimum of receive minus send time seen so far,
+ * drifting up slowly so clock drift is followed; a restarted sender
+ * (sequence far behind) starts a new estimate.
+ *
+ * @param merge Merge state
+ * @param report Decoded report
+ * @param recv_us Local time the report arrived
+ * @return false if the report was rejected or dropped as late
+ */
+bool radar_merge_ingest(radar_merge_t *merge, const radar_merge_report_t *report, int64_t recv_us);
+
+/**
+ * @brief Rebuild the tracks from the latest report of every unit
+ *
+ * Targets from different units within radius_mm of a track's centre are
+ * averaged into it; targets from the same unit are always separate
+ * people. Tracks keep their slot while someone stays within twice the
+ * radius of it, and new people take the lowest free slot. Cost is linear
+ * in units times RADAR_MERGE_MAX_TRACKS.
+ *
+ * @param merge Merge state
+ * @param now_us Local time
+ * @return Highest active track slot + 1
+ */
+int radar_merge_update(radar_merge_t *merge, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,443 @@
+/*
+ * radar_mirror.c
+ * Streams the display's flushed stripes to a desktop viewer over TCP
+ *
+ * The tap sits on the display's flush events: once the flush callback
+ * has started the SPI transfer of a stripe, the same stripe is run-length
+ * coded straight into a ring buffer, so the panel never waits and no
+ * frame is copied whole. A stripe that does not fit drops the rest of
+ * its refresh and, once the viewer has caught up, only the dropped area
+ * is redrawn, so each catch-up is smaller than the last. The mirror task
+ * only moves bytes from the ring to the socket.
+ */
+
+#include "radar_mirror.h"
+#include <string.h>
+
+#define RUN_MAX         128     // Pixels per run
+#define MIN_REPEAT      3       // Shorter repeats stay inside a literal run
+
+typedef struct {
+    uint8_t *ring;
+    uint32_t mask;
+    uint32_t pos;
+    size_t room;
+    size_t len;                 // Bytes written so far
+    size_t lit_at;              // Offset of the open literal run's count byte
+    int lit_count;              // Pixels in the open literal run, 0 when none
+} encoder_t;
+
+static inline void put(encoder_t *e, uint8_t b)
+{
+    e->ring[(e->pos + e->len++) & e->mask] = b;
+}
+
+/**
+ * @brief Add one pixel to the open literal run, opening one if needed
+ */
+static bool emit_literal(encoder_t *e, uint16_t px)
+{
+    if (e->lit_count == 0) {
+        if (e->len + 3 > e->room) {
+            return false;
+        }
+        e->lit_at = e->len;
+        put(e, 0);
+    } else if (e->len + 2 > e->room) {
+        return false;
+    }
+    put(e, px & 0xFF);
+    put(e, px >> 8);
+    e->ring[(e->pos + e->lit_at) & e->mask] = (uint8_t)e->lit_count++;
+    if (e->lit_count == RUN_MAX) {
+        e->lit_count = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Emit n pixels of one value, as repeat runs if long enough
+ */
+static bool emit_run(encoder_t *e, uint16_t px, int n)
+{
+    if (n < MIN_REPEAT) {
+        while (n--) {
+            if (!emit_literal(e, px)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    e->lit_count = 0;
+    while (n > 0) {
+        int k = n > RUN_MAX ? RUN_MAX : n;
+        if (e->len + 3 > e->room) {
+            return false;
+        }
+        put(e, 0x80 | (k - 1));
+        put(e, px & 0xFF);
+        put(e, px >> 8);
+        n -= k;
+    }
+    return true;
+}
+
+/**
+ * @brief Run-length encode RGB565 pixels into a ring buffer
+ */
+size_t radar_mirror_encode(uint8_t *ring, uint32_t mask, uint32_t pos, size_t room,
+                           const uint16_t *px, int w, int h, int stride, bool swapped)
+{
+    encoder_t e = {.ring = ring, .mask = mask, .pos = pos, .room = room};
+    uint16_t run_px = 0;
+    int run_len = 0;
+
+    // Runs carry on across row ends; the rect is one stream of w * h pixels
+    for (int y = 0; y < h; y++) {
+        const uint16_t *row = px + y * stride;
+        for (int x = 0; x < w; x++) {
+            uint16_t p = swapped ? (uint16_t)(row[x] << 8 | row[x] >> 8) : row[x];
+            if (run_len && p == run_px) {
+                run_len++;
+                continue;
+            }
+            if (run_len && !emit_run(&e, run_px, run_len)) {
+                return 0;
+            }
+            run_px = p;
+            run_len = 1;
+        }
+    }
+    if (run_len && !emit_run(&e, run_px, run_len)) {
+        return 0;
+    }
+    return e.len;
+}
+
+/**
+ * @brief Decode the runs of one rect
+ */
+bool radar_mirror_decode(const uint8_t *in, size_t len, uint16_t *out, size_t count)
+{
+    size_t i = 0;
+    size_t n = 0;
+
+    while (i < len) {
+        uint8_t token = in[i++];
+        size_t k = (token & 0x7F) + 1;
+        if (n + k > count) {
+            return false;
+        }
+        if (token & 0x80) {
+            if (i + 2 > len) {
+                return false;
+            }
+            uint16_t px = in[i] | in[i + 1] << 8;
+            i += 2;
+            while (k--) {
+                out[n++] = px;
+            }
+        } else {
+            if (i + 2 * k > len) {
+                return false;
+            }
+            while (k--) {
+                out[n++] = in[i] | in[i + 1] << 8;
+                i += 2;
+            }
+        }
+    }
+    return n == count;
+}
+
+#if defined(ESP_PLATFORM) && CONFIG_RADAR_MIRROR
+
+#include "bsp/esp-bsp.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radar_budget.h"
+#include "sdkconfig.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char *TAG = "RadarMirror";
+
+#define RING_SIZE       (CONFIG_RADAR_MIRROR_BUF_KB * 1024)
+#define RING_MASK       (RING_SIZE - 1)
+#define SWAP_SAMPLES    16      // Pixels compared to see whether the flush swapped bytes
+
+_Static_assert((RING_SIZE & RING_MASK) == 0, "mirror buffer must be a power of two");
+
+static lv_display_t *mirror_disp = NULL;
+static TaskHandle_t mirror_task_handle = NULL;
+static uint8_t ring[RING_SIZE];
+static _Atomic uint32_t head = 0;           // Advanced by the LVGL task
+static _Atomic uint32_t tail = 0;           // Advanced by the mirror task
+static _Atomic bool connected = false;
+static _Atomic uint32_t frames = 0;
+static _Atomic uint32_t dropped = 0;
+
+// LVGL task only
+static bool dropping = false;               // The rest of this refresh is dropped
+static bool resync = false;                 // Redraw the lost area once the viewer catches up
+static lv_area_t lost;                      // Bounding box of the dropped stripes
+static uint32_t frame_rects = 0;
+static int8_t swapped = -1;                 // -1 not known yet, 0 native, 1 byte swapped
+static uint16_t samples[SWAP_SAMPLES];
+static int sample_count = 0;
+
+static uint32_t ring_put_u16(uint32_t pos, uint16_t v)
+{
+    ring[pos & RING_MASK] = v & 0xFF;
+    ring[(pos + 1) & RING_MASK] = v >> 8;
+    return pos + 2;
+}
+
+static uint32_t ring_put_u32(uint32_t pos, uint32_t v)
+{
+    pos = ring_put_u16(pos, v & 0xFFFF);
+    return ring_put_u16(pos, v >> 16);
+}
+
+/**
+ * @brief Whether the flush callback swapped the stripe's bytes for the panel
+ *
+ * Pixels with equal high and low bytes look the same either way, so the
+ * answer may take a few stripes; until then pixels are taken as native.
+ */
+static void detect_swap(const uint16_t *px, int count)
+{
+    for (int i = 0; i < sample_count && i < count; i++) {
+        uint16_t before = samples[i];
+        if ((before >> 8) == (before & 0xFF)) {
+            continue;
+        }
+        swapped = px[i] == before ? 0 : 1;
+        ESP_LOGI(TAG, "Flushed pixels are %s", swapped ? "byte swapped" : "native");
+        return;
+    }
+}
+
+/**
+ * @brief Remember a stripe the viewer did not get
+ */
+static void lose_stripe(const lv_area_t *area)
+{
+    if (!resync) {
+        lost = *area;
+        resync = true;
+    } else {
+        lost.x1 = LV_MIN(lost.x1, area->x1);
+        lost.y1 = LV_MIN(lost.y1, area->y1);
+        lost.x2 = LV_MAX(lost.x2, area->x2);
+        lost.y2 = LV_MAX(lost.y2, area->y2);
+    }
+}
+
+/**
+ * @brief Code one flushed stripe into the ring
+ */
+static void capture_stripe(const lv_area_t *area)
+{
+    const uint16_t *px = (const uint16_t *)lv_display_get_buf_active(mirror_disp)->data;
+    int w = lv_area_get_width(area);
+    int h = lv_area_get_height(area);
+    int stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565) / sizeof(uint16_t);
+
+    if (swapped < 0) {
+        detect_swap(px, w);
+    }
+
+    // Keep room for the refresh's frame message
+    uint32_t pos = atomic_load(&head);
+    uint32_t free_bytes = RING_SIZE - (pos - atomic_load(&tail));
+    size_t len = 0;
+    if (free_bytes > RADAR_MIRROR_RECT_LEN + RADAR_MIRROR_FRAME_LEN) {
+        len = radar_mirror_encode(ring, RING_MASK, pos + RADAR_MIRROR_RECT_LEN,
+                                  free_bytes - RADAR_MIRROR_RECT_LEN - RADAR_MIRROR_FRAME_LEN,
+                                  px, w, h, stride, swapped == 1);
+    }
+    if (len == 0) {
+        dropping = true;
+        lose_stripe(area);
+        atomic_fetch_add(&dropped, 1);
+        return;
+    }
+
+    ring[pos & RING_MASK] = RADAR_MIRROR_MSG_RECT;
+    uint32_t p = ring_put_u16(pos + 1, area->x1);
+    p = ring_put_u16(p, area->y1);
+    p = ring_put_u16(p, w);
+    p = ring_put_u16(p, h);
+    ring_put_u32(p, len);
+    atomic_store(&head, pos + RADAR_MIRROR_RECT_LEN + len);
+    frame_rects++;
+}
+
+/**
+ * @brief Close the refresh with a frame message and wake the mirror task
+ */
+static void finish_frame(void)
+{
+    uint32_t pos = atomic_load(&head);
+
+    if (frame_rects && RING_SIZE - (pos - atomic_load(&tail)) >= RADAR_MIRROR_FRAME_LEN) {
+        ring[pos & RING_MASK] = RADAR_MIRROR_MSG_FRAME;
+        uint32_t p = ring_put_u32(pos + 1, atomic_fetch_add(&frames, 1) + 1);
+        ring_put_u32(p, atomic_load(&dropped));
+        atomic_store(&head, pos + RADAR_MIRROR_FRAME_LEN);
+        xTaskNotifyGive(mirror_task_handle);
+    }
+    frame_rects = 0;
+    dropping = false;
+
+    // After a drop part of the viewer's picture is stale; redraw just that part
+    // once there is room. Whatever of it fits is sent, so a screen too big for
+    // the ring still arrives over a few refreshes instead of never.
+    if (resync && RING_SIZE - (atomic_load(&head) - atomic_load(&tail)) > RING_SIZE / 2) {
+        resync = false;
+        lv_inv_area(mirror_disp, &lost);
+    }
+}
+
+/**
+ * @brief Display event tap
+ */
+static void mirror_event_cb(lv_event_t *e)
+{
+    if (!atomic_load(&connected)) {
+        return;
+    }
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_FLUSH_START:
+        // Before the flush callback: remember a few pixels to spot a byte swap
+        if (swapped < 0) {
+            const lv_area_t *area = lv_event_get_param(e);
+            const uint16_t *px = (const uint16_t *)lv_display_get_buf_active(mirror_disp)->data;
+            sample_count = LV_MIN(lv_area_get_width(area), SWAP_SAMPLES);
+            memcpy(samples, px, sample_count * sizeof(uint16_t));
+        }
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+        // The flush callback has started the transfer; coding overlaps it
+        if (!dropping) {
+            capture_stripe(lv_event_get_param(e));
+        } else {
+            lose_stripe(lv_event_get_param(e));
+        }
+        break;
+    case LV_EVENT_REFR_READY:
+        finish_frame();
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Send ring contents to one viewer until it leaves or stalls
+ */
+static void serve_viewer(int sock)
+{
+    uint8_t hello[RADAR_MIRROR_HELLO_LEN] = {'R', 'D', 'M', 'R', RADAR_MIRROR_VERSION, 0};
+    int32_t w = lv_display_get_horizontal_resolution(mirror_disp);
+    int32_t h = lv_display_get_vertical_resolution(mirror_disp);
+
+    hello[6] = w & 0xFF;
+    hello[7] = w >> 8;
+    hello[8] = h & 0xFF;
+    hello[9] = h >> 8;
+    if (send(sock, hello, sizeof(hello), 0) != sizeof(hello)) {
+        return;
+    }
+
+    atomic_store(&tail, atomic_load(&head));
+    atomic_store(&frames, 0);
+    atomic_store(&dropped, 0);
+    atomic_store(&connected, true);
+    bsp_display_lock(0);
+    lv_obj_invalidate(lv_display_get_screen_active(mirror_disp));
+    bsp_display_unlock();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        uint32_t end = atomic_load(&head);
+        uint32_t pos = atomic_load(&tail);
+        while (pos != end) {
+            uint32_t chunk = LV_MIN(end - pos, RING_SIZE - (pos & RING_MASK));
+            int sent = send(sock, ring + (pos & RING_MASK), chunk, 0);
+            if (sent <= 0) {
+                atomic_store(&connected, false);
+                return;
+            }
+            pos += sent;
+            atomic_store(&tail, pos);
+        }
+    }
+}
+
+/**
+ * @brief Mirror task, one viewer at a time
+ */
+static void mirror_task(void *pvParameters)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_RADAR_MIRROR_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    int listener = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener, 1) != 0) {
+        ESP_LOGE(TAG, "Cannot listen on TCP port %d: errno %d", CONFIG_RADAR_MIRROR_PORT, errno);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI(TAG, "Listening on TCP port %d, %d KB buffer", CONFIG_RADAR_MIRROR_PORT,
+             CONFIG_RADAR_MIRROR_BUF_KB);
+
+    while (1) {
+        int sock = accept(listener, NULL, NULL);
+        if (sock < 0) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        int one = 1;
+        // A viewer that stops reading for this long is dropped
+        struct timeval timeout = {.tv_sec = 5};
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        ESP_LOGI(TAG, "Viewer connected");
+
+        serve_viewer(sock);
+        close(sock);
+        ESP_LOGI(TAG, "Viewer left after %" PRIu32 " frames, %" PRIu32 " dropped",
+                 atomic_load(&frames), atomic_load(&dropped));
+    }
+}
+
+/**
+ * @brief Serve the display mirror on CONFIG_RADAR_MIRROR_PORT
+ */
+void radar_mirror_start(lv_display_t *disp)
+{
+    if (mirror_disp) {
+        return;
+    }
+    mirror_disp = disp;
+    bsp_display_lock(0);
+    lv_display_add_event_cb(disp, mirror_event_cb, LV_EVENT_FLUSH_START, NULL);
+    lv_display_add_event_cb(disp, mirror_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+    lv_display_add_event_cb(disp, mirror_event_cb, LV_EVENT_REFR_READY, NULL);
+    bsp_display_unlock();
+    RADAR_TASK_CREATE(mirror_task, "Display Mirror", 3072, NULL, 2, 0);
+    mirror_task_handle = xTaskGetHandle("Display Mirror");
+}
+
+#endif // CONFIG_RADAR_MIRROR
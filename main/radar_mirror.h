@@ -0,0 +1,87 @@
+/*
+ * radar_mirror.h
+ * Streams the display's flushed stripes to a desktop viewer over TCP
+ *
+ * The run-length coder is plain C with no ESP-IDF dependency, so the
+ * same code encodes on the device and encodes and decodes in
+ * tools/mirror_test.c on a Linux host.
+ *
+ * Stream, all values little endian:
+ *   hello   "RDMR", u8 version, u8 pixel format (0 = RGB565), u16 width, u16 height
+ *   rect    u8 1, u16 x, u16 y, u16 w, u16 h, u32 length, length bytes of runs
+ *   frame   u8 2, u32 frame number, u32 frames dropped so far
+ * A rect's runs cover its pixels row by row. Each run starts with a
+ * byte n: with bit 7 set, one pixel follows and repeats (n & 0x7F) + 1
+ * times; otherwise n + 1 literal pixels follow. Pixels are RGB565. A
+ * frame message follows the rects of each display refresh.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_MIRROR_VERSION        1
+#define RADAR_MIRROR_HELLO_LEN      10
+#define RADAR_MIRROR_RECT_LEN       13      // Rect message before its runs
+#define RADAR_MIRROR_FRAME_LEN      9
+#define RADAR_MIRROR_MSG_RECT       1
+#define RADAR_MIRROR_MSG_FRAME      2
+#define RADAR_MIRROR_DEFAULT_PORT   5006
+
+/**
+ * @brief Run-length encode RGB565 pixels into a ring buffer
+ *
+ * Writes at ring[(pos + i) & mask] and gives up as soon as the output
+ * would exceed room, so a rect either fits whole or costs nothing.
+ *
+ * @param ring Ring buffer of mask + 1 bytes, a power of two
+ * @param mask Ring size - 1
+ * @param pos Write position, not yet masked
+ * @param room Bytes that may be written
+ * @param px First pixel of the rect
+ * @param w Rect width
+ * @param h Rect height
+ * @param stride Pixels from one row to the next
+ * @param swapped Pixels are byte swapped, as sent to an SPI panel
+ * @return Bytes written, or 0 if the runs did not fit in room
+ */
+size_t radar_mirror_encode(uint8_t *ring, uint32_t mask, uint32_t pos, size_t room,
+                           const uint16_t *px, int w, int h, int stride, bool swapped);
+
+/**
+ * @brief Decode the runs of one rect
+ *
+ * @param in Runs
+ * @param len Bytes of runs
+ * @param out Filled row by row, count pixels
+ * @param count Pixels in the rect
+ * @return false if the runs are malformed or do not cover exactly count pixels
+ */
+bool radar_mirror_decode(const uint8_t *in, size_t len, uint16_t *out, size_t count);
+
+#ifdef ESP_PLATFORM
+
+#include "lvgl.h"
+
+/**
+ * @brief Serve the display mirror on CONFIG_RADAR_MIRROR_PORT
+ *
+ * Taps the display's flushes; nothing is captured until a viewer
+ * connects, and a new viewer gets a full redraw. Call with the network
+ * up; takes the display lock itself.
+ *
+ * @param disp Display to mirror
+ */
+void radar_mirror_start(lv_display_t *disp);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,229 @@
+/*
+ * radar_mqtt.c
+ * Presence, count and target positions to an MQTT broker
+ *
+ * The publisher task takes the latest bus frame, runs it through the
+ * presence detector and queues what changed. The queue holds at most one
+ * message per topic: a newer value for a topic still waiting replaces it
+ * in place, so a backed-up broker only ever sees the latest state. While
+ * the broker is away nothing is sent; on reconnecting the queue is
+ * cleared and every topic is sent again, as retained state must be.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_RADAR_MQTT
+
+#include "radar_mqtt.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mqtt_client.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_presence.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "RadarMqtt";
+
+#define QUEUE_LEN           CONFIG_RADAR_MQTT_QUEUE_LEN
+#define TICK_MS             100
+#define STATS_PERIOD_US     (60 * 1000000LL)
+
+static esp_mqtt_client_handle_t client = NULL;
+static _Atomic bool connected = false;
+static _Atomic bool reconnected = false;
+static char status_topic[RADAR_PRESENCE_TOPIC_LEN];
+
+// Publisher task only
+static radar_presence_t presence;
+static radar_presence_msg_t batch[RADAR_PRESENCE_MAX_MSGS];
+static radar_presence_msg_t queue[QUEUE_LEN];
+static uint32_t queue_head = 0;
+static uint32_t queue_tail = 0;
+
+// Written by the publisher task, read for logging from any task under stats_lock
+static uint32_t sent = 0;
+static uint32_t coalesced = 0;
+static uint32_t dropped = 0;
+static uint32_t failed = 0;
+static uint32_t latency_max_us = 0;
+static uint64_t latency_sum_us = 0;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Queue a message, replacing a waiting one for the same topic
+ */
+static void queue_push(const radar_presence_msg_t *msg)
+{
+    for (uint32_t i = queue_tail; i != queue_head; i++) {
+        radar_presence_msg_t *waiting = &queue[i % QUEUE_LEN];
+        if (strcmp(waiting->topic, msg->topic) == 0) {
+            // The waiting message's change came first; latency counts from it
+            int64_t first_us = waiting->frame_us;
+            *waiting = *msg;
+            waiting->frame_us = first_us;
+            portENTER_CRITICAL(&stats_lock);
+            coalesced++;
+            portEXIT_CRITICAL(&stats_lock);
+            return;
+        }
+    }
+    if (queue_head - queue_tail == QUEUE_LEN) {
+        // Only with more topics than slots; resend everything once there is room
+        queue_tail++;
+        portENTER_CRITICAL(&stats_lock);
+        dropped++;
+        portEXIT_CRITICAL(&stats_lock);
+        radar_presence_resync(&presence);
+    }
+    queue[queue_head++ % QUEUE_LEN] = *msg;
+}
+
+/**
+ * @brief Send queued messages until the queue is empty or a send fails
+ */
+static void queue_drain(void)
+{
+    while (queue_tail != queue_head && atomic_load(&connected)) {
+        const radar_presence_msg_t *msg = &queue[queue_tail % QUEUE_LEN];
+        if (esp_mqtt_client_publish(client, msg->topic, msg->payload, msg->payload_len, 0, 1) < 0) {
+            portENTER_CRITICAL(&stats_lock);
+            failed++;
+            portEXIT_CRITICAL(&stats_lock);
+            return;
+        }
+        // From the frame that first made the change, so coalescing is included
+        uint32_t latency_us = (uint32_t)(esp_timer_get_time() - msg->frame_us);
+        portENTER_CRITICAL(&stats_lock);
+        if (latency_us > latency_max_us) {
+            latency_max_us = latency_us;
+        }
+        latency_sum_us += latency_us;
+        sent++;
+        portEXIT_CRITICAL(&stats_lock);
+        queue_tail++;
+    }
+}
+
+/**
+ * @brief Client events: announce ourselves and resync on every connect
+ */
+static void mqtt_event_handler(void *args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    switch ((esp_mqtt_event_id_t)event_id) {
+    case MQTT_EVENT_CONNECTED:
+        esp_mqtt_client_publish(client, status_topic, "online", 0, 1, 1);
+        atomic_store(&reconnected, true);
+        atomic_store(&connected, true);
+        ESP_LOGI(TAG, "Connected to %s", CONFIG_RADAR_MQTT_URI);
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        atomic_store(&connected, false);
+        ESP_LOGW(TAG, "Disconnected, retrying");
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Publisher task, turns bus frames into queued messages and sends them
+ */
+static void mqtt_task(void *pvParameters)
+{
+    radar_bus_sub_t *sub = radar_bus_subscribe("mqtt", RADAR_BUS_LATEST_ONLY, 1, 1);
+    radar_presence_point_t targets[RADAR_PRESENCE_TARGETS];
+
+    if (sub == NULL) {
+        ESP_LOGE(TAG, "No bus subscriber slot left");
+        vTaskDelete(NULL);
+    }
+
+    int64_t next_log_us = esp_timer_get_time() + STATS_PERIOD_US;
+    while (1) {
+        const radar_frame_t *frame = radar_bus_receive(sub, pdMS_TO_TICKS(TICK_MS));
+        int64_t now_ms = esp_timer_get_time() / 1000;
+
+        if (frame) {
+            for (int i = 0; i < RADAR_PRESENCE_TARGETS && i < RADAR_MAX_TARGETS; i++) {
+                targets[i].x = frame->targets[i].x;
+                targets[i].y = frame->targets[i].y;
+                targets[i].speed = frame->targets[i].speed;
+            }
+            radar_presence_update(&presence, frame->timestamp_us, frame->detected, targets, now_ms);
+            radar_bus_release(sub, frame);
+        } else {
+            radar_presence_tick(&presence, now_ms);
+        }
+
+        if (atomic_exchange(&reconnected, false)) {
+            queue_tail = queue_head;
+            radar_presence_resync(&presence);
+        }
+        int n = radar_presence_flush(&presence, now_ms, batch);
+        for (int i = 0; i < n; i++) {
+            queue_push(&batch[i]);
+        }
+        queue_drain();
+
+        if (esp_timer_get_time() >= next_log_us) {
+            next_log_us += STATS_PERIOD_US;
+            radar_mqtt_log_stats();
+        }
+    }
+}
+
+void radar_mqtt_start(void)
+{
+    if (client) {
+        return;
+    }
+    snprintf(status_topic, sizeof(status_topic), "%s/status", CONFIG_RADAR_MQTT_PREFIX);
+    radar_presence_init(&presence, CONFIG_RADAR_MQTT_PREFIX, CONFIG_RADAR_MQTT_INTERVAL_MS,
+                        CONFIG_RADAR_MQTT_HOLD_MS, CONFIG_RADAR_MQTT_MOVE_MM);
+
+    const esp_mqtt_client_config_t config = {
+        .broker.address.uri = CONFIG_RADAR_MQTT_URI,
+        .session.last_will = {
+            .topic = status_topic,
+            .msg = "offline",
+            .qos = 1,
+            .retain = 1,
+        },
+    };
+    client = esp_mqtt_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Cannot create the MQTT client");
+        return;
+    }
+    esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    esp_mqtt_client_start(client);
+
+    RADAR_TASK_CREATE(mqtt_task, "MQTT Publisher", 3072, NULL, 3, 0);
+    ESP_LOGI(TAG, "Publishing to %s under %s/", CONFIG_RADAR_MQTT_URI, CONFIG_RADAR_MQTT_PREFIX);
+}
+
+void radar_mqtt_log_stats(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    uint32_t n = sent;
+    uint32_t n_coalesced = coalesced;
+    uint32_t n_dropped = dropped;
+    uint32_t n_failed = failed;
+    uint32_t max_us = latency_max_us;
+    uint64_t sum_us = latency_sum_us;
+    portEXIT_CRITICAL(&stats_lock);
+    uint32_t avg_us = n ? (uint32_t)(sum_us / n) : 0;
+
+    ESP_LOGI(TAG, "%s, %" PRIu32 " frames, sent %" PRIu32 " coalesced %" PRIu32 " dropped %" PRIu32
+             " failed %" PRIu32 ", latency avg %" PRIu32 " us max %" PRIu32 " us",
+             atomic_load(&connected) ? "connected" : "disconnected", presence.frames,
+             n, n_coalesced, n_dropped, n_failed, avg_us, max_us);
+}
+
+#endif // CONFIG_RADAR_MQTT
@@ -0,0 +1,32 @@
+/*
+ * radar_mqtt.h
+ * Presence, count and target positions to an MQTT broker
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Connect to the broker and start the publisher task
+ *
+ * Publishes the topics described in radar_presence.h under
+ * CONFIG_RADAR_MQTT_PREFIX, retained at QoS 0, plus "status" as
+ * "online", with "offline" as the last will. Only changes are sent, at
+ * most once per CONFIG_RADAR_MQTT_INTERVAL_MS. The publisher takes the
+ * latest bus frame only and keeps its messages in a fixed queue, so a
+ * slow or missing broker never holds up the radar task. Call after the
+ * network is up and before start_mmwave().
+ */
+void radar_mqtt_start(void);
+
+/**
+ * @brief Log messages sent, coalesced, dropped and failed, and the latency
+ */
+void radar_mqtt_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,317 @@
+/*
+ * radar_multi.c
+ * Several radar units on one floor: peers send frames, a collector merges
+ *
+ * Peers send each bus frame as one UDP datagram stamped with the sensor
+ * read time on their own clock. The collector's receive task takes them
+ * in as they arrive and, at CONFIG_RADAR_MULTI_HZ, rebuilds the merged
+ * tracks and publishes them as an ordinary frame, so every bus consumer
+ * works unchanged on the consolidated picture.
+ */
+
+#include "radar_multi.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_merge.h"
+#include "sdkconfig.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#if !CONFIG_RADAR_MULTI_OFF
+
+static const char *TAG = "RadarMulti";
+
+#define STATS_PERIOD_US     (60 * 1000000LL)
+
+/**
+ * @brief Fill a report from a bus frame
+ */
+static void report_from_frame(radar_merge_report_t *report, const radar_frame_t *frame, uint32_t seq)
+{
+    memset(report, 0, sizeof(*report));
+    report->unit = CONFIG_RADAR_UNIT_ID;
+    report->seq = seq;
+    report->sent_us = frame->timestamp_us;
+    report->detected = frame->detected;
+    for (int s = 0; s < RADAR_MERGE_SLOTS && s < RADAR_MAX_TARGETS; s++) {
+        report->targets[s].x = frame->targets[s].x;
+        report->targets[s].y = frame->targets[s].y;
+        report->targets[s].speed = frame->targets[s].speed;
+    }
+}
+
+#endif
+
+#if CONFIG_RADAR_MULTI_PEER
+
+/**
+ * @brief Peer task, sends every frame to the collector
+ */
+static void peer_task(void *pvParameters)
+{
+    radar_bus_sub_t *sub = radar_bus_subscribe("Multi Peer", RADAR_BUS_LATEST_ONLY, 1, 1);
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo *collector = NULL;
+    char port[8];
+    uint8_t packet[RADAR_MERGE_PACKET_LEN];
+    radar_merge_report_t report;
+    uint32_t sent = 0;
+    uint32_t failed = 0;
+
+    if (sub == NULL) {
+        ESP_LOGE(TAG, "No bus subscriber slot left");
+        vTaskDelete(NULL);
+    }
+    snprintf(port, sizeof(port), "%d", CONFIG_RADAR_MULTI_PORT);
+    while (getaddrinfo(CONFIG_RADAR_MULTI_COLLECTOR_HOST, port, &hints, &collector) != 0) {
+        ESP_LOGW(TAG, "Cannot resolve collector %s, retrying", CONFIG_RADAR_MULTI_COLLECTOR_HOST);
+        vTaskDelay(pdMS_TO_TICKS(5000));
+    }
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Socket failed: errno %d", errno);
+        freeaddrinfo(collector);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI(TAG, "Unit %d sending to %s:%d", CONFIG_RADAR_UNIT_ID,
+             CONFIG_RADAR_MULTI_COLLECTOR_HOST, CONFIG_RADAR_MULTI_PORT);
+
+    int64_t next_log_us = esp_timer_get_time() + STATS_PERIOD_US;
+    while (1) {
+        const radar_frame_t *frame = radar_bus_receive(sub, portMAX_DELAY);
+        if (frame == NULL) {
+            continue;
+        }
+        report_from_frame(&report, frame, frame->seq);
+        radar_bus_release(sub, frame);
+
+        size_t len = radar_merge_encode(&report, packet);
+        if (sendto(sock, packet, len, 0, collector->ai_addr, collector->ai_addrlen) == (int)len) {
+            sent++;
+        } else {
+            failed++;
+        }
+
+        if (esp_timer_get_time() >= next_log_us) {
+            next_log_us += STATS_PERIOD_US;
+            ESP_LOGI(TAG, "%" PRIu32 " reports sent, %" PRIu32 " failed", sent, failed);
+        }
+    }
+}
+
+void radar_multi_start(void)
+{
+    RADAR_TASK_CREATE(peer_task, "Multi Peer", 3072, NULL, 3, 0);
+}
+
+#elif CONFIG_RADAR_MULTI_COLLECTOR
+
+static radar_merge_t merge;
+static SemaphoreHandle_t lock = NULL;
+static StaticSemaphore_t lock_buf;
+static uint32_t local_seq = 0;
+
+/**
+ * @brief Hand the collector's own sensor frame to the merge
+ */
+void radar_multi_local_frame(const radar_frame_t *frame)
+{
+    radar_merge_report_t report;
+
+    if (lock == NULL) {
+        // Collector not running, e.g. malformed poses: show this sensor alone
+        radar_bus_publish(frame);
+        return;
+    }
+    report_from_frame(&report, frame, ++local_seq);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    radar_merge_ingest(&merge, &report, frame->timestamp_us);
+    xSemaphoreGive(lock);
+}
+
+static int16_t clamp_mm(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+/**
+ * @brief Squared distance of a track from this unit's pose
+ */
+static int64_t track_distance_sq(const radar_merge_track_t *track)
+{
+    const radar_merge_pose_t *pose = &merge.units[CONFIG_RADAR_UNIT_ID].pose;
+    int64_t dx = track->x - pose->x_mm;
+    int64_t dy = track->y - pose->y_mm;
+
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Rebuild the tracks and publish the RADAR_MAX_TARGETS nearest this unit
+ *
+ * Active tracks can sit in any of the RADAR_MERGE_MAX_TRACKS slots, so
+ * they are compacted and sorted by distance first.
+ */
+static void publish_tracks(void)
+{
+    static radar_frame_t frame;
+    const radar_merge_track_t *active[RADAR_MERGE_MAX_TRACKS];
+    int64_t distance[RADAR_MERGE_MAX_TRACKS];
+    int count = 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    radar_merge_update(&merge, esp_timer_get_time());
+    for (int t = 0; t < RADAR_MERGE_MAX_TRACKS; t++) {
+        const radar_merge_track_t *track = &merge.tracks[t];
+        if (!track->active) {
+            continue;
+        }
+        // Insertion sort, nearest first; eight entries at most
+        int64_t d = track_distance_sq(track);
+        int i = count++;
+        while (i > 0 && distance[i - 1] > d) {
+            active[i] = active[i - 1];
+            distance[i] = distance[i - 1];
+            i--;
+        }
+        active[i] = track;
+        distance[i] = d;
+    }
+    frame.detected = 0;
+    frame.target_count = 0;
+    for (int t = 0; t < RADAR_MAX_TARGETS; t++) {
+        radar_point_t *p = &frame.targets[t];
+        if (t >= count) {
+            memset(p, 0, sizeof(*p));
+            continue;
+        }
+        p->x = clamp_mm(active[t]->x);
+        p->y = clamp_mm(active[t]->y);
+        p->speed = active[t]->speed;
+        frame.detected |= 1 << t;
+        frame.target_count = t + 1;
+    }
+    // Latency is measured from the oldest sensor read merged in
+    frame.timestamp_us = merge.oldest_us;
+    xSemaphoreGive(lock);
+
+    radar_bus_publish(&frame);
+}
+
+/**
+ * @brief Log each unit's report count, late reports, clock offset and age
+ */
+static void log_units(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int id = 0; id < RADAR_MERGE_MAX_UNITS; id++) {
+        const radar_merge_unit_t *u = &merge.units[id];
+        if (!u->configured) {
+            continue;
+        }
+        if (!u->seen) {
+            ESP_LOGW(TAG, "Unit %d: no reports", id);
+            continue;
+        }
+        ESP_LOGI(TAG, "Unit %d: %" PRIu32 " reports, %" PRIu32 " late, offset %" PRId64 " us, last %d ms ago",
+                 id, u->reports, u->out_of_order, u->offset_us, (int)((now - u->aligned_us) / 1000));
+    }
+    if (merge.rejected) {
+        ESP_LOGW(TAG, "%" PRIu32 " packets rejected", merge.rejected);
+    }
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief Collector task, takes in peer reports and publishes merged tracks
+ */
+static void collector_task(void *pvParameters)
+{
+    const int64_t period_us = 1000000 / CONFIG_RADAR_MULTI_HZ;
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONFIG_RADAR_MULTI_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    uint8_t packet[RADAR_MERGE_PACKET_LEN + 1];     // One spare byte shows oversized packets
+    radar_merge_report_t report;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "Cannot listen on UDP port %d: errno %d", CONFIG_RADAR_MULTI_PORT, errno);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGI(TAG, "Collector, unit %d, listening on UDP port %d", CONFIG_RADAR_UNIT_ID,
+             CONFIG_RADAR_MULTI_PORT);
+
+    int64_t next_us = esp_timer_get_time() + period_us;
+    int64_t next_log_us = esp_timer_get_time() + STATS_PERIOD_US;
+    while (1) {
+        // lwIP takes the timeout in whole ms, and 0 would block for good
+        int64_t wait_us = next_us - esp_timer_get_time();
+        if (wait_us >= 1000) {
+            struct timeval tv = {.tv_sec = wait_us / 1000000, .tv_usec = (long)(wait_us % 1000000)};
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            int len = recv(sock, packet, sizeof(packet), 0);
+            if (len > 0) {
+                int64_t now = esp_timer_get_time();
+                xSemaphoreTake(lock, portMAX_DELAY);
+                if (radar_merge_decode(packet, len, &report)) {
+                    radar_merge_ingest(&merge, &report, now);
+                } else {
+                    merge.rejected++;
+                }
+                xSemaphoreGive(lock);
+            }
+            continue;
+        }
+
+        next_us += period_us;
+        if (next_us < esp_timer_get_time()) {
+            next_us = esp_timer_get_time() + period_us;     // Fell behind, do not burst
+        }
+        publish_tracks();
+
+        if (esp_timer_get_time() >= next_log_us) {
+            next_log_us += STATS_PERIOD_US;
+            log_units();
+        }
+    }
+}
+
+void radar_multi_start(void)
+{
+    radar_merge_init(&merge, CONFIG_RADAR_MULTI_RADIUS_MM, CONFIG_RADAR_MULTI_MAX_AGE_MS);
+    int placed = radar_merge_parse_poses(&merge, CONFIG_RADAR_MULTI_POSES);
+    if (placed < 0) {
+        ESP_LOGE(TAG, "Malformed unit poses \"%s\", collector not started, showing this unit only",
+                 CONFIG_RADAR_MULTI_POSES);
+        return;
+    }
+    if (!merge.units[CONFIG_RADAR_UNIT_ID].configured) {
+        ESP_LOGW(TAG, "No pose for this unit (%d), its own frames are ignored", CONFIG_RADAR_UNIT_ID);
+    }
+    ESP_LOGI(TAG, "%d unit poses, merge radius %d mm", placed, CONFIG_RADAR_MULTI_RADIUS_MM);
+
+    lock = xSemaphoreCreateMutexStatic(&lock_buf);
+    RADAR_TASK_CREATE(collector_task, "Multi Collector", 4096, NULL, 5, 0);
+}
+
+#else
+
+void radar_multi_start(void)
+{
+}
+
+#endif
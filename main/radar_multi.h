@@ -0,0 +1,38 @@
+/*
+ * radar_multi.h
+ * Several radar units on one floor: peers send frames, a collector merges
+ */
+
+#pragma once
+
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the multi-unit role set in menuconfig
+ *
+ * A peer sends every bus frame to the collector over UDP. A collector
+ * receives the peers' frames, merges them with its own and publishes the
+ * merged tracks on the frame bus, where the display and the dashboard
+ * pick them up. Does nothing for a standalone unit. Call after the
+ * network is up.
+ */
+void radar_multi_start(void);
+
+/**
+ * @brief Hand the collector's own sensor frame to the merge
+ *
+ * Called from the radar task in place of radar_bus_publish() when the
+ * unit is a collector; only built in that role. If the collector did
+ * not start, the frame is published as it is.
+ *
+ * @param frame Frame from the local sensor
+ */
+void radar_multi_local_frame(const radar_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,219 @@
+/*
+ * radar_presence.c
+ * Turns radar frames into change-only presence and target messages
+ *
+ * Two views are kept: what the topics should say, following the frames
+ * with hysteresis on every drop, and what was last sent. A flush compares
+ * the two and serialises the differences into the caller's fixed slots.
+ */
+
+#include "radar_presence.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Topic indices for changed_us: presence, count, then one per target
+#define TOPIC_PRESENCE      0
+#define TOPIC_COUNT         1
+#define TOPIC_TARGET(i)     (2 + (i))
+
+/**
+ * @brief Set up a detector; every topic is sent at the first flush
+ */
+void radar_presence_init(radar_presence_t *p, const char *prefix, uint32_t interval_ms,
+                         uint32_t hold_ms, uint16_t move_mm)
+{
+    memset(p, 0, sizeof(*p));
+    snprintf(p->prefix, sizeof(p->prefix), "%s", prefix);
+    p->interval_ms = interval_ms;
+    p->hold_ms = hold_ms;
+    p->move_mm = move_mm;
+    p->resync = true;
+    p->count_low_ms = -1;
+    for (int i = 0; i < RADAR_PRESENCE_TARGETS; i++) {
+        p->lost_ms[i] = -1;
+    }
+    for (int i = 0; i < RADAR_PRESENCE_MAX_MSGS; i++) {
+        p->changed_us[i] = -1;
+    }
+    p->last_flush_ms = -(int64_t)interval_ms;
+}
+
+/**
+ * @brief Whether a topic should say something other than what was last sent
+ */
+static bool topic_changed(const radar_presence_t *p, int topic)
+{
+    const radar_presence_view_t *want = &p->want;
+    const radar_presence_view_t *sent = &p->sent;
+
+    if (topic == TOPIC_PRESENCE) {
+        return want->presence != sent->presence;
+    }
+    if (topic == TOPIC_COUNT) {
+        return want->count != sent->count;
+    }
+
+    int i = topic - TOPIC_TARGET(0);
+    uint8_t bit = 1 << i;
+    bool now_on = want->detected & bit;
+    bool was_on = sent->detected & bit;
+    const radar_presence_point_t *t = &want->targets[i];
+    const radar_presence_point_t *s = &sent->targets[i];
+
+    return now_on != was_on ||
+           (now_on && (abs(t->x - s->x) > p->move_mm || abs(t->y - s->y) > p->move_mm));
+}
+
+/**
+ * @brief Stamp topics that just started to differ with the latest frame time
+ *
+ * A change that went back before the flush loses its stamp.
+ */
+static void note_changes(radar_presence_t *p)
+{
+    for (int topic = 0; topic < RADAR_PRESENCE_MAX_MSGS; topic++) {
+        if (!topic_changed(p, topic)) {
+            p->changed_us[topic] = -1;
+        } else if (p->changed_us[topic] < 0) {
+            p->changed_us[topic] = p->frame_us;
+        }
+    }
+}
+
+/**
+ * @brief Take in one frame
+ */
+void radar_presence_update(radar_presence_t *p, int64_t frame_us, uint8_t detected,
+                           const radar_presence_point_t *targets, int64_t now_ms)
+{
+    radar_presence_view_t *want = &p->want;
+
+    detected &= (1 << RADAR_PRESENCE_TARGETS) - 1;
+    p->frames++;
+    p->frame_us = frame_us;
+    p->count_now = (uint8_t)__builtin_popcount(detected);
+
+    // Rises are taken at once; drops start their hold time
+    if (detected) {
+        want->presence = true;
+        p->present_ms = now_ms;
+    }
+    if (p->count_now >= want->count) {
+        want->count = p->count_now;
+        p->count_low_ms = -1;
+    } else if (p->count_low_ms < 0) {
+        p->count_low_ms = now_ms;
+    }
+    for (int i = 0; i < RADAR_PRESENCE_TARGETS; i++) {
+        uint8_t bit = 1 << i;
+        if (detected & bit) {
+            want->detected |= bit;
+            want->targets[i] = targets[i];
+            p->lost_ms[i] = -1;
+        } else if ((want->detected & bit) && p->lost_ms[i] < 0) {
+            p->lost_ms[i] = now_ms;
+        }
+    }
+
+    radar_presence_tick(p, now_ms);
+}
+
+/**
+ * @brief Let hold times run out while no frames arrive
+ */
+void radar_presence_tick(radar_presence_t *p, int64_t now_ms)
+{
+    radar_presence_view_t *want = &p->want;
+
+    if (want->presence && p->count_now == 0 && now_ms - p->present_ms >= p->hold_ms) {
+        want->presence = false;
+    }
+    if (p->count_low_ms >= 0 && now_ms - p->count_low_ms >= p->hold_ms) {
+        want->count = p->count_now;
+        p->count_low_ms = -1;
+    }
+    for (int i = 0; i < RADAR_PRESENCE_TARGETS; i++) {
+        if (p->lost_ms[i] >= 0 && now_ms - p->lost_ms[i] >= p->hold_ms) {
+            want->detected &= ~(1 << i);
+            p->lost_ms[i] = -1;
+        }
+    }
+    note_changes(p);
+}
+
+/**
+ * @brief Send every topic at the next flush, e.g. after reconnecting
+ */
+void radar_presence_resync(radar_presence_t *p)
+{
+    p->resync = true;
+}
+
+static radar_presence_msg_t *start_msg(radar_presence_t *p, radar_presence_msg_t *msg, int index,
+                                       const char *topic)
+{
+    snprintf(msg->topic, sizeof(msg->topic), "%s/%s", p->prefix, topic);
+    // A resync of an unchanged topic has no change to date it from
+    msg->frame_us = p->changed_us[index] >= 0 ? p->changed_us[index] : p->frame_us;
+    p->changed_us[index] = -1;
+    return msg;
+}
+
+static void set_payload(radar_presence_msg_t *msg, int len)
+{
+    msg->payload_len = (uint16_t)(len < (int)sizeof(msg->payload) ? len : (int)sizeof(msg->payload) - 1);
+}
+
+/**
+ * @brief Serialise what changed since the last flush
+ */
+int radar_presence_flush(radar_presence_t *p, int64_t now_ms, radar_presence_msg_t *out)
+{
+    const radar_presence_view_t *want = &p->want;
+    radar_presence_view_t *sent = &p->sent;
+    int n = 0;
+
+    if (now_ms - p->last_flush_ms < p->interval_ms) {
+        return 0;
+    }
+
+    if (p->resync || topic_changed(p, TOPIC_PRESENCE)) {
+        radar_presence_msg_t *msg = start_msg(p, &out[n++], TOPIC_PRESENCE, "presence");
+        set_payload(msg, snprintf(msg->payload, sizeof(msg->payload), "%s", want->presence ? "ON" : "OFF"));
+        sent->presence = want->presence;
+    }
+    if (p->resync || topic_changed(p, TOPIC_COUNT)) {
+        radar_presence_msg_t *msg = start_msg(p, &out[n++], TOPIC_COUNT, "count");
+        set_payload(msg, snprintf(msg->payload, sizeof(msg->payload), "%u", want->count));
+        sent->count = want->count;
+    }
+    for (int i = 0; i < RADAR_PRESENCE_TARGETS; i++) {
+        uint8_t bit = 1 << i;
+        bool now_on = want->detected & bit;
+        const radar_presence_point_t *t = &want->targets[i];
+
+        if (!p->resync && !topic_changed(p, TOPIC_TARGET(i))) {
+            continue;
+        }
+        char topic[12];
+        snprintf(topic, sizeof(topic), "target/%d", i);
+        radar_presence_msg_t *msg = start_msg(p, &out[n++], TOPIC_TARGET(i), topic);
+        if (now_on) {
+            set_payload(msg, snprintf(msg->payload, sizeof(msg->payload),
+                                      "{\"detected\":true,\"x\":%d,\"y\":%d,\"speed\":%d}",
+                                      t->x, t->y, t->speed));
+        } else {
+            set_payload(msg, snprintf(msg->payload, sizeof(msg->payload), "{\"detected\":false}"));
+        }
+        sent->detected = (sent->detected & ~bit) | (want->detected & bit);
+        sent->targets[i] = *t;
+    }
+
+    p->resync = false;
+    if (n) {
+        p->last_flush_ms = now_ms;
+        p->messages += n;
+    }
+    return n;
+}
@@ -0,0 +1,132 @@
+/*
+ * radar_presence.h
+ * Turns radar frames into change-only presence and target messages
+ *
+ * The detector is plain C with no ESP-IDF dependency, so the same code
+ * feeds the MQTT publisher on the device and tools/mqtt_bench.c on a
+ * Linux host.
+ *
+ * Topics under the configured prefix, all retained:
+ *   presence    "ON" or "OFF"
+ *   count       number of targets, e.g. "2"
+ *   target/N    {"detected":true,"x":-420,"y":2310,"speed":0}, N = 0..2
+ * Presence turning on, a higher count and a new target are sent at once;
+ * presence off, a lower count and a lost target only once they have
+ * held for the hold time, so a target dropping out for a frame or two
+ * sends nothing. A target is resent when it has moved more than the
+ * move threshold from the position last sent. Changes are flushed at
+ * most once per interval, one message per topic, so a burst of frames
+ * costs one message per topic that actually changed.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_PRESENCE_TARGETS      3       // Targets per frame, as the sensor sends
+#define RADAR_PRESENCE_MAX_MSGS     (2 + RADAR_PRESENCE_TARGETS)    // One per topic
+#define RADAR_PRESENCE_TOPIC_LEN    64
+#define RADAR_PRESENCE_PAYLOAD_LEN  64
+
+typedef struct {
+    int16_t x;                  // mm, positive to the right
+    int16_t y;                  // mm, away from the sensor
+    int16_t speed;              // mm/s as reported by the sensor
+} radar_presence_point_t;
+
+// One outgoing message, a fixed-size slot so nothing is allocated per message
+typedef struct {
+    char topic[RADAR_PRESENCE_TOPIC_LEN];
+    char payload[RADAR_PRESENCE_PAYLOAD_LEN];
+    uint16_t payload_len;
+    int64_t frame_us;           // Read time of the frame that first made the change, for latency
+} radar_presence_msg_t;
+
+// What the topics should say, after hysteresis
+typedef struct {
+    bool presence;
+    uint8_t count;
+    uint8_t detected;           // Bit per target
+    radar_presence_point_t targets[RADAR_PRESENCE_TARGETS];
+} radar_presence_view_t;
+
+typedef struct {
+    char prefix[RADAR_PRESENCE_TOPIC_LEN - 12];
+    uint32_t interval_ms;
+    uint32_t hold_ms;
+    uint16_t move_mm;
+
+    radar_presence_view_t want;         // Latest frames after hysteresis
+    radar_presence_view_t sent;         // As last published
+    bool resync;                        // Send every topic at the next flush
+    uint8_t count_now;                  // Targets in the latest frame
+    int64_t present_ms;                 // Last time anyone was detected
+    int64_t count_low_ms;               // Since when the count is below want.count, or -1
+    int64_t lost_ms[RADAR_PRESENCE_TARGETS];    // Since when each wanted target is missing, or -1
+    int64_t last_flush_ms;
+    int64_t frame_us;
+    int64_t changed_us[RADAR_PRESENCE_MAX_MSGS];    // Per topic, frame time of the first unsent change, or -1
+
+    uint32_t frames;
+    uint32_t messages;
+} radar_presence_t;
+
+/**
+ * @brief Set up a detector; every topic is sent at the first flush
+ *
+ * @param p Detector
+ * @param prefix Topic prefix without a trailing slash, e.g. "humanradar/hall"
+ * @param interval_ms Shortest time between flushes
+ * @param hold_ms How long a drop must last before it is sent
+ * @param move_mm Movement that resends a target's position
+ */
+void radar_presence_init(radar_presence_t *p, const char *prefix, uint32_t interval_ms,
+                         uint32_t hold_ms, uint16_t move_mm);
+
+/**
+ * @brief Take in one frame
+ *
+ * @param p Detector
+ * @param frame_us Sensor read time; a message carries the time of the
+ *                 frame that first changed its topic since the last flush,
+ *                 so its latency includes the wait for the interval
+ * @param detected Bit per target
+ * @param targets RADAR_PRESENCE_TARGETS targets
+ * @param now_ms Current time
+ */
+void radar_presence_update(radar_presence_t *p, int64_t frame_us, uint8_t detected,
+                           const radar_presence_point_t *targets, int64_t now_ms);
+
+/**
+ * @brief Let hold times run out while no frames arrive
+ */
+void radar_presence_tick(radar_presence_t *p, int64_t now_ms);
+
+/**
+ * @brief Send every topic at the next flush, e.g. after reconnecting
+ */
+void radar_presence_resync(radar_presence_t *p);
+
+/**
+ * @brief Serialise what changed since the last flush
+ *
+ * Does nothing until interval_ms has passed since the last flush that
+ * produced messages, so the first change after a quiet spell goes out
+ * at once and the rest of a burst waits for the interval.
+ *
+ * @param p Detector
+ * @param now_ms Current time
+ * @param out Room for RADAR_PRESENCE_MAX_MSGS messages
+ * @return Messages written
+ */
+int radar_presence_flush(radar_presence_t *p, int64_t now_ms, radar_presence_msg_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,211 @@
+/*
+ * radar_refresh.c
+ * Wakes the LVGL task on demand and measures how often it runs
+ *
+ * esp_lvgl_port sleeps between lv_timer_handler() passes until the next
+ * LVGL timer is due or something wakes it, and LVGL pauses its refresh
+ * timer while nothing is invalidated. What kept the task busy on a quiet
+ * screen was the UI service timer polling for frames and button
+ * commands. With CONFIG_RADAR_LVGL_ON_DEMAND that timer idles at the
+ * port's longest sleep instead; a sensor frame or a command makes it due
+ * and wakes the port straight from the sending task, so the frame is
+ * drawn on the next pass and nothing polls in between.
+ *
+ * The LVGL task's busy share comes from the FreeRTOS run-time stats.
+ * Wake-to-render latency runs from the first wake after a service pass
+ * to the end of the refresh that draws what the next pass changed; a
+ * pass that changes nothing on screen is not counted. Counting the
+ * passes themselves needs lv_timer_handler() wrapped at link time, which
+ * CONFIG_RADAR_LVGL_COUNT_PASSES turns on (see CMakeLists.txt).
+ */
+
+#include "radar_refresh.h"
+#include "esp_log.h"
+#include "esp_lvgl_port.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+
+static const char *TAG = "RadarRefresh";
+
+static lv_timer_t *wake_timer = NULL;
+static TaskHandle_t lvgl_task = NULL;
+
+static _Atomic uint32_t wakes = 0;
+static _Atomic uint32_t wake_at = 0;        // Low bits of the first wake's time, 0 for none
+static _Atomic uint32_t renders = 0;
+static _Atomic uint32_t latency_sum_us = 0;
+static _Atomic uint32_t latency_max_us = 0;
+
+// LVGL task only
+static uint32_t serving_at = 0;             // Wake the running service pass answers
+static bool serving_invalidated = false;
+static uint32_t render_at = 0;              // Wake waiting for the refresh to finish
+
+static portMUX_TYPE log_lock = portMUX_INITIALIZER_UNLOCKED;
+static radar_refresh_stats_t last_logged;
+static int64_t last_logged_us = 0;
+
+#if CONFIG_RADAR_LVGL_COUNT_PASSES
+
+static _Atomic uint32_t passes = 0;
+
+uint32_t __real_lv_timer_handler(void);
+
+/**
+ * @brief Link-time wrap of lv_timer_handler(): one call per LVGL task pass
+ */
+uint32_t __wrap_lv_timer_handler(void)
+{
+    atomic_fetch_add_explicit(&passes, 1, memory_order_relaxed);
+    return __real_lv_timer_handler();
+}
+
+#endif // CONFIG_RADAR_LVGL_COUNT_PASSES
+
+/**
+ * @brief Display events: note what a service pass invalidated and when it is drawn
+ */
+static void refresh_event_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_INVALIDATE_AREA:
+        if (serving_at) {
+            serving_invalidated = true;
+        }
+        break;
+    case LV_EVENT_REFR_READY:
+        if (render_at) {
+            uint32_t latency_us = (uint32_t)esp_timer_get_time() - render_at;
+            render_at = 0;
+            atomic_fetch_add_explicit(&latency_sum_us, latency_us, memory_order_relaxed);
+            atomic_fetch_add_explicit(&renders, 1, memory_order_relaxed);
+            if (latency_us > atomic_load_explicit(&latency_max_us, memory_order_relaxed)) {
+                atomic_store_explicit(&latency_max_us, latency_us, memory_order_relaxed);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Start timing wakes and, in on-demand mode, waking the service timer
+ */
+void radar_refresh_start(lv_display_t *disp, lv_timer_t *timer)
+{
+    if (wake_timer) {
+        return;
+    }
+    lv_display_add_event_cb(disp, refresh_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    lv_display_add_event_cb(disp, refresh_event_cb, LV_EVENT_REFR_READY, NULL);
+#if CONFIG_RADAR_LVGL_ON_DEMAND
+    ESP_LOGI(TAG, "LVGL task wakes on demand, sleeps up to %d ms", CONFIG_RADAR_LVGL_MAX_SLEEP_MS);
+#endif
+    wake_timer = timer;
+}
+
+/**
+ * @brief Ask for the UI service timer to run soon
+ */
+void radar_refresh_wake(void)
+{
+    uint32_t none = 0;
+
+    atomic_fetch_add_explicit(&wakes, 1, memory_order_relaxed);
+    atomic_compare_exchange_strong_explicit(&wake_at, &none, (uint32_t)esp_timer_get_time() | 1,
+                                            memory_order_relaxed, memory_order_relaxed);
+#if CONFIG_RADAR_LVGL_ON_DEMAND
+    lv_timer_t *timer = wake_timer;
+    if (timer) {
+        // lv_timer_ready() only rewinds the timer's last run time, one aligned
+        // word. Racing the LVGL task running the timer, it runs on this pass or
+        // the next, and the pass reads what was queued before the wake.
+        lv_timer_ready(timer);
+        lvgl_port_task_wake(LVGL_PORT_EVENT_USER, NULL);
+    }
+#endif
+}
+
+/**
+ * @brief Mark the start of a service pass
+ */
+void radar_refresh_serve_begin(void)
+{
+    serving_at = atomic_exchange_explicit(&wake_at, 0, memory_order_relaxed);
+    serving_invalidated = false;
+}
+
+/**
+ * @brief Mark the end of a service pass
+ */
+void radar_refresh_serve_end(void)
+{
+    // The oldest wake still waiting is the one the refresh is late for
+    if (serving_at && serving_invalidated && render_at == 0) {
+        render_at = serving_at;
+    }
+    serving_at = 0;
+}
+
+/**
+ * @brief Copy the LVGL task activity counters
+ */
+void radar_refresh_get_stats(radar_refresh_stats_t *stats)
+{
+    if (lvgl_task == NULL) {
+        lvgl_task = xTaskGetHandle("taskLVGL");
+    }
+    stats->wakes = atomic_load_explicit(&wakes, memory_order_relaxed);
+#if CONFIG_RADAR_LVGL_COUNT_PASSES
+    stats->passes = atomic_load_explicit(&passes, memory_order_relaxed);
+#else
+    stats->passes = 0;
+#endif
+    stats->busy = lvgl_task ? ulTaskGetRunTimeCounter(lvgl_task) : 0;
+    stats->total = portGET_RUN_TIME_COUNTER_VALUE();
+    stats->renders = atomic_load_explicit(&renders, memory_order_relaxed);
+    stats->latency_sum_us = atomic_load_explicit(&latency_sum_us, memory_order_relaxed);
+}
+
+/**
+ * @brief Log LVGL task wakeups per second, busy share and wake-to-render latency since the last call
+ */
+void radar_refresh_log_stats(void)
+{
+    radar_refresh_stats_t now;
+    radar_refresh_stats_t prev;
+    int64_t now_us = esp_timer_get_time();
+    int64_t prev_us;
+
+    radar_refresh_get_stats(&now);
+    uint32_t max_us = atomic_exchange_explicit(&latency_max_us, 0, memory_order_relaxed);
+    portENTER_CRITICAL(&log_lock);
+    prev = last_logged;
+    prev_us = last_logged_us;
+    last_logged = now;
+    last_logged_us = now_us;
+    portEXIT_CRITICAL(&log_lock);
+
+    uint32_t window_ms = (uint32_t)((now_us - prev_us) / 1000);
+    uint32_t total = now.total - prev.total;
+    if (window_ms == 0 || total == 0) {
+        return;
+    }
+    // Wrapping subtraction keeps the deltas right across counter overflow
+    uint32_t wakes_x10 = (uint32_t)((uint64_t)(now.wakes - prev.wakes) * 10000 / window_ms);
+    uint32_t busy_x100 = (uint32_t)((uint64_t)(now.busy - prev.busy) * 10000 / total);
+    uint32_t rendered = now.renders - prev.renders;
+    uint32_t avg_us = rendered ? (now.latency_sum_us - prev.latency_sum_us) / rendered : 0;
+
+    ESP_LOGI(TAG, "LVGL task over %" PRIu32 " ms: %" PRIu32 ".%" PRIu32 " wakes/s, %" PRIu32 ".%02" PRIu32
+             "%% busy, wake to render avg %" PRIu32 " us max %" PRIu32 " us over %" PRIu32 " refreshes",
+             window_ms, wakes_x10 / 10, wakes_x10 % 10, busy_x100 / 100, busy_x100 % 100,
+             avg_us, max_us, rendered);
+#if CONFIG_RADAR_LVGL_COUNT_PASSES
+    uint32_t passes_x10 = (uint32_t)((uint64_t)(now.passes - prev.passes) * 10000 / window_ms);
+    ESP_LOGI(TAG, "LVGL task passes: %" PRIu32 ".%" PRIu32 "/s", passes_x10 / 10, passes_x10 % 10);
+#endif
+}
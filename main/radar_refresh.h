@@ -0,0 +1,77 @@
+/*
+ * radar_refresh.h
+ * Wakes the LVGL task on demand and measures how often it runs
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LVGL task activity since boot; every field wraps
+typedef struct {
+    uint32_t wakes;             // radar_refresh_wake() calls: frames and commands for the UI
+    uint32_t passes;            // lv_timer_handler() calls, with CONFIG_RADAR_LVGL_COUNT_PASSES only
+    uint32_t busy;              // LVGL task run time, in FreeRTOS run-time counter units
+    uint32_t total;             // Run-time counter at the same moment
+    uint32_t renders;           // Refreshes that drew what a wake brought
+    uint32_t latency_sum_us;    // Wake-to-render time of those refreshes
+} radar_refresh_stats_t;
+
+/**
+ * @brief Start timing wakes and, in on-demand mode, waking the service timer
+ *
+ * With CONFIG_RADAR_LVGL_ON_DEMAND, radar_refresh_wake() makes the timer
+ * due and wakes the LVGL task, which otherwise sleeps until its next
+ * timer. Without it the timer runs at its own period and wakes are only
+ * timed. Call with the display locked.
+ *
+ * @param disp Display whose refreshes end the wake-to-render time
+ * @param timer Timer to run on each wake, created on the LVGL task
+ */
+void radar_refresh_start(lv_display_t *disp, lv_timer_t *timer);
+
+/**
+ * @brief Ask for the UI service timer to run soon
+ *
+ * Never blocks and takes no lock; safe from any task. Pass to
+ * radar_bus_subscribe_polled() so sensor frames wake the LVGL task.
+ */
+void radar_refresh_wake(void);
+
+/**
+ * @brief Mark the start of a service pass, from the service timer
+ */
+void radar_refresh_serve_begin(void);
+
+/**
+ * @brief Mark the end of a service pass, from the service timer
+ *
+ * If the pass invalidated anything, the wake it answered is timed to the
+ * end of the next refresh.
+ */
+void radar_refresh_serve_end(void);
+
+/**
+ * @brief Copy the LVGL task activity counters
+ *
+ * @param stats Filled with the counters
+ */
+void radar_refresh_get_stats(radar_refresh_stats_t *stats);
+
+/**
+ * @brief Log LVGL task wakes per second, busy share and wake-to-render latency since the last call
+ *
+ * Call from a task other than the LVGL task.
+ */
+void radar_refresh_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,253 @@
+/*
+ * radar_replay.c
+ * The last minute or two of sensor frames in RAM, for pause and scrub
+ *
+ * A recorder task has its own bus subscriber, so every published frame
+ * is kept whatever the display drops or sheds. It also runs the activity
+ * classifier, which needs every frame in order, and keeps each target's
+ * label with the frame. Frames are fixed-size records in a ring indexed
+ * by their running number, so recording is one copy and fetching any
+ * kept frame is one modulo. Seeking by time goes through a second ring
+ * with one entry per 100 ms slot, holding the first frame recorded in or
+ * after that slot: one division and one modulo find the slot, and only
+ * the few frames inside it are stepped over.
+ */
+
+#include "radar_replay.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radar_activity.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "RadarReplay";
+
+#define REPLAY_FRAMES   (CONFIG_RADAR_REPLAY_SECONDS * RADAR_REPLAY_HZ)
+#define SLOT_MS         100     // Time slot of the seek index
+#define REPLAY_SLOTS    (CONFIG_RADAR_REPLAY_SECONDS * 1000 / SLOT_MS)
+
+static radar_replay_record_t *ring = NULL;
+static uint32_t recorded = 0;       // Frames recorded since boot; the next frame's number
+static uint32_t *slots = NULL;      // By slot: number of the first frame at or after its start
+static int64_t first_slot = 0;      // Slot of the first frame recorded
+static int64_t last_slot = 0;       // Slot of the newest frame
+static int64_t last_ms = 0;         // Time of the newest frame, ms, without the 32 bit wrap
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Keep a frame, overwriting the oldest once the ring is full
+ */
+static void replay_record(const radar_frame_t *frame)
+{
+    radar_replay_record_t r;
+    int64_t ms = frame->timestamp_us / 1000;
+    int64_t slot = ms / SLOT_MS;
+
+    r.time_ms = (uint32_t)ms;
+    r.detected = frame->detected;
+    r.target_count = frame->target_count;
+    memcpy(r.targets, frame->targets, sizeof(r.targets));
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        r.activity[i] = radar_activity_get(i);
+    }
+
+    portENTER_CRITICAL(&ring_lock);
+    if (recorded == 0) {
+        first_slot = slot;
+        last_slot = slot - 1;
+    }
+    // Slots passed without a frame also start at this one; after a long
+    // gap only the last REPLAY_SLOTS of them can still be looked up
+    int64_t from = last_slot + 1;
+    if (from < slot - REPLAY_SLOTS + 1) {
+        from = slot - REPLAY_SLOTS + 1;
+    }
+    for (int64_t s = from; s <= slot; s++) {
+        slots[s % REPLAY_SLOTS] = recorded;
+    }
+    if (slot > last_slot) {
+        last_slot = slot;
+    }
+    last_ms = ms;
+    ring[recorded % REPLAY_FRAMES] = r;
+    recorded++;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+/**
+ * @brief Recorder task, classifies and keeps every bus frame
+ */
+static void replay_task(void *pvParameters)
+{
+    radar_bus_sub_t *sub = radar_bus_subscribe("replay", RADAR_BUS_DROP_OLDEST, 4, 1);
+
+    if (sub == NULL) {
+        ESP_LOGE(TAG, "No bus subscriber slot left");
+        vTaskDelete(NULL);
+    }
+    while (1) {
+        const radar_frame_t *frame = radar_bus_receive(sub, portMAX_DELAY);
+        if (frame == NULL) {
+            continue;
+        }
+        radar_activity_update(frame);
+        replay_record(frame);
+        radar_bus_release(sub, frame);
+    }
+}
+
+/**
+ * @brief Set up the ring and start recording
+ */
+void radar_replay_start(void)
+{
+    if (ring) {
+        return;
+    }
+#if CONFIG_RADAR_STATIC_ALLOC
+    static radar_replay_record_t ring_buf[REPLAY_FRAMES];
+    static uint32_t slots_buf[REPLAY_SLOTS];
+    ring = ring_buf;
+    slots = slots_buf;
+#else
+    slots = calloc(REPLAY_SLOTS, sizeof(uint32_t));
+    ring = slots ? calloc(REPLAY_FRAMES, sizeof(radar_replay_record_t)) : NULL;
+    if (ring == NULL) {
+        free(slots);
+        slots = NULL;
+        ESP_LOGE(TAG, "No memory for %d frames of replay", REPLAY_FRAMES);
+        return;
+    }
+#endif
+    RADAR_TASK_CREATE(replay_task, "Replay Recorder", 3072, NULL, 6, 0);
+    ESP_LOGI(TAG, "Keeping %d s of frames, %d bytes", CONFIG_RADAR_REPLAY_SECONDS,
+             (int)(REPLAY_FRAMES * sizeof(radar_replay_record_t) + REPLAY_SLOTS * sizeof(uint32_t)));
+}
+
+/**
+ * @brief Oldest slot the seek index still covers, call with ring_lock held
+ */
+static int64_t lowest_slot(void)
+{
+    return first_slot > last_slot - REPLAY_SLOTS + 1 ? first_slot : last_slot - REPLAY_SLOTS + 1;
+}
+
+/**
+ * @brief Number of the oldest frame kept, call with ring_lock held
+ *
+ * Below RADAR_REPLAY_HZ the ring reaches back further than the seek
+ * index; frames before the index's first slot count as gone, so every
+ * kept frame can be found by time.
+ */
+static uint32_t oldest_kept(void)
+{
+    uint32_t oldest = recorded > REPLAY_FRAMES ? recorded - REPLAY_FRAMES : 0;
+    int64_t lowest = lowest_slot();
+
+    if (lowest > first_slot && slots[lowest % REPLAY_SLOTS] > oldest) {
+        oldest = slots[lowest % REPLAY_SLOTS];
+    }
+    return oldest;
+}
+
+/**
+ * @brief Numbers of the oldest and newest frames still kept
+ */
+bool radar_replay_range(uint32_t *oldest, uint32_t *newest)
+{
+    portENTER_CRITICAL(&ring_lock);
+    uint32_t n = recorded;
+    uint32_t first = n ? oldest_kept() : 0;
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (n == 0) {
+        return false;
+    }
+    *newest = n - 1;
+    *oldest = first;
+    return true;
+}
+
+/**
+ * @brief Rebuild a kept frame
+ */
+bool radar_replay_get(uint32_t index, radar_frame_t *frame, uint8_t activity[RADAR_MAX_TARGETS])
+{
+    radar_replay_record_t r;
+
+    if (ring == NULL) {
+        return false;
+    }
+    portENTER_CRITICAL(&ring_lock);
+    // Wrapping subtraction: too new and overwritten both come out past the kept count
+    bool kept = recorded != 0 && recorded - 1 - index < recorded - oldest_kept();
+    if (kept) {
+        r = ring[index % REPLAY_FRAMES];
+    }
+    portEXIT_CRITICAL(&ring_lock);
+    if (!kept) {
+        return false;
+    }
+
+    frame->seq = index;
+    frame->timestamp_us = (int64_t)r.time_ms * 1000;
+    frame->detected = r.detected;
+    frame->target_count = r.target_count;
+    memcpy(frame->targets, r.targets, sizeof(frame->targets));
+    if (activity) {
+        memcpy(activity, r.activity, sizeof(r.activity));
+    }
+    return true;
+}
+
+/**
+ * @brief Kept frame nearest a time, on one side of it
+ */
+bool radar_replay_seek(uint32_t time_ms, bool after, uint32_t *index)
+{
+    if (ring == NULL) {
+        return false;
+    }
+    portENTER_CRITICAL(&ring_lock);
+    uint32_t n = recorded;
+    uint32_t oldest = n ? oldest_kept() : 0;
+    uint32_t i = n;
+    if (n != 0) {
+        // Place time_ms on the newest frame's unwrapped time line; signed
+        // differences keep frame order across the 49 day wrap
+        int64_t ms = last_ms + (int32_t)(time_ms - (uint32_t)last_ms);
+        int64_t slot = ms < 0 ? -1 : ms / SLOT_MS;
+
+        if (slot < lowest_slot()) {
+            i = oldest;
+        } else if (slot <= last_slot) {
+            i = slots[slot % REPLAY_SLOTS];
+            if (i < oldest) {
+                i = oldest;
+            }
+        }
+        // Step over the frames earlier in the slot: the first frame after
+        // time_ms, or at it too when seeking after
+        while (i < n && (int32_t)(ring[i % REPLAY_FRAMES].time_ms - time_ms) < (after ? 0 : 1)) {
+            i++;
+        }
+    }
+    portEXIT_CRITICAL(&ring_lock);
+
+    if (n == 0) {
+        return false;
+    }
+    if (after) {
+        // The newest if none is
+        *index = i < n ? i : n - 1;
+    } else {
+        // The frame before it, the oldest if none is
+        *index = i > oldest ? i - 1 : oldest;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * radar_replay.h
+ * The last minute or two of sensor frames in RAM, for pause and scrub
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "radar_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADAR_REPLAY_HZ         10      // Sensor frame rate the ring is sized for
+
+// One frame as kept for replay; 28 bytes
+typedef struct {
+    uint32_t time_ms;           // Sensor read time, ms since boot
+    uint8_t detected;           // Bit per target
+    uint8_t target_count;       // Highest detected index + 1
+    radar_point_t targets[RADAR_MAX_TARGETS];
+    uint8_t activity[RADAR_MAX_TARGETS];    // radar_activity_t of each target as classified then
+} radar_replay_record_t;
+
+/**
+ * @brief Set up the ring and start the recorder task
+ *
+ * The ring holds CONFIG_RADAR_REPLAY_SECONDS of frames at
+ * RADAR_REPLAY_HZ: a static buffer with CONFIG_RADAR_STATIC_ALLOC,
+ * otherwise allocated once here. If allocation fails nothing is
+ * recorded. The recorder subscribes to the frame bus and, for each frame,
+ * runs radar_activity_update() and keeps the frame with its activities,
+ * so call before any other subscriber needs the activity labels.
+ */
+void radar_replay_start(void);
+
+/**
+ * @brief Numbers of the oldest and newest frames still kept
+ *
+ * Frames are numbered from 0 in the order recorded; numbers stay valid
+ * while newer frames arrive, until the frame is overwritten.
+ *
+ * @param oldest Set to the oldest frame's number
+ * @param newest Set to the newest frame's number
+ * @return false if nothing has been recorded
+ */
+bool radar_replay_range(uint32_t *oldest, uint32_t *newest);
+
+/**
+ * @brief Rebuild a kept frame, in constant time
+ *
+ * Safe from any task, as are radar_replay_range() and radar_replay_seek().
+ *
+ * seq is set to the frame's number.
+ *
+ * @param index Frame number
+ * @param frame Filled with the frame
+ * @param activity Filled with each target's radar_activity_t at the time, or NULL
+ * @return false if the frame is not, or no longer, kept
+ */
+bool radar_replay_get(uint32_t index, radar_frame_t *frame, uint8_t activity[RADAR_MAX_TARGETS]);
+
+/**
+ * @brief Find the kept frame nearest a time, on one side of it
+ *
+ * Looks the time's 100 ms slot up in an index kept while recording, then
+ * steps over the frames earlier in that slot, so the cost does not depend
+ * on how far the time is from the frame shown or on how many frames are
+ * kept. Times past either end give the oldest or newest frame.
+ *
+ * @param time_ms Time, ms since boot as in radar_replay_record_t
+ * @param after true for the first frame at or after time_ms, false for the last at or before it
+ * @param index Set to the frame's number
+ * @return false if nothing has been recorded
+ */
+bool radar_replay_seek(uint32_t time_ms, bool after, uint32_t *index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,265 @@
+/*
+ * radar_soak.c
+ * On-device soak run for the radar views, replaces the radar task when
+ * CONFIG_RADAR_SOAK is set
+ *
+ * Runs on the device rather than a host build: the views are only built
+ * against the board's LVGL port and configuration, and the LVGL pool
+ * and heap figures that matter are the device's. For a test runner with
+ * the board attached, tools/soak_check.py reads the monitor log and
+ * exits non-zero unless the run ends in "Soak PASSED".
+ */
+
+#include "radar_soak.h"
+#include "bsp/esp-bsp.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "humanRadarRD_03D.h"
+#include "radar_budget.h"
+#include "sdkconfig.h"
+#include "ui_radar_diag.h"
+#include "ui_radar_integration.h"
+#include "ui_radar_sweep.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if CONFIG_RADAR_SOAK
+
+static const char *TAG = "RadarSoak";
+
+#ifndef PI
+#define PI (3.14159265358979f)
+#endif
+
+// Heap figures compared against the baseline
+typedef struct {
+    size_t lvgl_used;       // LVGL pool bytes in use
+    uint8_t lvgl_frag;      // LVGL pool fragmentation, %
+    size_t heap_free;       // Internal heap free bytes
+    size_t heap_largest;    // Largest internal free block
+} soak_sample_t;
+
+static lv_display_t *soak_disp = NULL;
+static uint32_t rng_state = 0x2545F491;
+
+/**
+ * @brief Small deterministic PRNG so every soak run is the same
+ */
+static uint32_t soak_rand(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/**
+ * @brief Random value in [-range, range]
+ */
+static int32_t soak_jitter(int32_t range)
+{
+    return (int32_t)(soak_rand() % (2 * range + 1)) - range;
+}
+
+/**
+ * @brief Move the synthetic targets one step, occasionally losing or finding one
+ */
+static void soak_step_targets(radar_target_t *targets)
+{
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        radar_target_t *t = &targets[i];
+
+        if (soak_rand() % 20 == 0) {
+            t->detected = !t->detected;
+        }
+        if (!t->detected) {
+            continue;
+        }
+
+        t->x += soak_jitter(150);
+        t->y += soak_jitter(150);
+        if (t->y < 200) {
+            t->y = 200;
+        } else if (t->y > 7800) {
+            t->y = 7800;
+        }
+        if (fabsf(t->x) > t->y * 1.7f) {
+            t->x = (t->x > 0 ? 1.7f : -1.7f) * t->y;
+        }
+        t->distance = sqrtf(t->x * t->x + t->y * t->y);
+        t->angle = atan2f(t->x, t->y) * 180.0f / PI;
+        t->speed = soak_jitter(800);
+        snprintf(t->position_description, sizeof(t->position_description),
+                 "Soak %d %s", i, t->x < 0 ? "left" : "right");
+    }
+}
+
+/**
+ * @brief Feed one synthetic frame through the same path as the radar task
+ */
+static void soak_feed_frame(radar_target_t *targets)
+{
+    static radar_frame_t frame;
+    static radar_frame_t prior;
+    int target_count = 0;
+
+    prior = frame;
+    soak_step_targets(targets);
+    radar_diag_note_sensor_frame();
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        if (targets[idx].detected) {
+            target_count = idx + 1;
+        }
+    }
+    radar_frame_pack(&frame, targets, target_count);
+    frame.timestamp_us = esp_timer_get_time();
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        radar_update_current_display(&frame, idx, radar_frame_target_moved(&frame, &prior, idx));
+    }
+
+    if (radar_get_display_mode() == DISPLAY_MODE_SWEEP) {
+        bsp_display_lock(0);
+        radar_sweep_update_info(target_count);
+        bsp_display_unlock();
+    }
+}
+
+/**
+ * @brief Read the LVGL pool and internal heap
+ */
+static void soak_sample(soak_sample_t *sample)
+{
+    lv_mem_monitor_t mon;
+
+    bsp_display_lock(0);
+    lv_mem_monitor(&mon);
+    bsp_display_unlock();
+
+    sample->lvgl_used = mon.total_size - mon.free_size;
+    sample->lvgl_frag = mon.frag_pct;
+    sample->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    sample->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+}
+
+/**
+ * @brief One cycle: switch view, update, exercise animation, motion and overlay
+ *
+ * Every cycle leaves the animation, motion mode and overlay as it found
+ * them, so samples taken in the same view are comparable.
+ */
+static void soak_cycle(uint32_t cycle, radar_target_t *targets)
+{
+    radar_switch_display_mode(soak_disp);
+    vTaskDelay(1);
+
+    for (int i = 0; i < CONFIG_RADAR_SOAK_UPDATES_PER_CYCLE; i++) {
+        soak_feed_frame(targets);
+        vTaskDelay(1);
+
+        if (radar_get_display_mode() != DISPLAY_MODE_SWEEP) {
+            continue;
+        }
+        if (i == 1 && (cycle & 1)) {
+            bsp_display_lock(0);
+            radar_sweep_stop_animation();
+            bsp_display_unlock();
+        } else if (i == 3 && (cycle & 1)) {
+            bsp_display_lock(0);
+            radar_sweep_start_animation();
+            bsp_display_unlock();
+        } else if ((i == 2 || i == 4) && (cycle & 2)) {
+            // Pauses and resumes the motion timer, so it needs the lock too
+            bsp_display_lock(0);
+            radar_sweep_set_motion_mode(radar_sweep_get_motion_mode() == RADAR_MOTION_SNAP ?
+                                        RADAR_MOTION_INTERPOLATE : RADAR_MOTION_SNAP);
+            bsp_display_unlock();
+        }
+    }
+
+    if (cycle % 8 == 0) {
+        bsp_display_lock(0);
+        radar_diag_show(soak_disp);
+        bsp_display_unlock();
+        vTaskDelay(2);
+        bsp_display_lock(0);
+        radar_diag_hide();
+        bsp_display_unlock();
+    }
+}
+
+/**
+ * @brief Soak task
+ */
+static void soak_task(void *pvParameters)
+{
+    static radar_target_t targets[RADAR_MAX_TARGETS];
+    display_mode_t baseline_mode = radar_get_display_mode();
+    soak_sample_t baseline = {0};
+    soak_sample_t sample = {0};
+    bool leaked = false;
+
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        targets[i].y = 1000 + 2000 * i;
+    }
+
+    // Warm up: first creation of each view initialises shared styles and caches
+    for (uint32_t cycle = 0; cycle < 4; cycle++) {
+        soak_cycle(cycle, targets);
+    }
+    soak_sample(&baseline);
+    ESP_LOGI(TAG, "Baseline: LVGL used %u (frag %u%%), heap free %u (largest %u)",
+             (unsigned)baseline.lvgl_used, baseline.lvgl_frag,
+             (unsigned)baseline.heap_free, (unsigned)baseline.heap_largest);
+
+    for (uint32_t cycle = 4; cycle < CONFIG_RADAR_SOAK_CYCLES + 4; cycle++) {
+        soak_cycle(cycle, targets);
+
+        // Compare only in the view the baseline was taken in
+        if (cycle % CONFIG_RADAR_SOAK_SAMPLE_CYCLES < DISPLAY_MODE_COUNT &&
+            radar_get_display_mode() == baseline_mode) {
+            soak_sample(&sample);
+            ESP_LOGI(TAG, "Cycle %u: LVGL used %+d (frag %u%%), heap free %+d (largest %u)",
+                     (unsigned)(cycle - 4),
+                     (int)(sample.lvgl_used - baseline.lvgl_used), sample.lvgl_frag,
+                     (int)(sample.heap_free - baseline.heap_free),
+                     (unsigned)sample.heap_largest);
+        }
+    }
+
+    // Final check, back in the baseline view
+    if (radar_get_display_mode() != baseline_mode) {
+        radar_set_display_mode(soak_disp, baseline_mode);
+        vTaskDelay(1);
+    }
+    soak_sample(&sample);
+
+    if (sample.lvgl_used > baseline.lvgl_used + CONFIG_RADAR_SOAK_TOLERANCE_BYTES) {
+        ESP_LOGE(TAG, "LVGL heap grew by %u bytes",
+                 (unsigned)(sample.lvgl_used - baseline.lvgl_used));
+        leaked = true;
+    }
+    if (sample.heap_free + CONFIG_RADAR_SOAK_TOLERANCE_BYTES < baseline.heap_free) {
+        ESP_LOGE(TAG, "Internal heap shrank by %u bytes",
+                 (unsigned)(baseline.heap_free - sample.heap_free));
+        leaked = true;
+    }
+
+    if (leaked) {
+        ESP_LOGE(TAG, "Soak FAILED after %d cycles", CONFIG_RADAR_SOAK_CYCLES);
+    } else {
+        ESP_LOGI(TAG, "Soak PASSED after %d cycles", CONFIG_RADAR_SOAK_CYCLES);
+    }
+    vTaskDelete(NULL);
+}
+
+void radar_soak_start(lv_display_t *disp)
+{
+    soak_disp = disp;
+    RADAR_TASK_CREATE(soak_task, "Soak Test", 4096, NULL, 10, 1);
+}
+
+#endif // CONFIG_RADAR_SOAK
@@ -0,0 +1,32 @@
+/*
+ * radar_soak.h
+ * On-device soak run: view switching, animation cycles and synthetic
+ * target updates, checked for LVGL and system heap leaks
+ */
+
+#pragma once
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the soak task in place of the radar task
+ *
+ * Runs CONFIG_RADAR_SOAK_CYCLES cycles. Each cycle switches the display
+ * mode, feeds synthetic targets through radar_update_current_display()
+ * and periodically stops/starts the sweep animation, changes the motion
+ * mode and toggles the diagnostics overlay. Every
+ * CONFIG_RADAR_SOAK_SAMPLE_CYCLES cycles it logs the LVGL heap and the
+ * internal heap, and at the end logs "Soak PASSED" or "Soak FAILED"
+ * depending on whether both returned to their baseline.
+ *
+ * @param disp LVGL display handle, after radar_display_init()
+ */
+void radar_soak_start(lv_display_t *disp);
+
+#ifdef __cplusplus
+}
+#endif
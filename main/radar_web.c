@@ -0,0 +1,331 @@
+/*
+ * radar_web.c
+ * Live dashboard over HTTP and WebSocket for browsers on the LAN
+ *
+ * A bus subscriber with the latest-only policy builds one binary delta
+ * per client from each frame. A client gets a new message only when its
+ * previous one has been sent; until then its frames are coalesced, and
+ * the delta is always taken against what that client last received.
+ * Every client has a fixed buffer, so RAM does not grow with slow
+ * browsers, and sending happens on the HTTP server task, never on the
+ * radar task.
+ */
+
+#include "radar_web.h"
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_frame.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if CONFIG_RADAR_WEB
+
+static const char *TAG = "RadarWeb";
+
+#define WEB_MSG_MAX (RADAR_WEB_HEADER_LEN + RADAR_MAX_TARGETS * RADAR_WEB_TARGET_LEN)
+
+typedef struct {
+    int fd;                     // Socket, -1 when the slot is free; under clients_lock
+    _Atomic bool busy;          // buf is in use by a message in flight; the slot is not reused until it clears
+    bool synced;                // sent matches what the browser has
+    radar_frame_t sent;         // Targets as last sent to this client
+    httpd_ws_frame_t ws_frame;
+    uint8_t buf[WEB_MSG_MAX];
+    uint32_t messages;          // Messages sent
+    uint32_t coalesced;         // Frames folded into a later message
+    uint32_t failed;            // Sends that failed
+} web_client_t;
+
+static httpd_handle_t server = NULL;
+static web_client_t clients[CONFIG_RADAR_WEB_MAX_CLIENTS];
+static portMUX_TYPE clients_lock = portMUX_INITIALIZER_UNLOCKED;
+
+extern const char dashboard_html_start[] asm("_binary_dashboard_html_start");
+extern const char dashboard_html_end[] asm("_binary_dashboard_html_end");
+
+/**
+ * @brief Put a little endian value into a message
+ */
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p = put_u16(p, v & 0xFFFF);
+    return put_u16(p, v >> 16);
+}
+
+/**
+ * @brief Build a client's delta from a frame
+ *
+ * @return Message length, 0 if nothing changed for this client
+ */
+static size_t build_delta(web_client_t *client, const radar_frame_t *frame)
+{
+    uint8_t mask = 0;
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        if (!client->synced || radar_frame_target_moved(frame, &client->sent, idx)) {
+            mask |= 1u << idx;
+        }
+    }
+    if (mask == 0) {
+        return 0;
+    }
+
+    uint8_t *p = client->buf;
+    *p++ = RADAR_WEB_MSG_DELTA;
+    *p++ = mask;
+    *p++ = frame->detected;
+    *p++ = frame->target_count;
+    p = put_u32(p, frame->seq);
+    p = put_u32(p, (uint32_t)(esp_timer_get_time() - frame->timestamp_us));
+
+    for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+        if (!(mask & (1u << idx))) {
+            continue;
+        }
+        const radar_point_t *point = &frame->targets[idx];
+        p = put_u16(p, (uint16_t)point->x);
+        p = put_u16(p, (uint16_t)point->y);
+        p = put_u16(p, (uint16_t)point->speed);
+        client->sent.targets[idx] = *point;
+    }
+    client->sent.detected = (client->sent.detected & ~mask) | (frame->detected & mask);
+    client->synced = true;
+    return p - client->buf;
+}
+
+/**
+ * @brief Called on the server task once a message has gone out
+ */
+static void send_done(esp_err_t err, int fd, void *arg)
+{
+    web_client_t *client = arg;
+
+    portENTER_CRITICAL(&clients_lock);
+    bool current = client->fd == fd;
+    portEXIT_CRITICAL(&clients_lock);
+
+    // Counted only if the client is still there; buf is free either way
+    if (current && err == ESP_OK) {
+        client->messages++;
+    } else if (current) {
+        // The browser may have missed it; resend everything next time
+        client->synced = false;
+        client->failed++;
+    }
+    atomic_store_explicit(&client->busy, false, memory_order_release);
+}
+
+/**
+ * @brief Web publisher task
+ */
+static void web_task(void *pvParameters)
+{
+    radar_bus_sub_t *sub = radar_bus_subscribe("web", RADAR_BUS_LATEST_ONLY, 1, 1);
+
+    if (sub == NULL) {
+        vTaskDelete(NULL);
+    }
+
+    while (1) {
+        const radar_frame_t *frame = radar_bus_receive(sub, portMAX_DELAY);
+        if (frame == NULL) {
+            continue;
+        }
+
+        for (int i = 0; i < CONFIG_RADAR_WEB_MAX_CLIENTS; i++) {
+            web_client_t *client = &clients[i];
+
+            // Claim the slot's buffer under the lock, so a close cannot free
+            // the slot for another socket while a message is built and sent
+            portENTER_CRITICAL(&clients_lock);
+            int fd = client->fd;
+            bool busy = fd >= 0 && atomic_load_explicit(&client->busy, memory_order_acquire);
+            if (fd >= 0 && !busy) {
+                atomic_store_explicit(&client->busy, true, memory_order_relaxed);
+            }
+            portEXIT_CRITICAL(&clients_lock);
+
+            if (fd < 0) {
+                continue;
+            }
+            if (busy) {
+                client->coalesced++;
+                continue;
+            }
+            size_t len = build_delta(client, frame);
+            if (len == 0) {
+                atomic_store_explicit(&client->busy, false, memory_order_relaxed);
+                continue;
+            }
+
+            client->ws_frame = (httpd_ws_frame_t) {
+                .final = true,
+                .type = HTTPD_WS_TYPE_BINARY,
+                .payload = client->buf,
+                .len = len,
+            };
+            if (httpd_ws_send_data_async(server, fd, &client->ws_frame, send_done, client) != ESP_OK) {
+                client->synced = false;
+                client->failed++;
+                atomic_store_explicit(&client->busy, false, memory_order_relaxed);
+            }
+        }
+
+        radar_bus_release(sub, frame);
+    }
+}
+
+/**
+ * @brief Serve the dashboard page
+ */
+static esp_err_t page_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Cache-Control", "max-age=3600");
+    // EMBED_TXTFILES appends a NUL that is not part of the page
+    return httpd_resp_send(req, dashboard_html_start, dashboard_html_end - dashboard_html_start - 1);
+}
+
+/**
+ * @brief WebSocket handshake and incoming messages
+ */
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        web_client_t *client = NULL;
+
+        portENTER_CRITICAL(&clients_lock);
+        for (int i = 0; i < CONFIG_RADAR_WEB_MAX_CLIENTS; i++) {
+            // A slot whose last message is still in flight stays taken
+            if (clients[i].fd < 0 && !atomic_load(&clients[i].busy)) {
+                client = &clients[i];
+                client->synced = false;
+                client->messages = 0;
+                client->coalesced = 0;
+                client->failed = 0;
+                client->fd = fd;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&clients_lock);
+
+        if (client == NULL) {
+            ESP_LOGW(TAG, "Client limit reached, refusing socket %d", fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "Client connected on socket %d", fd);
+        return ESP_OK;
+    }
+
+    // The dashboard sends nothing; read and discard whatever arrives
+    uint8_t buf[32];
+    httpd_ws_frame_t frame = {.payload = buf};
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK || frame.len > sizeof(buf)) {
+        return ESP_FAIL;
+    }
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
+
+/**
+ * @brief Forget a client when the server closes its socket
+ */
+static void web_close_fn(httpd_handle_t hd, int fd)
+{
+    web_client_t *client = NULL;
+
+    portENTER_CRITICAL(&clients_lock);
+    for (int i = 0; i < CONFIG_RADAR_WEB_MAX_CLIENTS; i++) {
+        if (clients[i].fd == fd) {
+            clients[i].fd = -1;
+            client = &clients[i];
+        }
+    }
+    portEXIT_CRITICAL(&clients_lock);
+
+    if (client) {
+        ESP_LOGI(TAG, "Client on socket %d left after %" PRIu32 " messages", fd, client->messages);
+    }
+    close(fd);
+}
+
+/**
+ * @brief Start the HTTP server and the WebSocket publisher
+ */
+void radar_web_start(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    static const httpd_uri_t page = {
+        .uri = "/",
+        .method = HTTP_GET,
+        .handler = page_handler,
+    };
+    static const httpd_uri_t ws = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+
+    for (int i = 0; i < CONFIG_RADAR_WEB_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+
+    // Room for every WebSocket plus two page loads; stay off the display core
+    config.max_open_sockets = CONFIG_RADAR_WEB_MAX_CLIENTS + 2;
+    config.lru_purge_enable = true;
+    config.send_wait_timeout = 1;
+    config.core_id = 0;
+    config.close_fn = web_close_fn;
+
+    esp_err_t err = httpd_start(&server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP server failed to start: %s", esp_err_to_name(err));
+        return;
+    }
+    httpd_register_uri_handler(server, &page);
+    httpd_register_uri_handler(server, &ws);
+
+    RADAR_TASK_CREATE(web_task, "Web Publisher", CONFIG_RADAR_STACK_WEB, NULL, 3, 0);
+    ESP_LOGI(TAG, "Dashboard on port %u", config.server_port);
+}
+
+/**
+ * @brief Log per-client sent and coalesced message counts
+ */
+void radar_web_log_stats(void)
+{
+    if (server == NULL) {
+        return;
+    }
+    for (int i = 0; i < CONFIG_RADAR_WEB_MAX_CLIENTS; i++) {
+        web_client_t *client = &clients[i];
+        portENTER_CRITICAL(&clients_lock);
+        int fd = client->fd;
+        portEXIT_CRITICAL(&clients_lock);
+        if (fd < 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Socket %d: sent %" PRIu32 " coalesced %" PRIu32 " failed %" PRIu32,
+                 fd, client->messages, client->coalesced, client->failed);
+    }
+}
+
+#endif // CONFIG_RADAR_WEB
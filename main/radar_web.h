@@ -0,0 +1,50 @@
+/*
+ * radar_web.h
+ * Live dashboard over HTTP and WebSocket for browsers on the LAN
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * WebSocket message, binary, little endian:
+ *
+ *   u8  type      RADAR_WEB_MSG_DELTA
+ *   u8  mask      Bit per target included below
+ *   u8  detected  Bit per target detected
+ *   u8  count     Highest detected index + 1
+ *   u32 seq       Bus sequence number of the frame
+ *   u32 age_us    Time from sensor read to send
+ *   then for each bit set in mask, lowest first:
+ *   i16 x, i16 y, i16 speed   (mm, mm, mm/s)
+ *
+ * The first message to a client includes every target; later ones only
+ * the targets that appeared, disappeared or moved since that client's
+ * previous message.
+ */
+#define RADAR_WEB_MSG_DELTA     1
+#define RADAR_WEB_HEADER_LEN    12
+#define RADAR_WEB_TARGET_LEN    6
+
+/**
+ * @brief Start the HTTP server and the WebSocket publisher
+ *
+ * Serves the dashboard page at "/" and target updates at "/ws" to up to
+ * CONFIG_RADAR_WEB_MAX_CLIENTS browsers. Each client has one message in
+ * flight at most; frames that arrive while it is still sending are
+ * folded into its next delta, so a slow client costs neither memory nor
+ * radar task time. Call after the network is up and before start_mmwave().
+ */
+void radar_web_start(void);
+
+/**
+ * @brief Log per-client sent and coalesced message counts
+ */
+void radar_web_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,263 @@
+/*
+ * ui_radar_diag.c
+ * Live performance overlay for the radar views
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#include "ui_radar_diag.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/idf_additions.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "RadarDiag";
+
+#define DIAG_MAX_TASKS   48     // Task status slots sampled each period, about twice the tasks running
+#define DIAG_TASK_ROWS   8      // Tasks listed per column
+#define DIAG_HEIGHT      150
+
+typedef struct {
+    lv_display_t *disp;
+    lv_obj_t *panel;
+    lv_obj_t *rate_label;
+    lv_obj_t *heap_label;
+    lv_obj_t *lvgl_label;
+    lv_obj_t *task_labels[2];
+    lv_timer_t *timer;
+} radar_diag_ui_t;
+
+static radar_diag_ui_t ui = {0};
+
+// Counters; frames are counted in the LVGL task, sensor frames in the radar task
+static uint32_t render_frames = 0;
+static volatile uint32_t sensor_frames = 0;
+
+// Previous sample, for rates and per-core load
+static bool primed = false;
+static uint32_t prev_tick = 0;
+static uint32_t prev_render_frames = 0;
+static uint32_t prev_sensor_frames = 0;
+static uint32_t prev_total_runtime = 0;
+static uint32_t prev_idle_runtime[portNUM_PROCESSORS];
+static bool too_many_logged = false;
+
+// Fixed-size sample storage, nothing is allocated while sampling
+static TaskStatus_t task_status[DIAG_MAX_TASKS];
+static uint8_t task_order[DIAG_MAX_TASKS];
+static char rate_text[64];
+static char heap_text[64];
+static char lvgl_text[64];
+static char task_text[2][DIAG_TASK_ROWS * 24];
+
+/**
+ * @brief Count refreshes that actually rendered something
+ */
+static void render_ready_cb(lv_event_t *e)
+{
+    render_frames++;
+}
+
+/**
+ * @brief Sort task_order[] by stack high-water mark, lowest first
+ */
+static void sort_tasks_by_stack(UBaseType_t count)
+{
+    for (UBaseType_t i = 0; i < count; i++) {
+        task_order[i] = i;
+    }
+    for (UBaseType_t i = 1; i < count; i++) {
+        uint8_t idx = task_order[i];
+        UBaseType_t j = i;
+        while (j > 0 && task_status[task_order[j - 1]].usStackHighWaterMark >
+                        task_status[idx].usStackHighWaterMark) {
+            task_order[j] = task_order[j - 1];
+            j--;
+        }
+        task_order[j] = idx;
+    }
+}
+
+/**
+ * @brief Sample every metric and refresh the overlay labels
+ */
+static void diag_timer_cb(lv_timer_t *timer)
+{
+    uint32_t now = lv_tick_get();
+    uint32_t elapsed = now - prev_tick;
+    uint32_t frames = render_frames - prev_render_frames;
+    uint32_t sensor = sensor_frames - prev_sensor_frames;
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, DIAG_MAX_TASKS, &total_runtime);
+    uint32_t total_delta = total_runtime - prev_total_runtime;
+    int load[portNUM_PROCESSORS];
+
+    // Per-core load from the idle task run time since the last sample
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+        load[core] = -1;
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (task_status[i].xHandle != idle) {
+                continue;
+            }
+            uint32_t idle_delta = task_status[i].ulRunTimeCounter - prev_idle_runtime[core];
+            prev_idle_runtime[core] = task_status[i].ulRunTimeCounter;
+            if (primed && total_delta > 0) {
+                load[core] = 100 - (int)((uint64_t)idle_delta * 100 / total_delta);
+                if (load[core] < 0) {
+                    load[core] = 0;
+                }
+            }
+            break;
+        }
+    }
+
+    if (primed && elapsed > 0) {
+        uint32_t sensor_tenths = sensor * 10000 / elapsed;
+        int len = snprintf(rate_text, sizeof(rate_text),
+                           "UI %" PRIu32 " fps   Radar %" PRIu32 ".%" PRIu32 " f/s",
+                           frames * 1000 / elapsed, sensor_tenths / 10, sensor_tenths % 10);
+        for (int core = 0; core < portNUM_PROCESSORS && len < (int)sizeof(rate_text); core++) {
+            len += snprintf(rate_text + len, sizeof(rate_text) - len,
+                            load[core] < 0 ? "   CPU%d --" : "   CPU%d %d%%", core, load[core]);
+        }
+    } else {
+        snprintf(rate_text, sizeof(rate_text), "UI -- fps   Radar -- f/s   sampling...");
+    }
+    lv_label_set_text_static(ui.rate_label, rate_text);
+
+    snprintf(heap_text, sizeof(heap_text),
+             "Heap int %u  PSRAM %u  largest %u",
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    lv_label_set_text_static(ui.heap_label, heap_text);
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    snprintf(lvgl_text, sizeof(lvgl_text),
+             "LVGL %u%% used  %u%% frag  %u free  max %u",
+             mon.used_pct, mon.frag_pct, (unsigned)mon.free_size, (unsigned)mon.max_used);
+    lv_label_set_text_static(ui.lvgl_label, lvgl_text);
+
+    // Stack high-water marks, the tasks closest to overflow first
+    if (count == 0) {
+        // uxTaskGetSystemState() fills nothing when the slots run out, so load is lost too
+        if (!too_many_logged) {
+            ESP_LOGW(TAG, "%u tasks running, more than the %d sampled; no load or stack figures",
+                     (unsigned)uxTaskGetNumberOfTasks(), DIAG_MAX_TASKS);
+            too_many_logged = true;
+        }
+        snprintf(task_text[0], sizeof(task_text[0]), "Stacks: more than %d tasks", DIAG_MAX_TASKS);
+        task_text[1][0] = '\0';
+    } else {
+        sort_tasks_by_stack(count);
+        for (int col = 0; col < 2; col++) {
+            int len = 0;
+            task_text[col][0] = '\0';
+            for (int row = 0; row < DIAG_TASK_ROWS; row++) {
+                UBaseType_t i = col * DIAG_TASK_ROWS + row;
+                if (i >= count || len >= (int)sizeof(task_text[col])) {
+                    break;
+                }
+                const TaskStatus_t *task = &task_status[task_order[i]];
+                len += snprintf(task_text[col] + len, sizeof(task_text[col]) - len,
+                                "%s%.12s  %u", row ? "\n" : "", task->pcTaskName,
+                                (unsigned)task->usStackHighWaterMark);
+            }
+        }
+    }
+    lv_label_set_text_static(ui.task_labels[0], task_text[0]);
+    lv_label_set_text_static(ui.task_labels[1], task_text[1]);
+
+    prev_tick = now;
+    prev_render_frames = render_frames;
+    prev_sensor_frames = sensor_frames;
+    prev_total_runtime = total_runtime;
+    primed = true;
+}
+
+/**
+ * @brief Create a one line label in the overlay panel
+ */
+static lv_obj_t *create_label(lv_obj_t *parent, int32_t x, int32_t y, lv_color_t color)
+{
+    lv_obj_t *label = lv_label_create(parent);
+    lv_obj_set_style_text_color(label, color, 0);
+    lv_obj_set_style_text_font(label, &lv_font_montserrat_10, 0);
+    lv_obj_set_pos(label, x, y);
+    lv_label_set_text_static(label, "");
+    return label;
+}
+
+/**
+ * @brief Show the diagnostics overlay
+ */
+void radar_diag_show(lv_display_t *disp)
+{
+    if (ui.panel != NULL) {
+        return;
+    }
+
+    ui.disp = disp;
+    ui.panel = lv_obj_create(lv_layer_top());
+    lv_obj_set_size(ui.panel, 320, DIAG_HEIGHT);
+    lv_obj_align(ui.panel, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_color(ui.panel, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(ui.panel, LV_OPA_80, 0);
+    lv_obj_set_style_border_width(ui.panel, 1, 0);
+    lv_obj_set_style_border_color(ui.panel, lv_color_hex(0x3B82F6), 0);
+    lv_obj_set_style_radius(ui.panel, 0, 0);
+    lv_obj_set_style_pad_all(ui.panel, 4, 0);
+    lv_obj_clear_flag(ui.panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_clear_flag(ui.panel, LV_OBJ_FLAG_CLICKABLE);
+
+    ui.rate_label = create_label(ui.panel, 0, 0, lv_color_hex(0x00FF00));
+    ui.heap_label = create_label(ui.panel, 0, 14, lv_color_hex(0xFFFFFF));
+    ui.lvgl_label = create_label(ui.panel, 0, 28, lv_color_hex(0xFFFFFF));
+    ui.task_labels[0] = create_label(ui.panel, 0, 44, lv_color_hex(0xFFFF00));
+    ui.task_labels[1] = create_label(ui.panel, 156, 44, lv_color_hex(0xFFFF00));
+
+    lv_display_add_event_cb(disp, render_ready_cb, LV_EVENT_RENDER_READY, NULL);
+
+    // Prime the baselines now so the first period shows real rates
+    primed = false;
+    diag_timer_cb(NULL);
+    ui.timer = lv_timer_create(diag_timer_cb, CONFIG_RADAR_DIAG_PERIOD_MS, NULL);
+
+    ESP_LOGI(TAG, "Diagnostics overlay shown");
+}
+
+/**
+ * @brief Hide the diagnostics overlay
+ */
+void radar_diag_hide(void)
+{
+    if (ui.panel == NULL) {
+        return;
+    }
+
+    if (ui.timer) {
+        lv_timer_del(ui.timer);
+    }
+    lv_display_remove_event_cb_with_user_data(ui.disp, render_ready_cb, NULL);
+    lv_obj_del(ui.panel);
+    memset(&ui, 0, sizeof(ui));
+
+    ESP_LOGI(TAG, "Diagnostics overlay hidden");
+}
+
+bool radar_diag_is_visible(void)
+{
+    return ui.panel != NULL;
+}
+
+void radar_diag_note_sensor_frame(void)
+{
+    sensor_frames++;
+}
@@ -0,0 +1,55 @@
+/*
+ * ui_radar_diag.h
+ * Live performance overlay: frame rates, CPU load, heap and task stacks
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#pragma once
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Show the diagnostics overlay
+ *
+ * Creates a panel on the top layer, above whichever radar view is active,
+ * and starts sampling every CONFIG_RADAR_DIAG_PERIOD_MS. Shows:
+ * - UI frames/s (rendered refreshes) and sensor frames/s
+ * - Per-core CPU load from the FreeRTOS run-time stats
+ * - Internal and PSRAM free heap, largest free block
+ * - LVGL heap usage and fragmentation
+ * - Stack high-water mark of each task, lowest first
+ *
+ * All buffers are static, so the overlay does not allocate while it runs.
+ * Call with bsp_display_lock held.
+ *
+ * @param disp LVGL display handle
+ */
+void radar_diag_show(lv_display_t *disp);
+
+/**
+ * @brief Hide the diagnostics overlay and stop sampling
+ *
+ * Call with bsp_display_lock held.
+ */
+void radar_diag_hide(void);
+
+/**
+ * @brief Whether the diagnostics overlay is shown
+ */
+bool radar_diag_is_visible(void);
+
+/**
+ * @brief Count one received sensor frame
+ *
+ * Call from the radar task for every frame; safe without the display lock.
+ */
+void radar_diag_note_sensor_frame(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,7 +7,15 @@
 
 #include "lvgl.h"
 #include "humanRadarRD_03D.h"
+#include "radar_activity.h"
+#include "radar_frame.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Smaller changes than these leave a label as it is, so sensor jitter does not rewrite it
+#define DEADBAND_MM         10      // Position, distance; also mm/s for speed
+#define DEADBAND_TENTHS     10      // Angle, one degree
 
 // UI element handles
 typedef struct {
@@ -20,7 +28,30 @@ typedef struct {
     lv_obj_t *pos_labels[RADAR_MAX_TARGETS];
 } radar_display_ui_t;
 
+// Last values rendered per target; a label changes once its value leaves the deadband
+typedef struct {
+    bool valid;         // false forces every label to be rewritten
+    bool show;          // data fields (rather than placeholders) are on screen
+    int32_t x;          // mm
+    int32_t y;          // mm
+    int32_t distance;   // mm
+    int32_t angle;      // tenths of a degree
+    int32_t speed;      // mm/s
+    radar_activity_t activity;
+} radar_display_cache_t;
+
 static radar_display_ui_t ui;
+static radar_display_cache_t shown[RADAR_MAX_TARGETS];
+static radar_target_derived_t derived[RADAR_MAX_TARGETS];
+static uint32_t label_updates = 0;
+static bool replay_activity_set = false;
+static uint8_t replay_activity[RADAR_MAX_TARGETS];
+
+// Preallocated label text, referenced with lv_label_set_text_static()
+static char status_text[RADAR_MAX_TARGETS][16];
+static char coord_text[RADAR_MAX_TARGETS][32];
+static char data_text[RADAR_MAX_TARGETS][48];
+static char pos_text[RADAR_MAX_TARGETS][64];
 
 /**
  * @brief Create the UI layout for radar target display
@@ -30,6 +61,8 @@ static radar_display_ui_t ui;
 void radar_display_create_ui(lv_obj_t *parent)
 {
     ui.scr = parent;
+    memset(shown, 0, sizeof(shown));
+    memset(derived, 0, sizeof(derived));
 
     // Set background color
     lv_obj_set_style_bg_color(parent, lv_color_hex(0x000000), 0);
@@ -97,48 +130,210 @@ void radar_display_create_ui(lv_obj_t *parent)
     }
 }
 
+/**
+ * @brief Append a signed decimal integer to a text buffer
+ *
+ * @return Pointer to the terminating NUL written after the digits
+ */
+static char *fmt_int(char *p, int32_t value)
+{
+    char digits[11];
+    int n = 0;
+    uint32_t v = (value < 0) ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+
+    if (value < 0) {
+        *p++ = '-';
+    }
+    do {
+        digits[n++] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief Append a fixed-point value with one decimal (value is in tenths)
+ */
+static char *fmt_tenths(char *p, int32_t tenths)
+{
+    if (tenths < 0) {
+        *p++ = '-';
+        tenths = -tenths;
+    }
+    p = fmt_int(p, tenths / 10);
+    *p++ = '.';
+    *p++ = (char)('0' + (tenths % 10));
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief Append a string to a text buffer
+ */
+static char *fmt_str(char *p, const char *s)
+{
+    while (*s) {
+        *p++ = *s++;
+    }
+    *p = '\0';
+    return p;
+}
+
+/**
+ * @brief Whether a value moved far enough from the one on screen to be rewritten
+ *
+ * Settling at exactly zero always counts, so a stopped target reads 0.
+ */
+static inline bool outside_deadband(int32_t shown, int32_t now, int32_t deadband)
+{
+    return abs(now - shown) >= deadband || (now == 0 && shown != 0);
+}
+
+/**
+ * @brief Point a label at its static text buffer and count the update
+ */
+static void set_label_text(lv_obj_t *label, const char *text)
+{
+    lv_label_set_text_static(label, text);
+    label_updates++;
+}
+
 /**
  * @brief Update the display with current radar target data
  *
- * @param targets Array of radar_target_t structures
- * @param targetId Number of target in the array
- * @param hasMoved Boolean indicating if the target has moved
+ * Only labels whose value differs from what is already on screen are
+ * touched, and only once it moved past a small deadband, so a stationary
+ * person causes no redraw despite sensor jitter. Distance, angle and
+ * the position text are derived only when the position changed.
+ *
+ * @param frame Radar frame
+ * @param targetId Number of target in the frame
  */
-void radar_display_update(radar_target_t *targets, int targetId, bool hasMoved) 
+void radar_display_update(const radar_frame_t *frame, int targetId)
 {
-    if (targets == NULL) {
+    if (frame == NULL || targetId < 0 || targetId >= RADAR_MAX_TARGETS ||
+        ui.target_panels[targetId] == NULL) {
         return;
     }
 
-	if (hasMoved || targets[targetId].detected) {
-		// Target is detected - show all data
+    const radar_point_t *target = &frame->targets[targetId];
+    radar_display_cache_t *cache = &shown[targetId];
+    // Only a detected target has data worth showing
+    bool show = radar_frame_detected(frame, targetId);
+    bool repaint = !cache->valid || cache->show != show;
+    char *p;
 
-		// Update target status
-		lv_label_set_text_fmt(ui.target_labels[targetId], "T%d: DETECTED", targetId);
-		lv_obj_set_style_text_color(ui.target_labels[targetId], lv_color_hex(0x00FF00),
-									0);
+	// Update target status (only on a detected/lost transition)
+	if (repaint) {
+		p = fmt_str(status_text[targetId], "T");
+		p = fmt_int(p, targetId);
+		fmt_str(p, show ? ": DETECTED" : ": NO TARGET");
+		set_label_text(ui.target_labels[targetId], status_text[targetId]);
+		lv_obj_set_style_text_color(ui.target_labels[targetId],
+									lv_color_hex(show ? 0x00FF00 : 0xFF0000), 0);
+	}
+
+	if (show) {
+		// Target is detected - show all data
+		bool moved = repaint || outside_deadband(cache->x, target->x, DEADBAND_MM) ||
+					 outside_deadband(cache->y, target->y, DEADBAND_MM);
 
 		// Update coordinates (in mm)
-		lv_label_set_text_fmt(ui.coord_labels[targetId], "X: %.0f mm  Y: %.0f mm",
-							  targets[targetId].x, targets[targetId].y);
+		if (moved) {
+			p = fmt_str(coord_text[targetId], "X: ");
+			p = fmt_int(p, target->x);
+			p = fmt_str(p, " mm  Y: ");
+			p = fmt_int(p, target->y);
+			fmt_str(p, " mm");
+			set_label_text(ui.coord_labels[targetId], coord_text[targetId]);
+			cache->x = target->x;
+			cache->y = target->y;
+		}
 
-		// Update distance, angle, speed
-		lv_label_set_text_fmt(
-			ui.data_labels[targetId], "D: %.0fmm A: %.1f° S: %.0fmm/s",
-			targets[targetId].distance, targets[targetId].angle, targets[targetId].speed);
+		// Update distance, angle, speed; derived values only follow a move
+		const radar_target_derived_t *d = radar_frame_derive(frame, targetId, &derived[targetId]);
+		int32_t distance = d->distance;
+		int32_t angle = d->angle;
+		int32_t speed = target->speed;
+		if (repaint || outside_deadband(cache->distance, distance, DEADBAND_MM) ||
+			outside_deadband(cache->angle, angle, DEADBAND_TENTHS) ||
+			outside_deadband(cache->speed, speed, DEADBAND_MM)) {
+			p = fmt_str(data_text[targetId], "D: ");
+			p = fmt_int(p, distance);
+			p = fmt_str(p, "mm A: ");
+			p = fmt_tenths(p, angle);
+			p = fmt_str(p, "° S: ");
+			p = fmt_int(p, speed);
+			fmt_str(p, "mm/s");
+			set_label_text(ui.data_labels[targetId], data_text[targetId]);
+			cache->distance = distance;
+			cache->angle = angle;
+			cache->speed = speed;
+		}
 
-		// Update position description
-		lv_label_set_text(ui.pos_labels[targetId], targets[targetId].position_description);
+		// Update position description and activity
+		radar_activity_t activity = replay_activity_set ? (radar_activity_t)replay_activity[targetId]
+													   : radar_activity_get(targetId);
+		if (moved || cache->activity != activity) {
+			// The sensor library's own text where the frame has it; merged and
+			// replayed frames fall back to a sector and range from x/y
+			char text[sizeof(pos_text[targetId])];
+			if (radar_frame_sensor_text(frame, targetId, text, sizeof(text))) {
+				p = text + strlen(text);
+			} else {
+				p = fmt_str(text, radar_frame_describe(frame, targetId, &derived[targetId]));
+			}
+			if (activity != RADAR_ACTIVITY_NONE) {
+				p = fmt_str(p, " - ");
+				fmt_str(p, radar_activity_name(activity));
+			}
+			if (repaint || strcmp(pos_text[targetId], text) != 0) {
+				strcpy(pos_text[targetId], text);
+				set_label_text(ui.pos_labels[targetId], pos_text[targetId]);
+			}
+			if (repaint || (cache->activity == RADAR_ACTIVITY_FALL) != (activity == RADAR_ACTIVITY_FALL)) {
+				lv_obj_set_style_text_color(ui.pos_labels[targetId],
+											lv_color_hex(activity == RADAR_ACTIVITY_FALL ? 0xFF4040 : 0xFFFF00), 0);
+			}
+			cache->activity = activity;
+		}
 
-	} else {
+	} else if (repaint) {
 		// No target detected
-		lv_label_set_text_fmt(ui.target_labels[targetId], "T%d: NO TARGET", targetId);
-		lv_obj_set_style_text_color(ui.target_labels[targetId], lv_color_hex(0xFF0000),	0);
-
-		lv_label_set_text(ui.coord_labels[targetId], "X: ---  Y: ---");
-		lv_label_set_text(ui.data_labels[targetId], "D: --- A: --- S: ---");
-		lv_label_set_text(ui.pos_labels[targetId], "No target detected");
+		set_label_text(ui.coord_labels[targetId], "X: ---  Y: ---");
+		set_label_text(ui.data_labels[targetId], "D: --- A: --- S: ---");
+		set_label_text(ui.pos_labels[targetId], "No target detected");
+		if (cache->activity == RADAR_ACTIVITY_FALL) {
+			lv_obj_set_style_text_color(ui.pos_labels[targetId], lv_color_hex(0xFFFF00), 0);
+		}
+		cache->activity = RADAR_ACTIVITY_NONE;
 	}
+
+	cache->show = show;
+	cache->valid = true;
+}
+
+/**
+ * @brief Show recorded activities instead of the live classification
+ */
+void radar_display_set_activity(const uint8_t activity[RADAR_MAX_TARGETS])
+{
+    replay_activity_set = activity != NULL;
+    if (activity) {
+        memcpy(replay_activity, activity, sizeof(replay_activity));
+    }
+}
+
+/**
+ * @brief Number of label text changes since boot
+ */
+uint32_t radar_display_get_label_updates(void)
+{
+    return label_updates;
 }
 
 /**
@@ -148,7 +343,7 @@ void radar_display_update(radar_target_t *targets, int targetId, bool hasMoved)
  */
 void radar_display_delete_ui(void)
 {
-    // Delete all created objects
+    // Delete all created objects; the labels go with their panels
     if (ui.title_label) {
         lv_obj_del(ui.title_label);
     }
@@ -158,6 +353,9 @@ void radar_display_delete_ui(void)
             lv_obj_del(ui.target_panels[i]);
         }
     }
+
+    // Forget the deleted objects so a late update or second delete is harmless
+    memset(&ui, 0, sizeof(ui));
 }
 
 /**
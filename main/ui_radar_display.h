@@ -8,7 +8,7 @@
 #pragma once
 
 #include "lvgl.h"
-#include "humanRadarRD_03D.h"
+#include "radar_frame.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,7 +21,7 @@ extern "C" {
  * - Target ID and detection status
  * - X, Y coordinates in mm
  * - Distance, angle, and speed
- * - Position description
+ * - Position description and activity
  *
  * @param parent Parent LVGL object (typically the screen)
  */
@@ -34,14 +34,38 @@ void radar_display_create_ui(lv_obj_t *parent);
  *
  * Example:
  *   bsp_display_lock(0);
- *   radar_display_update(targets, target_count);
+ *   radar_display_update(frame, targetId);
  *   bsp_display_unlock();
  *
- * @param targets Array of radar_target_t structures
- * @param targetId Number of target in the array
- * @param hasMoved Boolean indicating if the target has moved
+ * Labels are only rewritten when the integer value they show changes,
+ * so stationary targets cost no text re-layout or redraw. Distance,
+ * angle and position text are derived from x/y only after a move. The
+ * deadband decides what changed, so no moved flag is taken.
+ *
+ * @param frame Radar frame
+ * @param targetId Number of target in the frame
+ */
+void radar_display_update(const radar_frame_t *frame, int targetId);
+
+/**
+ * @brief Show recorded activities instead of the live classification
+ *
+ * While set, radar_display_update() labels each target with the given
+ * activity, as kept with a replayed frame, rather than asking
+ * radar_activity_get() for the current one.
+ *
+ * @param activity radar_activity_t per target, copied; NULL to go back to live
+ */
+void radar_display_set_activity(const uint8_t activity[RADAR_MAX_TARGETS]);
+
+/**
+ * @brief Number of label text changes made by radar_display_update()
+ *
+ * Monotonic counter since boot; sample it twice to get updates per second.
+ *
+ * @return Total label updates
  */
-void radar_display_update(radar_target_t *targets, int targetId, bool hasMoved);
+uint32_t radar_display_get_label_updates(void);
 
 /**
  * @brief Clean up and delete all UI elements
@@ -0,0 +1,182 @@
+/*
+ * ui_radar_history.c
+ * History view: the last 24 hours from the flash history log
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#include "ui_radar_history.h"
+#include "esp_log.h"
+#include "radar_history.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "RadarHistoryUI";
+
+#define HISTORY_PERIOD_MS   60000
+#define HISTORY_HOURS       24
+
+typedef struct {
+    lv_obj_t *title_label;
+    lv_obj_t *chart;
+    lv_chart_series_t *occupied_series;
+    lv_chart_series_t *entries_series;
+    lv_obj_t *totals_label;
+    lv_timer_t *timer;
+} radar_history_ui_t;
+
+// Per-hour sums collected by the query callback
+typedef struct {
+    uint32_t from_minute;
+    uint32_t occupied_s[HISTORY_HOURS];
+    uint32_t entries[HISTORY_HOURS];
+    uint32_t total_entries;
+    uint32_t total_exits;
+    uint16_t min_mm;
+    uint16_t max_mm;
+} history_bins_t;
+
+static radar_history_ui_t ui;
+
+// Chart points, referenced with lv_chart_set_series_ext_y_array()
+static int32_t occupied_points[HISTORY_HOURS];
+static int32_t entries_points[HISTORY_HOURS];
+static history_bins_t bins;
+static char totals_text[80];
+
+/**
+ * @brief Add one minute record to its hour
+ */
+static bool bin_record(const radar_history_record_t *record, void *ctx)
+{
+    history_bins_t *b = ctx;
+    uint32_t hour = (record->minute - b->from_minute) / 60;
+
+    if (hour >= HISTORY_HOURS) {
+        return true;
+    }
+    b->occupied_s[hour] += record->occupied_s;
+    b->entries[hour] += record->entries;
+    b->total_entries += record->entries;
+    b->total_exits += record->exits;
+    if (record->min_mm && (b->min_mm == 0 || record->min_mm < b->min_mm)) {
+        b->min_mm = record->min_mm;
+    }
+    if (record->max_mm > b->max_mm) {
+        b->max_mm = record->max_mm;
+    }
+    return true;
+}
+
+/**
+ * @brief Query the last 24 hours and redraw the chart
+ */
+static void history_timer_cb(lv_timer_t *timer)
+{
+    uint32_t now = radar_history_now_minute();
+    int32_t max_entries = 4;
+
+    if (ui.chart == NULL) {
+        return;
+    }
+    if (now == 0) {
+        lv_label_set_text_static(ui.totals_label, "Waiting for the clock to be set");
+        return;
+    }
+
+    // Whole local hours, the current one on the right; localtime_r() follows
+    // CONFIG_RADAR_TIMEZONE, including half-hour offsets and summer time
+    time_t now_s = (time_t)now * 60;
+    struct tm local;
+    localtime_r(&now_s, &local);
+    memset(&bins, 0, sizeof(bins));
+    bins.from_minute = now - local.tm_min - (HISTORY_HOURS - 1) * 60;
+    int sectors = radar_history_query(bins.from_minute, now, bin_record, &bins);
+    ESP_LOGD(TAG, "24 h query read %d sector(s)", sectors);
+
+    for (int h = 0; h < HISTORY_HOURS; h++) {
+        occupied_points[h] = (int32_t)(bins.occupied_s[h] / 60);
+        entries_points[h] = (int32_t)bins.entries[h];
+        if (entries_points[h] > max_entries) {
+            max_entries = entries_points[h];
+        }
+    }
+    lv_chart_set_axis_range(ui.chart, LV_CHART_AXIS_SECONDARY_Y, 0, max_entries);
+    lv_chart_refresh(ui.chart);
+
+    snprintf(totals_text, sizeof(totals_text),
+             "In %" PRIu32 "  Out %" PRIu32 "  Nearest %u.%u m  Farthest %u.%u m",
+             bins.total_entries, bins.total_exits,
+             bins.min_mm / 1000, (bins.min_mm % 1000) / 100,
+             bins.max_mm / 1000, (bins.max_mm % 1000) / 100);
+    lv_label_set_text_static(ui.totals_label, totals_text);
+}
+
+/**
+ * @brief Create the history view
+ */
+void radar_history_create_ui(lv_obj_t *parent)
+{
+    lv_obj_set_style_bg_color(parent, lv_color_hex(0x000000), 0);
+
+    ui.title_label = lv_label_create(parent);
+    lv_label_set_text(ui.title_label, "Last 24 h: occupied min / entries");
+    lv_obj_set_style_text_color(ui.title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(ui.title_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(ui.title_label, LV_ALIGN_TOP_MID, 0, 5);
+
+    ui.chart = lv_chart_create(parent);
+    lv_obj_set_size(ui.chart, 300, 170);
+    lv_obj_set_pos(ui.chart, 10, 30);
+    lv_chart_set_type(ui.chart, LV_CHART_TYPE_BAR);
+    lv_chart_set_point_count(ui.chart, HISTORY_HOURS);
+    lv_chart_set_div_line_count(ui.chart, 5, 0);
+    lv_chart_set_axis_range(ui.chart, LV_CHART_AXIS_PRIMARY_Y, 0, 60);
+    lv_chart_set_axis_range(ui.chart, LV_CHART_AXIS_SECONDARY_Y, 0, 4);
+    lv_obj_set_style_bg_color(ui.chart, lv_color_hex(0x101010), 0);
+    lv_obj_set_style_border_width(ui.chart, 0, 0);
+    lv_obj_set_style_radius(ui.chart, 0, 0);
+    lv_obj_set_style_pad_all(ui.chart, 4, 0);
+    lv_obj_set_style_pad_column(ui.chart, 2, 0);
+    lv_obj_set_style_line_color(ui.chart, lv_color_hex(0x303030), 0);
+
+    memset(occupied_points, 0, sizeof(occupied_points));
+    memset(entries_points, 0, sizeof(entries_points));
+    ui.occupied_series = lv_chart_add_series(ui.chart, lv_color_hex(0x00A0A0), LV_CHART_AXIS_PRIMARY_Y);
+    ui.entries_series = lv_chart_add_series(ui.chart, lv_color_hex(0xFFFF00), LV_CHART_AXIS_SECONDARY_Y);
+    lv_chart_set_series_ext_y_array(ui.chart, ui.occupied_series, occupied_points);
+    lv_chart_set_series_ext_y_array(ui.chart, ui.entries_series, entries_points);
+
+    ui.totals_label = lv_label_create(parent);
+    lv_label_set_text(ui.totals_label, "In --  Out --");
+    lv_obj_set_style_text_color(ui.totals_label, lv_color_hex(0xCCCCCC), 0);
+    lv_obj_set_style_text_font(ui.totals_label, &lv_font_montserrat_12, 0);
+    lv_obj_set_pos(ui.totals_label, 10, 210);
+
+    ui.timer = lv_timer_create(history_timer_cb, HISTORY_PERIOD_MS, NULL);
+    history_timer_cb(ui.timer);
+}
+
+/**
+ * @brief Delete the history view and stop its refresh timer
+ */
+void radar_history_delete_ui(void)
+{
+    if (ui.timer) {
+        lv_timer_del(ui.timer);
+    }
+    if (ui.title_label) {
+        lv_obj_del(ui.title_label);
+    }
+    if (ui.chart) {
+        lv_obj_del(ui.chart);
+    }
+    if (ui.totals_label) {
+        lv_obj_del(ui.totals_label);
+    }
+
+    // Forget the deleted objects so a late timer or second delete is harmless
+    memset(&ui, 0, sizeof(ui));
+}
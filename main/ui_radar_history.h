@@ -0,0 +1,37 @@
+/*
+ * ui_radar_history.h
+ * History view: the last 24 hours from the flash history log
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#pragma once
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the history view
+ *
+ * An lv_chart of occupied minutes and entries for each of the last 24
+ * hours, newest on the right, with the totals and the nearest and
+ * farthest distance below. The view queries radar_history once a minute
+ * and needs no per-frame updates. Call with bsp_display_lock held.
+ *
+ * @param parent Parent LVGL object (typically the screen)
+ */
+void radar_history_create_ui(lv_obj_t *parent);
+
+/**
+ * @brief Delete the history view and stop its refresh timer
+ *
+ * Call with bsp_display_lock held.
+ */
+void radar_history_delete_ui(void);
+
+#ifdef __cplusplus
+}
+#endif
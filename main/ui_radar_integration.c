@@ -6,60 +6,167 @@
 
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "iot_button.h"
 #include "lvgl.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "audio.h"
 #include "humanRadarRD_03D.h"
+#include "radar_activity.h"
+#include "radar_budget.h"
+#include "radar_bus.h"
+#include "radar_governor.h"
+#include "radar_mqtt.h"
+#include "radar_refresh.h"
+#include "radar_replay.h"
+#include "radar_web.h"
+#include "sdkconfig.h"
+#include "ui_radar_diag.h"
 #include "ui_radar_display.h"
+#include "ui_radar_history.h"
+#include "ui_radar_integration.h"
+#include "ui_radar_summary.h"
 #include "ui_radar_sweep.h"
 
 extern void logMemoryStats(char *message);
 
 static const char *TAG = "RadarIntegration";
 
-// Display mode
-typedef enum {
-    DISPLAY_MODE_LIST,      // List view (ui_radar_display)
-    DISPLAY_MODE_SWEEP,     // Radar sweep view (ui_radar_sweep)
-} display_mode_t;
+#if CONFIG_RADAR_LVGL_ON_DEMAND
+#define UI_POLL_MS          CONFIG_RADAR_LVGL_MAX_SLEEP_MS  // Made due at once by radar_refresh_wake()
+#else
+#define UI_POLL_MS          10      // Command and frame polling period on the LVGL task
+#endif
+#define UI_CMD_QUEUE_LEN    16      // Power of two
+#define SCRUB_LEAD_MS       3000    // Frames this far before a scrubbed one are replayed to redraw its sweep trails
 
 static display_mode_t current_mode = DISPLAY_MODE_SWEEP;
 static lv_obj_t *current_screen = NULL;
+static lv_display_t *current_disp = NULL;
+static bool animation_running = true;
+
+// Single producer (the button task), single consumer (the LVGL task)
+static uint8_t cmd_queue[UI_CMD_QUEUE_LEN];
+static _Atomic uint32_t cmd_head = 0;
+static _Atomic uint32_t cmd_tail = 0;
+static uint32_t cmd_dropped = 0;
+
+static radar_bus_sub_t *display_sub = NULL;
+static TaskHandle_t stats_task_handle = NULL;
+static radar_frame_t shown_frame;   // Last frame applied to the view
+
+// Pause and scrub, LVGL task only
+static const uint16_t scrub_steps[] = {100, 1000, 10000};   // ms
+static bool paused = false;
+static uint32_t scrub_index = 0;        // Replay number of the frame shown
+static uint32_t pause_time_ms = 0;      // Time of the frame shown when paused
+static uint8_t scrub_step = 0;
+static radar_motion_mode_t live_motion_mode;
+static lv_obj_t *scrub_label = NULL;
+static char scrub_text[48];
 
 /**
- * @brief Switch between display modes
- *
- * This function can be called from a button handler to toggle views
+ * @brief Create the view for a display mode
  */
-void radar_switch_display_mode(lv_display_t *disp)
+static void create_view(lv_obj_t *screen, display_mode_t mode)
 {
-    bsp_display_lock(0);
+    switch (mode) {
+    case DISPLAY_MODE_LIST:
+        radar_display_create_ui(screen);
+        break;
+    case DISPLAY_MODE_SWEEP:
+        radar_sweep_create_ui(screen);
+        // A new sweep view starts animating; keep it stopped if it was held
+        if (!animation_running) {
+            radar_sweep_stop_animation();
+        }
+        break;
+    case DISPLAY_MODE_SUMMARY:
+        radar_summary_create_ui(screen);
+        break;
+    default:
+        radar_history_create_ui(screen);
+        break;
+    }
+}
+
+/**
+ * @brief Delete the view of a display mode
+ */
+static void delete_view(display_mode_t mode)
+{
+    switch (mode) {
+    case DISPLAY_MODE_LIST:
+        radar_display_delete_ui();
+        break;
+    case DISPLAY_MODE_SWEEP:
+        radar_sweep_delete_ui();
+        break;
+    case DISPLAY_MODE_SUMMARY:
+        radar_summary_delete_ui();
+        break;
+    default:
+        radar_history_delete_ui();
+        break;
+    }
+}
+
+/**
+ * @brief Replace the active view; caller holds the display lock
+ */
+static void show_mode(lv_display_t *disp, display_mode_t mode)
+{
+    static const char *mode_names[DISPLAY_MODE_COUNT] = {"LIST", "SWEEP", "SUMMARY", "HISTORY"};
 
     // Get the active screen
 	lv_obj_t *screen = lv_disp_get_scr_act(disp);
 
 	// Clean up current display
-    if (current_mode == DISPLAY_MODE_LIST) {
-        radar_display_delete_ui();
-        current_mode = DISPLAY_MODE_SWEEP;
-        ESP_LOGI(TAG, "Switching to SWEEP mode");
-    } else {
-        radar_sweep_delete_ui();
-        current_mode = DISPLAY_MODE_LIST;
-        ESP_LOGI(TAG, "Switching to LIST mode");
-    }
+    delete_view(current_mode);
+    current_mode = mode;
+    ESP_LOGI(TAG, "Switching to %s mode", mode_names[mode]);
 
     // Clear screen
     lv_obj_clean(screen);
 
     // Create new display
+    create_view(screen, current_mode);
+}
+
+/**
+ * @brief Show a given display mode
+ */
+void radar_set_display_mode(lv_display_t *disp, display_mode_t mode)
+{
+    bsp_display_lock(0);
+    show_mode(disp, mode);
+    bsp_display_unlock();
+}
+
+/**
+ * @brief Switch to the next display mode
+ *
+ * This function can be called from a button handler to cycle views
+ */
+void radar_switch_display_mode(lv_display_t *disp)
+{
+    radar_set_display_mode(disp, (current_mode + 1) % DISPLAY_MODE_COUNT);
+}
+
+/**
+ * @brief Apply one target of a frame to the active view; caller holds the display lock
+ */
+static void update_view(const radar_frame_t *frame, int targetId, bool hasMoved)
+{
     if (current_mode == DISPLAY_MODE_LIST) {
-        radar_display_create_ui(screen);
+        radar_display_update(frame, targetId);
     } else {
-        radar_sweep_create_ui(screen);
+        radar_sweep_update(frame, targetId, hasMoved);
     }
-
-    bsp_display_unlock();
 }
 
 /**
@@ -67,20 +174,364 @@ void radar_switch_display_mode(lv_display_t *disp)
  *
  * Call this from your radar task after receiving new data
  */
-void radar_update_current_display(radar_target_t *targets, int targetId, bool hasMoved)
+void radar_update_current_display(const radar_frame_t *frame, int targetId, bool hasMoved)
 {
-    if (targets == NULL) {
+    // The summary and history views refresh themselves from their stores
+    if (frame == NULL || current_mode >= DISPLAY_MODE_SUMMARY) {
         return;
     }
 
     bsp_display_lock(0);
+    update_view(frame, targetId, hasMoved);
+    bsp_display_unlock();
+}
 
-    if (current_mode == DISPLAY_MODE_LIST) {
-        radar_display_update(targets, targetId, hasMoved);
-    } else {
-        radar_sweep_update(targets, targetId, hasMoved);
+/**
+ * @brief Queue a UI command for the LVGL task
+ */
+bool radar_ui_post(radar_ui_cmd_t cmd)
+{
+    uint32_t head = atomic_load_explicit(&cmd_head, memory_order_relaxed);
+
+    if (head - atomic_load_explicit(&cmd_tail, memory_order_acquire) >= UI_CMD_QUEUE_LEN) {
+        cmd_dropped++;
+        return false;
+    }
+    cmd_queue[head % UI_CMD_QUEUE_LEN] = cmd;
+    atomic_store_explicit(&cmd_head, head + 1, memory_order_release);
+    radar_refresh_wake();
+    return true;
+}
+
+/**
+ * @brief Show where the paused view is in the history
+ */
+static void update_scrub_label(void)
+{
+    // Tenths of a second from the paused frame, and per step
+    int32_t offset = (int32_t)((uint32_t)(shown_frame.timestamp_us / 1000) - pause_time_ms) / 100;
+    uint32_t magnitude = offset < 0 ? -offset : offset;
+    uint32_t step = scrub_steps[scrub_step] / 100;
+
+    snprintf(scrub_text, sizeof(scrub_text), "PAUSED %c%" PRIu32 ".%" PRIu32 " s  step %" PRIu32 ".%" PRIu32 " s",
+             offset < 0 ? '-' : '+', magnitude / 10, magnitude % 10, step / 10, step % 10);
+    lv_label_set_text_static(scrub_label, scrub_text);
+}
+
+/**
+ * @brief Redraw the view as it was at a kept frame
+ *
+ * The sweep view is cleared and the frames leading up to the one shown
+ * are replayed through the usual update path, so its trails are as they
+ * were; the list view only needs the frame itself.
+ */
+static void show_replay(uint32_t index)
+{
+    static radar_frame_t frame;
+    uint8_t activity[RADAR_MAX_TARGETS];
+    uint32_t oldest, newest;
+    uint32_t first = index;
+
+    if (!radar_replay_range(&oldest, &newest)) {
+        return;
+    }
+    if (current_mode == DISPLAY_MODE_SWEEP) {
+        memset(&frame, 0, sizeof(frame));
+        for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+            update_view(&frame, idx, radar_frame_target_moved(&frame, &shown_frame, idx));
+        }
+        shown_frame = frame;
+        if (radar_replay_get(index, &frame, NULL)) {
+            radar_replay_seek((uint32_t)(frame.timestamp_us / 1000) - SCRUB_LEAD_MS, true, &first);
+        }
+    }
+    for (uint32_t i = first; i <= index; i++) {
+        if (!radar_replay_get(i, &frame, activity)) {
+            continue;
+        }
+        radar_display_set_activity(activity);
+        for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+            update_view(&frame, idx, radar_frame_target_moved(&frame, &shown_frame, idx));
+        }
+        shown_frame = frame;
+    }
+    if (current_mode == DISPLAY_MODE_SWEEP) {
+        radar_sweep_update_info(shown_frame.target_count);
+    }
+}
+
+/**
+ * @brief Freeze the view on the frame shown, or go back to live frames
+ */
+static void toggle_pause(void)
+{
+    uint32_t oldest, newest;
+
+    if (!paused) {
+        if (current_mode >= DISPLAY_MODE_SUMMARY || !radar_replay_range(&oldest, &newest)) {
+            ESP_LOGI(TAG, "Pause needs the list or sweep view and recorded frames");
+            return;
+        }
+        paused = true;
+        scrub_index = newest;
+        if (current_mode == DISPLAY_MODE_SWEEP) {
+            // Markers jump between scrubbed frames; no sweep, so the view looks frozen
+            live_motion_mode = radar_sweep_get_motion_mode();
+            radar_sweep_set_motion_mode(RADAR_MOTION_SNAP);
+            if (animation_running) {
+                radar_sweep_stop_animation();
+            }
+        }
+        show_replay(scrub_index);
+        pause_time_ms = (uint32_t)(shown_frame.timestamp_us / 1000);
+        scrub_label = lv_label_create(lv_layer_top());
+        lv_obj_set_style_text_color(scrub_label, lv_color_hex(0xFFFF00), 0);
+        lv_obj_set_style_text_font(scrub_label, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_bg_color(scrub_label, lv_color_hex(0x000000), 0);
+        lv_obj_set_style_bg_opa(scrub_label, LV_OPA_70, 0);
+        lv_obj_align(scrub_label, LV_ALIGN_TOP_RIGHT, -4, 4);
+        update_scrub_label();
+        ESP_LOGI(TAG, "Paused at frame %" PRIu32 ", %" PRIu32 " frames kept", scrub_index, newest - oldest + 1);
+        return;
+    }
+
+    paused = false;
+    lv_obj_del(scrub_label);
+    scrub_label = NULL;
+    if (current_mode == DISPLAY_MODE_SWEEP) {
+        radar_sweep_set_motion_mode(live_motion_mode);
+        if (animation_running) {
+            radar_sweep_start_animation();
+        }
+    }
+    // Catch up to the newest frame recorded while paused
+    if (radar_replay_range(&oldest, &newest)) {
+        show_replay(newest);
+    }
+    radar_display_set_activity(NULL);
+    ESP_LOGI(TAG, "Live");
+}
+
+/**
+ * @brief Buttons while paused: back, forward and step size
+ */
+static void apply_scrub_command(radar_ui_cmd_t cmd, uint32_t count)
+{
+    uint32_t shown_ms = (uint32_t)(shown_frame.timestamp_us / 1000);
+    uint32_t step_ms = count * scrub_steps[scrub_step];
+    uint32_t target;
+    bool found;
+
+    // By time, not frame count, so a step is the same at any frame rate or
+    // across a gap; the frame nearest the time on the side stepped to is shown
+    switch (cmd) {
+    case RADAR_UI_NEXT_MODE:
+        found = radar_replay_seek(shown_ms - step_ms, false, &target);
+        break;
+    case RADAR_UI_CYCLE_ZOOM:
+        found = radar_replay_seek(shown_ms + step_ms, true, &target);
+        break;
+    case RADAR_UI_TOGGLE_DIAG:
+        scrub_step = (scrub_step + count) % (sizeof(scrub_steps) / sizeof(scrub_steps[0]));
+        update_scrub_label();
+        return;
+    default:
+        return;
+    }
+
+    // Frames keep being recorded while paused, so both ends move on
+    if (found && target != scrub_index) {
+        scrub_index = target;
+        show_replay(scrub_index);
     }
+    update_scrub_label();
+}
+
+/**
+ * @brief Carry out a burst of count identical commands as one
+ */
+static void apply_command(radar_ui_cmd_t cmd, uint32_t count)
+{
+    if (cmd == RADAR_UI_TOGGLE_PAUSE) {
+        if (count & 1) {
+            toggle_pause();
+        }
+        return;
+    }
+    if (cmd == RADAR_UI_TOGGLE_TONE) {
+        if (count & 1) {
+            audio_tone_enable(!audio_tone_is_enabled());
+        }
+        return;
+    }
+    if (paused) {
+        apply_scrub_command(cmd, count);
+        return;
+    }
+
+    switch (cmd) {
+    case RADAR_UI_NEXT_MODE:
+        // Four presses come back to the same view; rebuild it at most once
+        if (count % DISPLAY_MODE_COUNT) {
+            show_mode(current_disp, (current_mode + count) % DISPLAY_MODE_COUNT);
+        }
+        break;
+    case RADAR_UI_CYCLE_ZOOM:
+        if (current_mode == DISPLAY_MODE_SWEEP && count % RADAR_ZOOM_COUNT) {
+            radar_sweep_set_zoom((radar_sweep_get_zoom() + count) % RADAR_ZOOM_COUNT);
+        }
+        break;
+    case RADAR_UI_TOGGLE_DIAG:
+        if (count & 1) {
+            if (radar_diag_is_visible()) {
+                radar_diag_hide();
+            } else {
+                radar_diag_show(current_disp);
+            }
+        }
+        // The task list and stat dumps take milliseconds; keep them off the LVGL task
+        if (stats_task_handle) {
+            xTaskNotifyGive(stats_task_handle);
+        }
+        break;
+    case RADAR_UI_TOGGLE_ANIMATION:
+        if (current_mode == DISPLAY_MODE_SWEEP && (count & 1)) {
+            if (animation_running) {
+                radar_sweep_stop_animation();
+                ESP_LOGI(TAG, "Sweep animation stopped");
+            } else {
+                radar_sweep_start_animation();
+                ESP_LOGI(TAG, "Sweep animation started");
+            }
+            animation_running = !animation_running;
+        }
+        break;
+    default:
+        break;
+    }
+}
 
+/**
+ * @brief Drain the command queue, merging runs of the same command
+ */
+static void apply_commands(void)
+{
+    uint32_t tail = atomic_load_explicit(&cmd_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&cmd_head, memory_order_acquire);
+
+    while (tail != head) {
+        radar_ui_cmd_t cmd = cmd_queue[tail++ % UI_CMD_QUEUE_LEN];
+        uint32_t count = 1;
+
+        while (tail != head && cmd_queue[tail % UI_CMD_QUEUE_LEN] == cmd) {
+            tail++;
+            count++;
+        }
+        atomic_store_explicit(&cmd_tail, tail, memory_order_release);
+        if (count > 1) {
+            ESP_LOGD(TAG, "Command %d x%" PRIu32 " coalesced", cmd, count);
+        }
+        apply_command(cmd, count);
+    }
+}
+
+/**
+ * @brief Apply waiting radar frames to the active view
+ */
+static void apply_frames(void)
+{
+    const radar_frame_t *frame;
+
+    while ((frame = radar_bus_receive(display_sub, 0)) != NULL) {
+        // The replay recorder keeps and classifies every frame on its own subscriber
+        if (paused) {
+            radar_bus_release(display_sub, frame);
+            continue;
+        }
+
+        // Shedding load: only every other frame reaches the view; shown_frame stays the last shown
+        if (radar_governor_level() >= RADAR_QUALITY_HALF_RATE && (frame->seq & 1)) {
+            radar_bus_release(display_sub, frame);
+            continue;
+        }
+
+        for (int idx = 0; idx < RADAR_MAX_TARGETS; idx++) {
+            bool hasMoved = radar_frame_target_moved(frame, &shown_frame, idx);
+
+            // The summary and history views refresh themselves from their stores
+            if (current_mode < DISPLAY_MODE_SUMMARY) {
+                update_view(frame, idx, hasMoved);
+            }
+
+            if (hasMoved) {
+                ESP_LOGD("Radar", "[%d] X:%d Y:%d S:%d %s", idx,
+                         frame->targets[idx].x, frame->targets[idx].y,
+                         frame->targets[idx].speed,
+                         radar_frame_detected(frame, idx) ? "detected" : "lost");
+            }
+        }
+
+        // Update target count info (for sweep display)
+        if (current_mode == DISPLAY_MODE_SWEEP && radar_governor_level() < RADAR_QUALITY_NO_INFO) {
+            radar_sweep_update_info(frame->target_count);
+        }
+
+        radar_governor_note_latency(esp_timer_get_time() - frame->timestamp_us);
+        shown_frame = *frame;
+        radar_bus_release(display_sub, frame);
+    }
+}
+
+/**
+ * @brief UI service timer, runs on the LVGL task with the display lock held
+ *
+ * Button commands first, so a view switch is in place before the frames
+ * that follow are applied to it.
+ */
+static void ui_service_timer_cb(lv_timer_t *timer)
+{
+    radar_refresh_serve_begin();
+    apply_commands();
+    if (display_sub) {
+        apply_frames();
+    }
+    radar_refresh_serve_end();
+}
+
+/**
+ * @brief Stats task, logs the memory and service stats when the overlay button is pressed
+ */
+static void stats_task(void *pvParameters)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        logMemoryStats("Button 2 pressed");
+        radar_bus_log_stats();
+#if CONFIG_RADAR_WEB
+        radar_web_log_stats();
+#endif
+#if CONFIG_RADAR_MQTT
+        radar_mqtt_log_stats();
+#endif
+        radar_refresh_log_stats();
+        ESP_LOGI(TAG, "UI commands dropped: %" PRIu32, cmd_dropped);
+    }
+}
+
+/**
+ * @brief Start the display service
+ */
+void radar_display_service_start(void)
+{
+    radar_bus_sub_t *sub;
+
+    RADAR_TASK_CREATE(stats_task, "UI Stats", 3072, NULL, 1, 0);
+    stats_task_handle = xTaskGetHandle("UI Stats");
+    radar_replay_start();
+    sub = radar_bus_subscribe_polled("display", RADAR_BUS_DROP_OLDEST, 4, 1, radar_refresh_wake);
+
+    bsp_display_lock(0);
+    display_sub = sub;
     bsp_display_unlock();
 }
 
@@ -97,14 +548,12 @@ void radar_display_init(lv_display_t *disp, display_mode_t initial_mode)
 
     lv_obj_t *screen = lv_disp_get_scr_act(disp);
     current_screen = screen;
+    current_disp = disp;
 
-	if (current_mode == DISPLAY_MODE_LIST) {
-        radar_display_create_ui(screen);
-        ESP_LOGI(TAG, "Initialized in LIST mode");
-    } else {
-        radar_sweep_create_ui(screen);
-        ESP_LOGI(TAG, "Initialized in SWEEP mode");
-    }
+    create_view(screen, current_mode);
+    radar_governor_start(disp);
+    radar_refresh_start(disp, lv_timer_create(ui_service_timer_cb, UI_POLL_MS, NULL));
+    ESP_LOGI(TAG, "Initialized in mode %d", current_mode);
 
     bsp_display_unlock();
 }
@@ -120,36 +569,51 @@ display_mode_t radar_get_display_mode(void)
 /**
  * EXAMPLE: Modified button handler that switches displays
  *
- * Add this to your btn_handler in main.c:
+ * Add this to your btn_handler in main.c. Runs in the button task, so it
+ * only queues a command; the LVGL task carries it out.
  */
 void radar_btn_handler_example(void *button_handle, void *usr_data, lv_display_t *disp)
 {
+    // Button 0: Cycle display modes; while paused, step back
+    // Button 1: Cycle the range (only in sweep mode); while paused, step forward
+    // Button 2: Toggle the diagnostics overlay and log statistics; while paused, change the step
+    static const radar_ui_cmd_t button_cmds[] = {
+        RADAR_UI_NEXT_MODE, RADAR_UI_CYCLE_ZOOM, RADAR_UI_TOGGLE_DIAG,
+    };
     int button_index = (int)usr_data;
+    int taps;
 
-    switch (button_index) {
-    case 0:
-        // Button 0: Switch display mode
-        radar_switch_display_mode(disp);
-        break;
-    case 1:
-        // Button 1: Toggle sweep animation (only in sweep mode)
-        if (current_mode == DISPLAY_MODE_SWEEP) {
-            // You could add a static variable to track state
-            static bool animation_running = true;
-            if (animation_running) {
-                radar_sweep_stop_animation();
-                ESP_LOGI(TAG, "Sweep animation stopped");
-            } else {
-                radar_sweep_start_animation();
-                ESP_LOGI(TAG, "Sweep animation started");
-            }
-            animation_running = !animation_running;
+    if (button_index < 0 || button_index >= (int)(sizeof(button_cmds) / sizeof(button_cmds[0]))) {
+        return;
+    }
+    // Registered for BUTTON_PRESS_REPEAT_DONE: one call for a run of quick taps.
+    // Each tap is queued; the LVGL task merges the run into one command.
+    taps = iot_button_get_repeat((button_handle_t)button_handle);
+    for (int i = 0; i < (taps > 0 ? taps : 1); i++) {
+        if (!radar_ui_post(button_cmds[button_index])) {
+            break;
         }
-        break;
-    case 2:
-        // Button 2: Your custom action
-        logMemoryStats("Button 2 pressed");
-        break;
+    }
+}
+
+/**
+ * EXAMPLE: Long press handler
+ *
+ * Register for BUTTON_LONG_PRESS_START in main.c
+ */
+void radar_btn_long_press_example(void *button_handle, void *usr_data, lv_display_t *disp)
+{
+    int button_index = (int)usr_data;
+
+    if (button_index == 0) {
+        // Button 0 held: Pause and scrub, or back to live
+        radar_ui_post(RADAR_UI_TOGGLE_PAUSE);
+    } else if (button_index == 1) {
+        // Button 1 held: Toggle sweep animation (only in sweep mode)
+        radar_ui_post(RADAR_UI_TOGGLE_ANIMATION);
+    } else if (button_index == 2) {
+        // Button 2 held: Proximity tone on or off
+        radar_ui_post(RADAR_UI_TOGGLE_TONE);
     }
 }
 
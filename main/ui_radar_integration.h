@@ -6,7 +6,7 @@
 #pragma once
 
 #include "lvgl.h"
-#include "humanRadarRD_03D.h"
+#include "radar_frame.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,8 +16,27 @@ extern "C" {
 typedef enum {
     DISPLAY_MODE_LIST,      // List view (ui_radar_display)
     DISPLAY_MODE_SWEEP,     // Radar sweep view (ui_radar_sweep)
+    DISPLAY_MODE_SUMMARY,   // Visitor summary view (ui_radar_summary)
+    DISPLAY_MODE_HISTORY,   // 24 hour history chart (ui_radar_history)
+    DISPLAY_MODE_COUNT,
 } display_mode_t;
 
+// Commands queued by button handlers for the LVGL task
+typedef enum {
+    RADAR_UI_NEXT_MODE,         // Cycle LIST, SWEEP, SUMMARY, HISTORY
+    RADAR_UI_CYCLE_ZOOM,        // Next sweep range, sweep view only
+    RADAR_UI_TOGGLE_DIAG,       // Show/hide the diagnostics overlay and log statistics
+    RADAR_UI_TOGGLE_ANIMATION,  // Stop/start the sweep, sweep view only
+    RADAR_UI_TOGGLE_PAUSE,      // Freeze the list or sweep view and scrub its history, or go live
+    RADAR_UI_TOGGLE_TONE,       // Switch the proximity tone on or off, on any view
+} radar_ui_cmd_t;
+
+/*
+ * While paused, live frames are still recorded but not shown, and the
+ * first three commands scrub instead: NEXT_MODE steps back, CYCLE_ZOOM
+ * steps forward and TOGGLE_DIAG cycles the step between 0.1, 1 and 10 s.
+ */
+
 /**
  * @brief Initialize the radar display system
  *
@@ -30,26 +49,60 @@ typedef enum {
 void radar_display_init(lv_display_t *disp, display_mode_t initial_mode);
 
 /**
- * @brief Switch between display modes
+ * @brief Start the display service
+ *
+ * Subscribes to the radar frame bus; a timer on the LVGL task, woken by
+ * each frame with CONFIG_RADAR_LVGL_ON_DEMAND, takes the frames and
+ * applies them to the active view, so no other task draws targets. Call once after
+ * radar_display_init() and before start_mmwave().
+ */
+void radar_display_service_start(void);
+
+/**
+ * @brief Queue a UI command for the LVGL task
+ *
+ * Never blocks and takes no lock, so it is safe from the button task.
+ * Single producer: call from one task only. The LVGL task is woken to
+ * drain the queue and merges runs of the same command, so two toggles
+ * cancel out and four mode presses rebuild nothing.
+ *
+ * @param cmd Command
+ * @return false if the queue was full and the command was dropped
+ */
+bool radar_ui_post(radar_ui_cmd_t cmd);
+
+/**
+ * @brief Switch to the next display mode
  *
- * Toggles between LIST and SWEEP display modes.
+ * Cycles LIST, SWEEP, SUMMARY, HISTORY.
  * Call this from a button handler or menu action.
  *
  * @param disp LVGL display handle
  */
 void radar_switch_display_mode(lv_display_t *disp);
 
+/**
+ * @brief Show a given display mode
+ *
+ * Deletes the active view and creates the requested one, recreating it
+ * from scratch if it is already active.
+ *
+ * @param disp LVGL display handle
+ * @param mode Display mode to show
+ */
+void radar_set_display_mode(lv_display_t *disp, display_mode_t mode);
+
 /**
  * @brief Update the currently active display
  *
  * Routes the update to the appropriate display function based
  * on the current display mode. Handles display locking internally.
  *
- * @param targets Array of radar_target_t structures
+ * @param frame Radar frame
  * @param targetId Target ID to update (0-2)
  * @param hasMoved Boolean indicating if the target has moved
  */
-void radar_update_current_display(radar_target_t *targets, int targetId, bool hasMoved);
+void radar_update_current_display(const radar_frame_t *frame, int targetId, bool hasMoved);
 
 /**
  * @brief Get the current display mode
@@ -62,7 +115,15 @@ display_mode_t radar_get_display_mode(void);
  * @brief Example button handler with display switching
  *
  * This is a reference implementation showing how to integrate
- * display switching with button handlers.
+ * display switching with button handlers. Presses are queued with
+ * radar_ui_post() and carried out on the LVGL task:
+ * - Button 0: cycle LIST, SWEEP, SUMMARY and HISTORY
+ * - Button 1: cycle the sweep range between 2, 4 and 8 m
+ * - Button 2: show/hide the diagnostics overlay
+ * While paused, buttons 0 and 1 step back and forward and button 2
+ * changes the step. Register buttons 0 and 1 for BUTTON_PRESS_REPEAT_DONE,
+ * so a run of quick taps counts every tap, and button 2 for
+ * BUTTON_PRESS_DOWN.
  *
  * @param button_handle Button handle
  * @param usr_data User data (button index)
@@ -70,6 +131,18 @@ display_mode_t radar_get_display_mode(void);
  */
 void radar_btn_handler_example(void *button_handle, void *usr_data, lv_display_t *disp);
 
+/**
+ * @brief Example long press handler
+ *
+ * - Button 0 held: pause and scrub the list or sweep view, or back to live
+ * - Button 1 held: start/stop the sweep animation
+ *
+ * @param button_handle Button handle
+ * @param usr_data User data (button index)
+ * @param disp LVGL display handle
+ */
+void radar_btn_long_press_example(void *button_handle, void *usr_data, lv_display_t *disp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,200 @@
+/*
+ * ui_radar_summary.c
+ * Visitor summary view: line counts, dwell time and hourly occupancy
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#include "ui_radar_summary.h"
+#include "radar_analytics.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SUMMARY_PERIOD_MS   1000
+#define COUNT_BOXES         3
+#define CHART_X             16
+#define CHART_Y             112
+#define CHART_HEIGHT        96
+#define BAR_STRIDE          12
+#define BAR_WIDTH           10
+
+typedef struct {
+    lv_obj_t *title_label;
+    lv_obj_t *count_boxes[COUNT_BOXES];
+    lv_obj_t *count_labels[COUNT_BOXES];
+    lv_obj_t *dwell_label;
+    lv_obj_t *chart;
+    lv_obj_t *bars[RADAR_ANALYTICS_HOURS];
+    lv_obj_t *chart_label;
+    lv_timer_t *timer;
+} radar_summary_ui_t;
+
+static radar_summary_ui_t ui;
+
+// Preallocated label text, referenced with lv_label_set_text_static()
+static char count_text[COUNT_BOXES][12];
+static char dwell_text[80];
+static char chart_text[48];
+
+/**
+ * @brief Format a duration as "1h 02m", "3m 05s" or "45s"
+ */
+static void fmt_duration(char *buf, size_t len, uint32_t seconds)
+{
+    if (seconds >= 3600) {
+        snprintf(buf, len, "%" PRIu32 "h %02" PRIu32 "m", seconds / 3600, (seconds / 60) % 60);
+    } else if (seconds >= 60) {
+        snprintf(buf, len, "%" PRIu32 "m %02" PRIu32 "s", seconds / 60, seconds % 60);
+    } else {
+        snprintf(buf, len, "%" PRIu32 "s", seconds);
+    }
+}
+
+/**
+ * @brief Refresh every field from the analytics aggregates
+ */
+static void summary_timer_cb(lv_timer_t *timer)
+{
+    radar_analytics_t totals;
+    uint8_t present = 0;
+    char avg[16], max[16], last[16];
+
+    if (ui.chart == NULL) {
+        return;
+    }
+    radar_analytics_get(&totals, &present);
+
+    snprintf(count_text[0], sizeof(count_text[0]), "%" PRIu32, totals.entries);
+    snprintf(count_text[1], sizeof(count_text[1]), "%" PRIu32, totals.exits);
+    snprintf(count_text[2], sizeof(count_text[2]), "%u", present);
+    for (int i = 0; i < COUNT_BOXES; i++) {
+        lv_label_set_text_static(ui.count_labels[i], count_text[i]);
+    }
+
+    fmt_duration(avg, sizeof(avg), totals.visits ? totals.dwell_total_s / totals.visits : 0);
+    fmt_duration(max, sizeof(max), totals.dwell_max_s);
+    fmt_duration(last, sizeof(last), totals.dwell_last_s);
+    snprintf(dwell_text, sizeof(dwell_text), "Visits %" PRIu32 "  Avg %s  Max %s  Last %s",
+             totals.visits, avg, max, last);
+    lv_label_set_text_static(ui.dwell_label, dwell_text);
+
+    // Oldest hour on the left, the current hour on the right
+    for (int i = 0; i < RADAR_ANALYTICS_HOURS; i++) {
+        uint32_t bucket = (totals.hour + 1 + i) % RADAR_ANALYTICS_HOURS;
+        int32_t height = (int32_t)totals.occupied_s[bucket] * CHART_HEIGHT / 3600;
+        lv_obj_set_height(ui.bars[i], height > 0 ? height : 1);
+        lv_obj_set_y(ui.bars[i], CHART_HEIGHT - (height > 0 ? height : 1));
+    }
+    snprintf(chart_text, sizeof(chart_text), "Occupied min/h, 24 h   Now %u min, peak %u",
+             totals.occupied_s[totals.hour % RADAR_ANALYTICS_HOURS] / 60,
+             totals.peak[totals.hour % RADAR_ANALYTICS_HOURS]);
+    lv_label_set_text_static(ui.chart_label, chart_text);
+}
+
+/**
+ * @brief Create the visitor summary view
+ */
+void radar_summary_create_ui(lv_obj_t *parent)
+{
+    static const char *captions[COUNT_BOXES] = {"IN", "OUT", "NOW"};
+    static const uint32_t colors[COUNT_BOXES] = {0x166534, 0x7C2D12, 0x1E3A8A};
+
+    lv_obj_set_style_bg_color(parent, lv_color_hex(0x000000), 0);
+
+    ui.title_label = lv_label_create(parent);
+    lv_label_set_text(ui.title_label, "Visitor Summary");
+    lv_obj_set_style_text_color(ui.title_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(ui.title_label, &lv_font_montserrat_14, 0);
+    lv_obj_align(ui.title_label, LV_ALIGN_TOP_MID, 0, 5);
+
+    // Three count boxes: entries, exits, present
+    for (int i = 0; i < COUNT_BOXES; i++) {
+        ui.count_boxes[i] = lv_obj_create(parent);
+        lv_obj_set_size(ui.count_boxes[i], 98, 52);
+        lv_obj_set_pos(ui.count_boxes[i], 6 + i * 104, 28);
+        lv_obj_set_style_bg_color(ui.count_boxes[i], lv_color_hex(colors[i]), 0);
+        lv_obj_set_style_border_width(ui.count_boxes[i], 2, 0);
+        lv_obj_set_style_border_color(ui.count_boxes[i], lv_color_hex(0xFFFFFF), 0);
+        lv_obj_set_style_radius(ui.count_boxes[i], 5, 0);
+        lv_obj_set_style_pad_all(ui.count_boxes[i], 3, 0);
+        lv_obj_clear_flag(ui.count_boxes[i], LV_OBJ_FLAG_SCROLLABLE);
+
+        lv_obj_t *caption = lv_label_create(ui.count_boxes[i]);
+        lv_label_set_text_static(caption, captions[i]);
+        lv_obj_set_style_text_color(caption, lv_color_hex(0xCCCCCC), 0);
+        lv_obj_set_style_text_font(caption, &lv_font_montserrat_10, 0);
+        lv_obj_align(caption, LV_ALIGN_TOP_MID, 0, 0);
+
+        ui.count_labels[i] = lv_label_create(ui.count_boxes[i]);
+        lv_label_set_text(ui.count_labels[i], "--");
+        lv_obj_set_style_text_color(ui.count_labels[i], lv_color_hex(0xFFFFFF), 0);
+        lv_obj_set_style_text_font(ui.count_labels[i], &lv_font_montserrat_20, 0);
+        lv_obj_align(ui.count_labels[i], LV_ALIGN_BOTTOM_MID, 0, 0);
+    }
+
+    ui.dwell_label = lv_label_create(parent);
+    lv_label_set_text(ui.dwell_label, "Visits --");
+    lv_obj_set_style_text_color(ui.dwell_label, lv_color_hex(0xFFFF00), 0);
+    lv_obj_set_style_text_font(ui.dwell_label, &lv_font_montserrat_12, 0);
+    lv_obj_set_pos(ui.dwell_label, 6, 88);
+
+    // Hourly occupancy bars on a plain container
+    ui.chart = lv_obj_create(parent);
+    lv_obj_set_size(ui.chart, RADAR_ANALYTICS_HOURS * BAR_STRIDE, CHART_HEIGHT);
+    lv_obj_set_pos(ui.chart, CHART_X, CHART_Y);
+    lv_obj_set_style_bg_color(ui.chart, lv_color_hex(0x101010), 0);
+    lv_obj_set_style_border_width(ui.chart, 0, 0);
+    lv_obj_set_style_radius(ui.chart, 0, 0);
+    lv_obj_set_style_pad_all(ui.chart, 0, 0);
+    lv_obj_clear_flag(ui.chart, LV_OBJ_FLAG_SCROLLABLE);
+
+    for (int i = 0; i < RADAR_ANALYTICS_HOURS; i++) {
+        ui.bars[i] = lv_obj_create(ui.chart);
+        lv_obj_set_size(ui.bars[i], BAR_WIDTH, 1);
+        lv_obj_set_pos(ui.bars[i], i * BAR_STRIDE + 1, CHART_HEIGHT - 1);
+        lv_obj_set_style_bg_color(ui.bars[i], lv_color_hex(i == RADAR_ANALYTICS_HOURS - 1 ? 0x00FF00 : 0x00A0A0), 0);
+        lv_obj_set_style_border_width(ui.bars[i], 0, 0);
+        lv_obj_set_style_radius(ui.bars[i], 0, 0);
+        lv_obj_clear_flag(ui.bars[i], LV_OBJ_FLAG_SCROLLABLE);
+    }
+
+    ui.chart_label = lv_label_create(parent);
+    lv_label_set_text(ui.chart_label, "Occupied min/h, 24 h");
+    lv_obj_set_style_text_color(ui.chart_label, lv_color_hex(0xCCCCCC), 0);
+    lv_obj_set_style_text_font(ui.chart_label, &lv_font_montserrat_10, 0);
+    lv_obj_set_pos(ui.chart_label, CHART_X, CHART_Y + CHART_HEIGHT + 6);
+
+    ui.timer = lv_timer_create(summary_timer_cb, SUMMARY_PERIOD_MS, NULL);
+    summary_timer_cb(ui.timer);
+}
+
+/**
+ * @brief Delete the visitor summary view and stop its refresh timer
+ */
+void radar_summary_delete_ui(void)
+{
+    if (ui.timer) {
+        lv_timer_del(ui.timer);
+    }
+    if (ui.title_label) {
+        lv_obj_del(ui.title_label);
+    }
+    for (int i = 0; i < COUNT_BOXES; i++) {
+        if (ui.count_boxes[i]) {
+            lv_obj_del(ui.count_boxes[i]);
+        }
+    }
+    if (ui.dwell_label) {
+        lv_obj_del(ui.dwell_label);
+    }
+    if (ui.chart) {
+        lv_obj_del(ui.chart);
+    }
+    if (ui.chart_label) {
+        lv_obj_del(ui.chart_label);
+    }
+
+    // Forget the deleted objects so a late timer or second delete is harmless
+    memset(&ui, 0, sizeof(ui));
+}
@@ -0,0 +1,40 @@
+/*
+ * ui_radar_summary.h
+ * Visitor summary view: line counts, dwell time and hourly occupancy
+ * Screen: 320x240 pixels
+ * ESP-IDF v5.5.2, LVGL v9.4
+ */
+
+#pragma once
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the visitor summary view
+ *
+ * Shows the radar_analytics aggregates:
+ * - Entries, exits and people present now
+ * - Visits with average, longest and last dwell time
+ * - Occupied minutes for each of the last 24 hours, newest on the right
+ *
+ * The view refreshes itself once a second from radar_analytics_get(),
+ * so it needs no per-frame updates. Call with bsp_display_lock held.
+ *
+ * @param parent Parent LVGL object (typically the screen)
+ */
+void radar_summary_create_ui(lv_obj_t *parent);
+
+/**
+ * @brief Delete the visitor summary view and stop its refresh timer
+ *
+ * Call with bsp_display_lock held.
+ */
+void radar_summary_delete_ui(void);
+
+#ifdef __cplusplus
+}
+#endif
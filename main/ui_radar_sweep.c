@@ -2,14 +2,18 @@
  * ui_radar_sweep.c
  * LVGL radar sweep display for radar_target_t structure
  * Screen: 320x240 pixels
- * Radar: ±60° sweep, 8 meters range
+ * Radar: ±60° sweep, 2, 4 or 8 meters range
  * ESP-IDF v5.5.2, LVGL v9.4
  */
 
 #include "lvgl.h"
 #include "humanRadarRD_03D.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include "ui_radar_sweep.h"
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 #define LV_SYMBOL_USER "\xEF\x81\xB0"  // Custom user symbol
 
@@ -19,51 +23,168 @@
 
 #define RADAR_CENTER_X 160  // Screen center X
 #define RADAR_CENTER_Y 220  // Radar at bottom of screen
-#define RADAR_MAX_RANGE 8000.0f  // 8 meters in mm
 #define RADAR_RADIUS 180  // Display radius in pixels
+#define RADAR_RINGS 4  // Range rings, evenly spaced up to the rim
 #define RADAR_SWEEP_ANGLE 60  // ±60 degrees = 120 total
-#define SWEEP_SPEED 3  // Degrees per timer tick
+#define SWEEP_SPEED 3  // Degrees per timer tick at SWEEP_PERIOD_MS
+#define SWEEP_PERIOD_MS 50  // Sweep timer period at full quality, 20 FPS
+#define TRAIL_LENGTH 48  // Trail segments kept per target (~5 s of walking at 10 Hz)
+#define TRAIL_FADE_LEVELS 4  // Opacity steps along a trail, newest first
+#define TRAIL_FADE_STEP (TRAIL_LENGTH / TRAIL_FADE_LEVELS)  // Segments per opacity step
+#define MOTION_MIN_DT_MS 20  // Shortest frame gap used for a velocity estimate
+#define MOTION_MAX_DT_MS 1000  // Longer gaps restart the velocity estimate
+#define MOTION_LOG_INTERVAL 100  // Measurements between prediction error reports
+#define MOTION_VEL_SCALE 256  // Velocity fraction bits beyond the position's
+
+#ifdef CONFIG_RADAR_MOTION_SNAP
+#define MOTION_DEFAULT_MODE RADAR_MOTION_SNAP
+#else
+#define MOTION_DEFAULT_MODE RADAR_MOTION_INTERPOLATE
+#endif
 
 static const char *TAG = "RadarSweep";
 
+// Everything that depends on the range shown, computed at compile time
+typedef struct {
+    int32_t range_mm;  // Range at the rim
+    int32_t scale_q16;  // Pixels per mm, 16 fractional bits
+    int32_t near_sq;  // Squared distance of the red/orange boundary (30% of range)
+    int32_t mid_sq;  // Squared distance of the orange/green boundary (60% of range)
+    const char *ring_labels[RADAR_RINGS];
+    const char *info;  // Info label text
+} radar_zoom_level_t;
+
+#define ZOOM_LEVEL(m, r1, r2, r3, r4) { \
+    .range_mm = (m) * 1000, \
+    .scale_q16 = (RADAR_RADIUS << 16) / ((m) * 1000), \
+    .near_sq = ((m) * 300) * ((m) * 300), \
+    .mid_sq = ((m) * 600) * ((m) * 600), \
+    .ring_labels = {r1, r2, r3, r4}, \
+    .info = "Radar: " #m "m +-60°", \
+}
+
+static const radar_zoom_level_t zoom_levels[RADAR_ZOOM_COUNT] = {
+    [RADAR_ZOOM_2M] = ZOOM_LEVEL(2, "0.5m", "1m", "1.5m", "2m"),
+    [RADAR_ZOOM_4M] = ZOOM_LEVEL(4, "1m", "2m", "3m", "4m"),
+    [RADAR_ZOOM_8M] = ZOOM_LEVEL(8, "2m", "4m", "6m", "8m"),
+};
+
+// Target ID labels; the second form marks a target beyond the range, held at the rim
+static const char *const target_ids[RADAR_MAX_TARGETS] = {"T0", "T1", "T2"};
+static const char *const target_ids_beyond[RADAR_MAX_TARGETS] = {"T0+", "T1+", "T2+"};
+
+#define TRAIL_CHUNKS (TRAIL_FADE_LEVELS + 1)  // Polylines per trail: the fade levels and the one being trimmed
+#define TRAIL_LINE_WIDTH 2  // Trail line width in pixels
+
+// Breadcrumb trail of one target, kept in chunks of TRAIL_FADE_STEP segments
+// with one polyline each. The newest chunk grows by a point per append and
+// the oldest is trimmed from its front, so older chunks are left untouched.
+typedef struct {
+    lv_obj_t *lines[TRAIL_CHUNKS];  // Polyline of each chunk by age, newest first
+    lv_area_t bbox[TRAIL_CHUNKS];  // Extent of each point array
+    uint8_t newest;  // Point array of the newest chunk
+    uint8_t chunks;  // Chunks holding visible segments
+    uint8_t fill;  // Segments in the newest chunk
+    uint8_t skip;  // Segments trimmed from the front of the oldest chunk
+    uint16_t count;  // Number of visible segments
+    bool has_last;  // The newest chunk holds a starting position
+} radar_trail_t;
+
 // UI elements
 typedef struct {
     lv_obj_t *scr;
     lv_obj_t *radar_base;  // Container for radar graphics
     lv_obj_t *sweep_line;  // The animated sweep line
     lv_obj_t *arc_lines[61];  // Lines forming the outer arc
-    lv_obj_t *range_rings[4][61];  // Range ring lines
+    lv_obj_t *range_rings[RADAR_RINGS][61];  // Range ring lines
     lv_obj_t *angle_lines[3];  // Center angle markers
-    lv_obj_t *range_labels[4];  // Range text labels
+    lv_obj_t *range_labels[RADAR_RINGS];  // Range text labels
     lv_obj_t *shadow_lines[30];  // Shadow trail lines
     lv_obj_t *target_markers[RADAR_MAX_TARGETS];
     lv_obj_t *target_labels[RADAR_MAX_TARGETS];
     lv_obj_t *info_label;
+    radar_trail_t trails[RADAR_MAX_TARGETS];
+    bool beyond[RADAR_MAX_TARGETS];  // Marker is held at the rim
+    uint32_t marker_color[RADAR_MAX_TARGETS];
     int16_t current_angle;  // Current sweep angle (-60 to +60)
     int8_t sweep_direction;  // 1 = right, -1 = left
 } radar_sweep_ui_t;
 
+// Dead-reckoning state of one marker, screen coordinates in 1/256 px.
+// Velocity is finer, 1/65536 px per ms: at the 8 m range 1/256 px per ms
+// is about 170 mm/s, which would round slow walkers to a standstill.
+typedef struct {
+    bool active;  // Marker is visible and driven by the motion timer
+    int32_t meas_x;  // Last measured position
+    int32_t meas_y;
+    int32_t vel_x;  // Velocity in 1/65536 px per ms
+    int32_t vel_y;
+    int32_t off_x;  // Shown minus measured position when the measurement arrived
+    int32_t off_y;
+    uint32_t meas_tick;  // lv_tick_get() of the last measurement
+    int16_t shown_x;  // Marker position currently on screen
+    int16_t shown_y;
+} radar_motion_t;
+
 static radar_sweep_ui_t ui;
 static lv_timer_t *sweep_timer = NULL;
+static lv_timer_t *motion_timer = NULL;
+static radar_motion_t motion[RADAR_MAX_TARGETS];
+static radar_motion_mode_t motion_mode = MOTION_DEFAULT_MODE;
+static radar_motion_stats_t motion_stats;
+static uint64_t motion_error_sum = 0;  // Sum of all errors, tenths of a pixel
+static uint32_t motion_window_max = 0;  // Largest error since the last report
+static radar_zoom_t zoom = RADAR_ZOOM_8M;
+static uint16_t trail_limit = TRAIL_LENGTH;  // Segments shown per trail
+static uint32_t sweep_period_ms = SWEEP_PERIOD_MS;
+static radar_point_t last_point[RADAR_MAX_TARGETS];  // Last measured position, to re-place on zoom
+static char info_text[40];  // Info label with the target count
+static int info_count = -1;  // Target count in info_text, -1 while the label shows the bare range
+
+static uint32_t isqrt32(uint32_t value);
 
 /**
- * @brief Convert polar coordinates to screen cartesian coordinates
+ * @brief Convert sensor x/y (mm) to screen coordinates at the current zoom
+ *
+ * Same mapping as distance/angle polar coordinates, without the trig;
+ * targets beyond the range are pulled in to the rim.
+ *
+ * @return true if the target was beyond the range
  */
-static void polar_to_screen(float distance_mm, float angle_deg, int16_t *x, int16_t *y)
+static bool xy_to_screen(int32_t x_mm, int32_t y_mm, int16_t *x, int16_t *y)
 {
-    // Normalize distance to display radius
-    float normalized_distance = (distance_mm / RADAR_MAX_RANGE) * RADAR_RADIUS;
-    if (normalized_distance > RADAR_RADIUS) {
-        normalized_distance = RADAR_RADIUS;
+    const radar_zoom_level_t *level = &zoom_levels[zoom];
+    uint32_t dist_sq = (uint32_t)(x_mm * x_mm) + (uint32_t)(y_mm * y_mm);
+    bool beyond = dist_sq > (uint32_t)(level->range_mm * level->range_mm);
+
+    if (beyond) {
+        int32_t dist = (int32_t)isqrt32(dist_sq);
+        x_mm = x_mm * level->range_mm / dist;
+        y_mm = y_mm * level->range_mm / dist;
     }
 
-    // Convert angle to radians (0° = up, positive = clockwise)
-    float angle_rad = (angle_deg) * PI / 180.0f;
+    // Y-axis inverted for screen
+    *x = RADAR_CENTER_X + (int16_t)((x_mm * level->scale_q16) >> 16);
+    *y = RADAR_CENTER_Y - (int16_t)((y_mm * level->scale_q16) >> 16);
+    return beyond;
+}
+
+#if CONFIG_RADAR_STATIC_ALLOC
+// Arc, range rings, angle lines, shadow lines and the sweep line
+#define LINE_COUNT (61 + RADAR_RINGS * 61 + 3 + 30 + 1)
 
-    // Calculate screen coordinates (Y-axis inverted for screen)
-    *x = RADAR_CENTER_X + (int16_t)(normalized_distance * sinf(angle_rad));
-    *y = RADAR_CENTER_Y - (int16_t)(normalized_distance * cosf(angle_rad));
+// Point arrays of the lines of the one sweep view, handed out in creation order
+static lv_point_precise_t line_points[LINE_COUNT][2];
+static int line_points_used = 0;
+#else
+/**
+ * @brief Free a line's point array when the line is deleted
+ */
+static void line_delete_cb(lv_event_t *e)
+{
+    lv_free(lv_event_get_user_data(e));
 }
+#endif
 
 /**
  * @brief Create a line object between two points
@@ -71,11 +192,18 @@ static void polar_to_screen(float distance_mm, float angle_deg, int16_t *x, int1
 static lv_obj_t *create_line(lv_obj_t *parent, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
                              lv_color_t color, int16_t width, lv_opa_t opa)
 {
+#if CONFIG_RADAR_STATIC_ALLOC
+    if (line_points_used == LINE_COUNT) {
+        return NULL;
+    }
+    lv_point_precise_t *points = line_points[line_points_used++];
+#else
     // Allocate points on heap so each line has its own persistent array
     lv_point_precise_t *points = lv_malloc(sizeof(lv_point_precise_t) * 2);
     if (points == NULL) {
         return NULL;
     }
+#endif
 
     points[0].x = x1;
     points[0].y = y1;
@@ -84,6 +212,10 @@ static lv_obj_t *create_line(lv_obj_t *parent, int16_t x1, int16_t y1, int16_t x
 
     lv_obj_t *line = lv_line_create(parent);
     lv_line_set_points(line, points, 2);
+#if !CONFIG_RADAR_STATIC_ALLOC
+    // The line only references the points; release them with the line
+    lv_obj_add_event_cb(line, line_delete_cb, LV_EVENT_DELETE, points);
+#endif
     lv_obj_set_style_line_color(line, color, 0);
     lv_obj_set_style_line_width(line, width, 0);
     lv_obj_set_style_line_opa(line, opa, 0);
@@ -110,9 +242,9 @@ static void create_radar_background(lv_obj_t *parent)
         ui.arc_lines[i] = create_line(parent, x1, y1, x2, y2, lv_color_hex(0x00FF00), 2, LV_OPA_COVER);
     }
 
-    // Create range rings (2m, 4m, 6m, 8m)
-    for (int ring = 0; ring < 4; ring++) {
-        float ring_radius = (RADAR_RADIUS * (ring + 1)) / 4.0f;
+    // Create range rings; only their labels depend on the zoom
+    for (int ring = 0; ring < RADAR_RINGS; ring++) {
+        float ring_radius = (RADAR_RADIUS * (ring + 1)) / (float)RADAR_RINGS;
 
         for (int i = 0; i < 61; i++) {
             int angle = -60 + i * 2;
@@ -150,12 +282,12 @@ static void create_radar_background(lv_obj_t *parent)
                                      lv_color_hex(0x004400), 1, LV_OPA_COVER);
 
     // Create range labels
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < RADAR_RINGS; i++) {
         ui.range_labels[i] = lv_label_create(parent);
-        lv_label_set_text_fmt(ui.range_labels[i], "%dm", (i + 1) * 2);
+        lv_label_set_text_static(ui.range_labels[i], zoom_levels[zoom].ring_labels[i]);
         lv_obj_set_style_text_color(ui.range_labels[i], lv_color_hex(0x00AA00), 0);
         lv_obj_set_style_text_font(ui.range_labels[i], &lv_font_montserrat_10, 0);
-        int16_t label_y = RADAR_CENTER_Y - (RADAR_RADIUS * (i + 1)) / 4 - 5;
+        int16_t label_y = RADAR_CENTER_Y - (RADAR_RADIUS * (i + 1)) / RADAR_RINGS - 5;
         lv_obj_set_pos(ui.range_labels[i], RADAR_CENTER_X + 5, label_y);
     }
 
@@ -171,6 +303,262 @@ static void create_radar_background(lv_obj_t *parent)
 static lv_point_precise_t shadow_points[30][2];
 static lv_point_precise_t sweep_points[2];
 
+// Trail point arrays, oldest first, in radar_base coordinates. Point 0 of
+// each array repeats the end of the older chunk so the trail has no gaps.
+static lv_point_precise_t trail_points[RADAR_MAX_TARGETS][TRAIL_CHUNKS][TRAIL_FADE_STEP + 1];
+static lv_style_t trail_styles[RADAR_MAX_TARGETS][TRAIL_FADE_LEVELS];
+static bool trail_styles_ready = false;
+
+/**
+ * @brief Create the hidden polylines for every target trail
+ *
+ * One lv_line per chunk, each with its fade level's shared style; the
+ * chunk being trimmed takes the faintest. Every polyline covers the whole
+ * radar, so adding points never moves or resizes it and the trail code
+ * chooses what to invalidate.
+ */
+static void create_trails(lv_obj_t *parent)
+{
+    static const uint32_t trail_colors[RADAR_MAX_TARGETS] = {
+        0x3B82F6,  // Blue for target 0
+        0x22C55E,  // Green for target 1
+        0xF97316   // Orange for target 2
+    };
+    static const lv_opa_t trail_opa[TRAIL_FADE_LEVELS] = {200, 140, 80, 40};
+
+    if (!trail_styles_ready) {
+        for (int t = 0; t < RADAR_MAX_TARGETS; t++) {
+            for (int level = 0; level < TRAIL_FADE_LEVELS; level++) {
+                lv_style_t *style = &trail_styles[t][level];
+                lv_style_init(style);
+                lv_style_set_line_color(style, lv_color_hex(trail_colors[t]));
+                lv_style_set_line_width(style, TRAIL_LINE_WIDTH);
+                lv_style_set_line_opa(style, trail_opa[level]);
+                lv_style_set_line_rounded(style, true);
+            }
+        }
+        trail_styles_ready = true;
+    }
+
+    for (int t = 0; t < RADAR_MAX_TARGETS; t++) {
+        radar_trail_t *trail = &ui.trails[t];
+        memset(trail, 0, sizeof(*trail));
+
+        for (int age = 0; age < TRAIL_CHUNKS; age++) {
+            lv_obj_t *line = lv_line_create(parent);
+            lv_obj_add_style(line, &trail_styles[t][LV_MIN(age, TRAIL_FADE_LEVELS - 1)], 0);
+            lv_obj_set_pos(line, 0, 0);
+            lv_obj_set_size(line, LV_PCT(100), LV_PCT(100));
+            lv_obj_add_flag(line, LV_OBJ_FLAG_HIDDEN);
+            trail->lines[age] = line;
+        }
+    }
+}
+
+/**
+ * @brief Point array holding the chunk of a given age
+ */
+static int trail_array(const radar_trail_t *trail, int age)
+{
+    return (trail->newest + TRAIL_CHUNKS - age) % TRAIL_CHUNKS;
+}
+
+/**
+ * @brief Visible segments in the chunk of a given age
+ */
+static int trail_segments(const radar_trail_t *trail, int age)
+{
+    if (age >= trail->chunks) {
+        return 0;
+    }
+    return (age == 0 ? trail->fill : TRAIL_FADE_STEP) - (age == trail->chunks - 1 ? trail->skip : 0);
+}
+
+/**
+ * @brief Grow an area to include a point
+ */
+static void area_add_point(lv_area_t *area, const lv_point_precise_t *pt)
+{
+    area->x1 = LV_MIN(area->x1, pt->x);
+    area->y1 = LV_MIN(area->y1, pt->y);
+    area->x2 = LV_MAX(area->x2, pt->x);
+    area->y2 = LV_MAX(area->y2, pt->y);
+}
+
+/**
+ * @brief Invalidate a trail area given in radar_base coordinates
+ *
+ * The area is widened by the line width to cover the rounded ends.
+ */
+static void trail_invalidate(const lv_area_t *area)
+{
+    lv_area_t base;
+    lv_obj_get_coords(ui.radar_base, &base);
+
+    lv_area_t screen = {
+        .x1 = base.x1 + area->x1 - TRAIL_LINE_WIDTH,
+        .y1 = base.y1 + area->y1 - TRAIL_LINE_WIDTH,
+        .x2 = base.x1 + area->x2 + TRAIL_LINE_WIDTH,
+        .y2 = base.y1 + area->y2 + TRAIL_LINE_WIDTH,
+    };
+    lv_inv_area(lv_obj_get_display(ui.radar_base), &screen);
+}
+
+/**
+ * @brief Invalidate the segment between two trail points
+ */
+static void trail_invalidate_segment(const lv_point_precise_t *from, const lv_point_precise_t *to)
+{
+    lv_area_t area = {from->x, from->y, from->x, from->y};
+    area_add_point(&area, to);
+    trail_invalidate(&area);
+}
+
+/**
+ * @brief Point the polyline of one chunk at its visible points, or hide it
+ *
+ * lv_line_set_points() and showing the line would invalidate the whole
+ * radar the polyline covers, so invalidation is held off here and the
+ * caller invalidates only what changed.
+ */
+static void trail_show(int targetId, int age)
+{
+    radar_trail_t *trail = &ui.trails[targetId];
+    lv_obj_t *line = trail->lines[age];
+    int segments = trail_segments(trail, age);
+    lv_display_t *disp = lv_obj_get_display(line);
+    bool enabled = lv_display_is_invalidation_enabled(disp);
+
+    lv_display_enable_invalidation(disp, false);
+    if (segments > 0) {
+        int first = age == trail->chunks - 1 ? trail->skip : 0;
+        lv_line_set_points(line, &trail_points[targetId][trail_array(trail, age)][first], segments + 1);
+        lv_obj_clear_flag(line, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(line, LV_OBJ_FLAG_HIDDEN);
+    }
+    lv_display_enable_invalidation(disp, enabled);
+}
+
+/**
+ * @brief Trim the oldest visible segment from a target trail
+ */
+static void trail_drop(int targetId)
+{
+    radar_trail_t *trail = &ui.trails[targetId];
+    int age = trail->chunks - 1;
+    const lv_point_precise_t *pt = &trail_points[targetId][trail_array(trail, age)][trail->skip];
+
+    trail->skip++;
+    trail->count--;
+    if (trail_segments(trail, age) == 0) {
+        trail->chunks--;
+        trail->skip = 0;
+    }
+    trail_show(targetId, age);
+    trail_invalidate_segment(&pt[0], &pt[1]);
+}
+
+/**
+ * @brief Start a new chunk once the newest one is full
+ *
+ * The full chunk's last point is copied to the start of the next array
+ * as the boundary between them. Every chunk is now one level older, so
+ * each polyline is pointed at its new chunk and the chunks' extents are
+ * repainted; this happens once every TRAIL_FADE_STEP appends. The arrays
+ * hold TRAIL_FADE_STEP more segments than the longest trail, so the one
+ * reused here is never still shown.
+ */
+static void trail_next_chunk(int targetId)
+{
+    radar_trail_t *trail = &ui.trails[targetId];
+    int next = (trail->newest + 1) % TRAIL_CHUNKS;
+    const lv_point_precise_t *boundary = &trail_points[targetId][trail->newest][TRAIL_FADE_STEP];
+
+    trail_points[targetId][next][0] = *boundary;
+    trail->bbox[next] = (lv_area_t){boundary->x, boundary->y, boundary->x, boundary->y};
+    trail->newest = next;
+    trail->fill = 0;
+    trail->chunks++;
+
+    for (int age = 0; age < TRAIL_CHUNKS; age++) {
+        trail_show(targetId, age);
+        if (age > 0 && age < trail->chunks) {
+            trail_invalidate(&trail->bbox[trail_array(trail, age)]);
+        }
+    }
+}
+
+/**
+ * @brief Drop trail segments older than the trail limit
+ */
+static void trail_trim(int targetId)
+{
+    while (ui.trails[targetId].count > trail_limit) {
+        trail_drop(targetId);
+    }
+}
+
+/**
+ * @brief Append the newest position to a target trail
+ *
+ * Only the newest chunk's polyline gains a point, and only the new
+ * segment's bounding box is invalidated, plus the dropped segment's once
+ * the trail is at its limit. The cost per append does not depend on the
+ * trail length, and no memory is allocated.
+ */
+static void trail_append(int targetId, int16_t x, int16_t y)
+{
+    radar_trail_t *trail = &ui.trails[targetId];
+    lv_point_precise_t *chunk = trail_points[targetId][trail->newest];
+
+    if (!trail->has_last) {
+        chunk[0].x = x;
+        chunk[0].y = y;
+        trail->bbox[trail->newest] = (lv_area_t){x, y, x, y};
+        trail->chunks = 1;
+        trail->fill = 0;
+        trail->skip = 0;
+        trail->count = 0;
+        trail->has_last = true;
+        return;
+    }
+    if (x == chunk[trail->fill].x && y == chunk[trail->fill].y) {
+        return;
+    }
+    if (trail->fill == TRAIL_FADE_STEP) {
+        trail_next_chunk(targetId);
+        chunk = trail_points[targetId][trail->newest];
+    }
+
+    lv_point_precise_t *pt = &chunk[++trail->fill];
+    pt->x = x;
+    pt->y = y;
+    area_add_point(&trail->bbox[trail->newest], pt);
+    trail->count++;
+
+    trail_show(targetId, 0);
+    trail_invalidate_segment(pt - 1, pt);
+    trail_trim(targetId);
+}
+
+/**
+ * @brief Hide a target trail once the target is lost
+ */
+static void trail_clear(int targetId)
+{
+    radar_trail_t *trail = &ui.trails[targetId];
+    int chunks = trail->chunks;
+
+    trail->chunks = 0;
+    for (int age = 0; age < chunks; age++) {
+        trail_show(targetId, age);
+        trail_invalidate(&trail->bbox[trail_array(trail, age)]);
+    }
+    trail->count = 0;
+    trail->has_last = false;
+}
+
 /**
  * @brief Update sweep line position
  */
@@ -215,8 +603,8 @@ static void update_sweep_line(int16_t angle)
  */
 static void sweep_timer_cb(lv_timer_t *timer)
 {
-    // Update sweep angle
-    ui.current_angle += SWEEP_SPEED * ui.sweep_direction;
+    // Update sweep angle; a slower timer takes bigger steps to keep the sweep speed
+    ui.current_angle += SWEEP_SPEED * (int16_t)(sweep_period_ms / SWEEP_PERIOD_MS) * ui.sweep_direction;
 
     // Reverse direction at limits
     if (ui.current_angle >= RADAR_SWEEP_ANGLE) {
@@ -231,6 +619,251 @@ static void sweep_timer_cb(lv_timer_t *timer)
     update_sweep_line(ui.current_angle);
 }
 
+/**
+ * @brief Place a target marker and its ID label centred on a screen point
+ */
+static void place_marker(int targetId, int16_t x, int16_t y)
+{
+    if (motion[targetId].shown_x == x && motion[targetId].shown_y == y) {
+        return;
+    }
+    motion[targetId].shown_x = x;
+    motion[targetId].shown_y = y;
+
+    lv_obj_set_pos(ui.target_markers[targetId],
+                  x - 10,  // Center the symbol
+                  y - 10);
+    lv_obj_set_pos(ui.target_labels[targetId],
+                  x - 5,   // Offset slightly
+                  y + 12);
+}
+
+/**
+ * @brief Colour a marker by distance and flag it when held at the rim
+ *
+ * Touches styles only when they change.
+ */
+static void style_marker(int targetId, const radar_point_t *target, bool beyond)
+{
+    const radar_zoom_level_t *level = &zoom_levels[zoom];
+    int32_t dist_sq = target->x * target->x + target->y * target->y;
+    uint32_t color;
+
+    // Closer = more red, compared squared
+    if (dist_sq < level->near_sq) {
+        color = 0xFF0000;  // Red - close
+    } else if (dist_sq < level->mid_sq) {
+        color = 0xFFAA00;  // Orange - medium
+    } else {
+        color = 0x00FF00;  // Green - far
+    }
+    if (color != ui.marker_color[targetId]) {
+        lv_obj_set_style_text_color(ui.target_markers[targetId], lv_color_hex(color), 0);
+        ui.marker_color[targetId] = color;
+    }
+
+    if (beyond != ui.beyond[targetId]) {
+        lv_label_set_text_static(ui.target_labels[targetId],
+                                 beyond ? target_ids_beyond[targetId] : target_ids[targetId]);
+        lv_obj_set_style_opa(ui.target_markers[targetId], beyond ? LV_OPA_50 : LV_OPA_COVER, 0);
+        ui.beyond[targetId] = beyond;
+    }
+}
+
+/**
+ * @brief Integer square root
+ */
+static uint32_t isqrt32(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Signed division rounded to the nearest integer, halves away from zero
+ */
+static inline int32_t div_round(int64_t num, int32_t den)
+{
+    return (int32_t)(num >= 0 ? (num + den / 2) / den : (num - den / 2) / den);
+}
+
+/**
+ * @brief Dead-reckoned marker position at a given tick
+ *
+ * @param with_offset Include the decaying blend offset (what is drawn);
+ *                    without it the result is the pure prediction
+ */
+static void motion_position(const radar_motion_t *m, uint32_t now, bool with_offset,
+                            int32_t *x, int32_t *y)
+{
+    uint32_t dt = now - m->meas_tick;
+    int32_t dt_extrap = (int32_t)LV_MIN(dt, CONFIG_RADAR_MOTION_MAX_EXTRAPOLATE_MS);
+
+    *x = m->meas_x + div_round((int64_t)m->vel_x * dt_extrap, MOTION_VEL_SCALE);
+    *y = m->meas_y + div_round((int64_t)m->vel_y * dt_extrap, MOTION_VEL_SCALE);
+
+    if (with_offset && dt < CONFIG_RADAR_MOTION_BLEND_MS) {
+        int32_t remaining = CONFIG_RADAR_MOTION_BLEND_MS - (int32_t)dt;
+        *x += m->off_x * remaining / CONFIG_RADAR_MOTION_BLEND_MS;
+        *y += m->off_y * remaining / CONFIG_RADAR_MOTION_BLEND_MS;
+    }
+}
+
+/**
+ * @brief Account the distance between a prediction and the measurement
+ */
+static void motion_record_error(int32_t dx, int32_t dy)
+{
+    // 1/256 px to tenths of a pixel
+    int32_t ex = dx * 10 / 256;
+    int32_t ey = dy * 10 / 256;
+    uint32_t error = isqrt32((uint32_t)(ex * ex + ey * ey));
+
+    motion_stats.samples++;
+    motion_stats.last_error_px10 = error;
+    motion_error_sum += error;
+    motion_stats.mean_error_px10 = (uint32_t)(motion_error_sum / motion_stats.samples);
+    if (error > motion_stats.max_error_px10) {
+        motion_stats.max_error_px10 = error;
+    }
+    if (error > motion_window_max) {
+        motion_window_max = error;
+    }
+
+    if (motion_stats.samples % MOTION_LOG_INTERVAL == 0) {
+        ESP_LOGI(TAG, "Prediction error: mean %lu.%lu px, max %lu.%lu px (last %d frames)",
+                 (unsigned long)(motion_stats.mean_error_px10 / 10),
+                 (unsigned long)(motion_stats.mean_error_px10 % 10),
+                 (unsigned long)(motion_window_max / 10),
+                 (unsigned long)(motion_window_max % 10), MOTION_LOG_INTERVAL);
+        motion_window_max = 0;
+    }
+}
+
+/**
+ * @brief Feed a new measured screen position into the dead-reckoning state
+ */
+static void motion_measure(int targetId, int16_t screen_x, int16_t screen_y)
+{
+    radar_motion_t *m = &motion[targetId];
+    uint32_t now = lv_tick_get();
+    int32_t x = (int32_t)screen_x * 256;
+    int32_t y = (int32_t)screen_y * 256;
+
+    if (m->active) {
+        int32_t px, py;
+        uint32_t dt = now - m->meas_tick;
+
+        // How far off was the extrapolation from the previous frame?
+        motion_position(m, now, false, &px, &py);
+        motion_record_error(px - x, py - y);
+
+        // Start blending from wherever the marker is drawn right now
+        motion_position(m, now, true, &px, &py);
+        m->off_x = px - x;
+        m->off_y = py - y;
+
+        if (dt >= MOTION_MIN_DT_MS && dt <= MOTION_MAX_DT_MS) {
+            // Average with the previous estimate to damp sensor jitter; rounding,
+            // not truncation, so small velocities do not decay towards zero
+            int32_t vx = div_round((int64_t)(x - m->meas_x) * MOTION_VEL_SCALE, (int32_t)dt);
+            int32_t vy = div_round((int64_t)(y - m->meas_y) * MOTION_VEL_SCALE, (int32_t)dt);
+            m->vel_x = div_round((int64_t)m->vel_x + vx, 2);
+            m->vel_y = div_round((int64_t)m->vel_y + vy, 2);
+        } else {
+            m->vel_x = 0;
+            m->vel_y = 0;
+        }
+    } else {
+        m->active = true;
+        m->vel_x = 0;
+        m->vel_y = 0;
+        m->off_x = 0;
+        m->off_y = 0;
+    }
+
+    m->meas_x = x;
+    m->meas_y = y;
+    m->meas_tick = now;
+
+    if (motion_timer) {
+        lv_timer_resume(motion_timer);
+    }
+}
+
+/**
+ * @brief Stop extrapolating a target the sensor reports as stationary
+ *
+ * The marker blends from where it is drawn back to the last measurement.
+ */
+static void motion_hold(int targetId)
+{
+    radar_motion_t *m = &motion[targetId];
+
+    if (!m->active || (m->vel_x == 0 && m->vel_y == 0)) {
+        return;
+    }
+
+    uint32_t now = lv_tick_get();
+    int32_t px, py;
+    motion_position(m, now, true, &px, &py);
+    m->off_x = px - m->meas_x;
+    m->off_y = py - m->meas_y;
+    m->vel_x = 0;
+    m->vel_y = 0;
+    m->meas_tick = now;
+
+    if (motion_timer) {
+        lv_timer_resume(motion_timer);
+    }
+}
+
+/**
+ * @brief Timer callback moving interpolated markers at the display rate
+ *
+ * Pauses itself once every marker has settled.
+ */
+static void motion_timer_cb(lv_timer_t *timer)
+{
+    uint32_t now = lv_tick_get();
+    bool moving = false;
+
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        radar_motion_t *m = &motion[i];
+        if (!m->active) {
+            continue;
+        }
+
+        int32_t x, y;
+        motion_position(m, now, true, &x, &y);
+        place_marker(i, (int16_t)((x + 128) / 256), (int16_t)((y + 128) / 256));
+
+        uint32_t dt = now - m->meas_tick;
+        if (dt < CONFIG_RADAR_MOTION_BLEND_MS ||
+            (dt < CONFIG_RADAR_MOTION_MAX_EXTRAPOLATE_MS && (m->vel_x != 0 || m->vel_y != 0))) {
+            moving = true;
+        }
+    }
+
+    if (!moving) {
+        lv_timer_pause(timer);
+    }
+}
+
 /**
  * @brief Create the radar sweep UI
  */
@@ -252,8 +885,14 @@ void radar_sweep_create_ui(lv_obj_t *parent)
     lv_obj_center(ui.radar_base);
 
     // Draw radar background
+#if CONFIG_RADAR_STATIC_ALLOC
+    line_points_used = 0;   // The previous sweep view and its lines are gone
+#endif
     create_radar_background(ui.radar_base);
 
+    // Target trails sit above the background and below the sweep line and markers
+    create_trails(ui.radar_base);
+
     // Create main sweep line
     ui.sweep_line = create_line(ui.radar_base, RADAR_CENTER_X, RADAR_CENTER_Y,
                                 RADAR_CENTER_X, RADAR_CENTER_Y - RADAR_RADIUS,
@@ -266,10 +905,11 @@ void radar_sweep_create_ui(lv_obj_t *parent)
 		lv_obj_set_style_text_color(ui.target_markers[i], lv_color_hex(0xFF0000), 0);
         lv_obj_set_style_text_font(ui.target_markers[i], &lv_font_montserrat_20, 0);
         lv_obj_add_flag(ui.target_markers[i], LV_OBJ_FLAG_HIDDEN);
+        ui.marker_color[i] = 0xFF0000;
 
         // Create small label for target ID
         ui.target_labels[i] = lv_label_create(parent);
-        lv_label_set_text_fmt(ui.target_labels[i], "T%d", i);
+        lv_label_set_text_static(ui.target_labels[i], target_ids[i]);
         lv_obj_set_style_text_color(ui.target_labels[i], lv_color_hex(0xFFFF00), 0);
         lv_obj_set_style_text_font(ui.target_labels[i], &lv_font_montserrat_10, 0);
         lv_obj_add_flag(ui.target_labels[i], LV_OBJ_FLAG_HIDDEN);
@@ -277,73 +917,180 @@ void radar_sweep_create_ui(lv_obj_t *parent)
 
     // Create info label at top
     ui.info_label = lv_label_create(parent);
-    lv_label_set_text(ui.info_label, "Radar: 8m +-60°");
+    lv_label_set_text_static(ui.info_label, zoom_levels[zoom].info);
+    info_count = -1;
     lv_obj_set_style_text_color(ui.info_label, lv_color_hex(0x00FF00), 0);
     lv_obj_set_style_text_font(ui.info_label, &lv_font_montserrat_12, 0);
     lv_obj_align(ui.info_label, LV_ALIGN_TOP_MID, 0, 5);
 
     // Start sweep animation timer
-    sweep_timer = lv_timer_create(sweep_timer_cb, 50, NULL);  // 50ms = 20 FPS
+    sweep_timer = lv_timer_create(sweep_timer_cb, sweep_period_ms, NULL);
+
+    // Marker interpolation timer, resumed whenever a measurement arrives
+    memset(motion, 0, sizeof(motion));
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        motion[i].shown_x = INT16_MIN;
+        motion[i].shown_y = INT16_MIN;
+    }
+    motion_timer = lv_timer_create(motion_timer_cb, CONFIG_RADAR_MOTION_FRAME_MS, NULL);
+    lv_timer_pause(motion_timer);
 }
 
 /**
  * @brief Update target positions on radar
  */
-void radar_sweep_update(radar_target_t *targets, int targetId, bool hasMoved)
+void radar_sweep_update(const radar_frame_t *frame, int targetId, bool hasMoved)
 {
-    if (targets == NULL || targetId < 0 || targetId >= RADAR_MAX_TARGETS) {
+    if (frame == NULL || targetId < 0 || targetId >= RADAR_MAX_TARGETS ||
+        ui.target_markers[targetId] == NULL) {
         return;
     }
 
-    if (targets[targetId].detected && hasMoved) {
-        // Calculate screen position from polar coordinates
+    const radar_point_t *target = &frame->targets[targetId];
+    bool detected = radar_frame_detected(frame, targetId);
+
+    if (detected && hasMoved) {
+        // Calculate screen position straight from x/y
         int16_t screen_x, screen_y;
-        polar_to_screen(targets[targetId].distance,
-                       targets[targetId].angle,
-                       &screen_x, &screen_y);
+        bool beyond = xy_to_screen(target->x, target->y, &screen_x, &screen_y);
+        last_point[targetId] = *target;
 
-        // Show and position target marker
-        lv_obj_clear_flag(ui.target_markers[targetId], LV_OBJ_FLAG_HIDDEN);
-        lv_obj_set_pos(ui.target_markers[targetId],
-                      screen_x - 10,  // Center the symbol
-                      screen_y - 10);
+        // Extend the breadcrumb trail
+        trail_append(targetId, screen_x, screen_y);
 
-        // Show and position target label
+        // Show target marker and label; in interpolate mode the motion
+        // timer moves them, starting from the current on-screen position
+        bool was_hidden = lv_obj_has_flag(ui.target_markers[targetId], LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(ui.target_markers[targetId], LV_OBJ_FLAG_HIDDEN);
         lv_obj_clear_flag(ui.target_labels[targetId], LV_OBJ_FLAG_HIDDEN);
-        lv_obj_set_pos(ui.target_labels[targetId],
-                      screen_x - 5,   // Offset slightly
-                      screen_y + 12);
-
-        // Change color based on distance (closer = more red)
-        float distance_ratio = targets[targetId].distance / RADAR_MAX_RANGE;
-        if (distance_ratio < 0.3f) {
-            lv_obj_set_style_text_color(ui.target_markers[targetId],
-                                       lv_color_hex(0xFF0000), 0);  // Red - close
-        } else if (distance_ratio < 0.6f) {
-            lv_obj_set_style_text_color(ui.target_markers[targetId],
-                                       lv_color_hex(0xFFAA00), 0);  // Orange - medium
+        if (motion_mode == RADAR_MOTION_INTERPOLATE) {
+            motion_measure(targetId, screen_x, screen_y);
+            if (was_hidden) {
+                place_marker(targetId, screen_x, screen_y);
+            }
         } else {
-            lv_obj_set_style_text_color(ui.target_markers[targetId],
-                                       lv_color_hex(0x00FF00), 0);  // Green - far
+            place_marker(targetId, screen_x, screen_y);
         }
 
-        ESP_LOGI(TAG, "Target %d at screen pos (%d, %d), distance %.0fmm, angle %.1f°",
-                targetId, screen_x, screen_y,
-                targets[targetId].distance, targets[targetId].angle);
+        style_marker(targetId, target, beyond);
 
-    } else if (!targets[targetId].detected) {
+        ESP_LOGD(TAG, "Target %d at screen pos (%d, %d), x %d mm, y %d mm",
+                targetId, screen_x, screen_y, target->x, target->y);
+
+    } else if (!detected) {
         // Hide target marker
         lv_obj_add_flag(ui.target_markers[targetId], LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(ui.target_labels[targetId], LV_OBJ_FLAG_HIDDEN);
+        trail_clear(targetId);
+        motion[targetId].active = false;
+    } else if (motion_mode == RADAR_MOTION_INTERPOLATE) {
+        // Detected but not moving
+        motion_hold(targetId);
+    }
+}
+
+/**
+ * @brief Select how markers move between sensor frames
+ */
+void radar_sweep_set_motion_mode(radar_motion_mode_t mode)
+{
+    motion_mode = mode;
+
+    if (mode == RADAR_MOTION_SNAP) {
+        // Markers stay where they are until the next measurement snaps them
+        for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+            motion[i].active = false;
+        }
+        if (motion_timer) {
+            lv_timer_pause(motion_timer);
+        }
+    }
+    ESP_LOGI(TAG, "Motion mode: %s", mode == RADAR_MOTION_SNAP ? "snap" : "interpolate");
+}
+
+/**
+ * @brief Get the current motion mode
+ */
+radar_motion_mode_t radar_sweep_get_motion_mode(void)
+{
+    return motion_mode;
+}
+
+/**
+ * @brief Copy the prediction error statistics
+ */
+void radar_sweep_get_motion_stats(radar_motion_stats_t *stats)
+{
+    if (stats) {
+        *stats = motion_stats;
     }
 }
 
+/**
+ * @brief Select the range shown at the rim
+ */
+void radar_sweep_set_zoom(radar_zoom_t level)
+{
+    if (level >= RADAR_ZOOM_COUNT || level == zoom) {
+        return;
+    }
+    zoom = level;
+    ESP_LOGI(TAG, "Range %ld m", (long)(zoom_levels[zoom].range_mm / 1000));
+
+    if (ui.radar_base == NULL) {
+        return;
+    }
+
+    // Same rings and widgets, new labels and scale
+    for (int i = 0; i < RADAR_RINGS; i++) {
+        lv_label_set_text_static(ui.range_labels[i], zoom_levels[zoom].ring_labels[i]);
+    }
+    lv_label_set_text_static(ui.info_label, zoom_levels[zoom].info);
+    info_count = -1;
+
+    // Trails and velocities are in screen pixels of the old scale; restart them at the new one
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        trail_clear(i);
+        if (lv_obj_has_flag(ui.target_markers[i], LV_OBJ_FLAG_HIDDEN)) {
+            continue;
+        }
+        int16_t screen_x, screen_y;
+        bool beyond = xy_to_screen(last_point[i].x, last_point[i].y, &screen_x, &screen_y);
+        motion[i].active = false;
+        place_marker(i, screen_x, screen_y);
+        trail_append(i, screen_x, screen_y);
+        style_marker(i, &last_point[i], beyond);
+    }
+}
+
+/**
+ * @brief Get the range shown at the rim
+ */
+radar_zoom_t radar_sweep_get_zoom(void)
+{
+    return zoom;
+}
+
+/**
+ * @brief Step to the next range level, wrapping from 8 m back to 2 m
+ */
+void radar_sweep_cycle_zoom(void)
+{
+    radar_sweep_set_zoom((zoom + 1) % RADAR_ZOOM_COUNT);
+}
+
 /**
  * @brief Update info label with target count
  */
 void radar_sweep_update_info(int target_count)
 {
-    lv_label_set_text_fmt(ui.info_label, "Radar: 8m +-60° | Targets: %d", target_count);
+    // Unchanged count, no text rewrite or re-layout
+    if (ui.info_label == NULL || target_count == info_count) {
+        return;
+    }
+    snprintf(info_text, sizeof(info_text), "%s | Targets: %d", zoom_levels[zoom].info, target_count);
+    lv_label_set_text_static(ui.info_label, info_text);
+    info_count = target_count;
 }
 
 /**
@@ -363,7 +1110,38 @@ void radar_sweep_stop_animation(void)
 void radar_sweep_start_animation(void)
 {
     if (!sweep_timer) {
-        sweep_timer = lv_timer_create(sweep_timer_cb, 50, NULL);
+        sweep_timer = lv_timer_create(sweep_timer_cb, sweep_period_ms, NULL);
+    }
+}
+
+/**
+ * @brief Limit the number of segments shown per trail
+ */
+void radar_sweep_set_trail_limit(uint16_t segments)
+{
+    if (segments == 0 || segments > TRAIL_LENGTH) {
+        segments = TRAIL_LENGTH;
+    }
+    trail_limit = segments;
+
+    if (ui.radar_base == NULL) {
+        return;
+    }
+    for (int i = 0; i < RADAR_MAX_TARGETS; i++) {
+        trail_trim(i);
+    }
+}
+
+/**
+ * @brief Set the sweep animation period
+ */
+void radar_sweep_set_sweep_period(uint32_t period_ms)
+{
+    // Whole multiples of the base period, so the sweep still reaches its limits
+    period_ms = LV_MAX(period_ms / SWEEP_PERIOD_MS, 1) * SWEEP_PERIOD_MS;
+    sweep_period_ms = period_ms;
+    if (sweep_timer) {
+        lv_timer_set_period(sweep_timer, period_ms);
     }
 }
 
@@ -374,6 +1152,11 @@ void radar_sweep_delete_ui(void)
 {
     radar_sweep_stop_animation();
 
+    if (motion_timer) {
+        lv_timer_del(motion_timer);
+        motion_timer = NULL;
+    }
+
     if (ui.radar_base) {
         lv_obj_del(ui.radar_base);
         ui.radar_base = NULL;
@@ -394,4 +1177,7 @@ void radar_sweep_delete_ui(void)
         lv_obj_del(ui.info_label);
         ui.info_label = NULL;
     }
+
+    // Children of radar_base were deleted with it
+    memset(&ui, 0, sizeof(ui));
 }
@@ -2,28 +2,51 @@
  * ui_radar_sweep.h
  * LVGL radar sweep display for radar_target_t structure
  * Screen: 320x240 pixels
- * Radar: ±60° sweep, 8 meters range
+ * Radar: ±60° sweep, 2, 4 or 8 meters range
  * ESP-IDF v5.5.2, LVGL v9.4
  */
 
 #pragma once
 
 #include "lvgl.h"
-#include "humanRadarRD_03D.h"
+#include "radar_frame.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// How target markers move between sensor frames
+typedef enum {
+    RADAR_MOTION_SNAP,          // Jump to each measurement
+    RADAR_MOTION_INTERPOLATE,   // Dead-reckon at display rate, blend to measurements
+} radar_motion_mode_t;
+
+// Range shown at the rim of the sweep view
+typedef enum {
+    RADAR_ZOOM_2M,
+    RADAR_ZOOM_4M,
+    RADAR_ZOOM_8M,
+    RADAR_ZOOM_COUNT
+} radar_zoom_t;
+
+// Prediction error of interpolated markers against the next measurement
+typedef struct {
+    uint32_t samples;           // Measurements compared with a prediction
+    uint32_t mean_error_px10;   // Mean error, tenths of a pixel
+    uint32_t max_error_px10;    // Largest error, tenths of a pixel
+    uint32_t last_error_px10;   // Error of the latest measurement
+} radar_motion_stats_t;
+
 /**
  * @brief Create the radar sweep UI
  *
  * Creates a visual radar display with:
  * - Animated sweep line with shadow trail
  * - ±60° sweep arc (120° total)
- * - 8 meter range with range rings at 2m intervals
+ * - 2, 4 or 8 meter range (see radar_sweep_set_zoom()) with four range rings
  * - Angle markers at -60°, 0°, +60°
  * - People markers for detected targets
+ * - Fading breadcrumb trail of recent positions under each marker
  *
  * The sweep line animates automatically at 20 FPS.
  *
@@ -36,22 +59,83 @@ void radar_sweep_create_ui(lv_obj_t *parent);
  *
  * Updates a single target's position on the radar.
  * Targets are shown as person symbols with color indicating distance:
- * - Red: Close range (0-2.4m)
- * - Orange: Medium range (2.4-4.8m)
- * - Green: Far range (4.8-8m)
+ * - Red: Close range (0-30% of the range shown)
+ * - Orange: Medium range (30-60%)
+ * - Green: Far range (60-100%)
+ * Targets beyond the range are held at the rim, dimmed, with a "+" after
+ * their ID.
+ *
+ * Each moving target extends its trail by one segment; the trail is
+ * cleared when the target is lost.
  *
  * This function should be called with bsp_display_lock/unlock:
  *
  * Example:
  *   bsp_display_lock(0);
- *   radar_sweep_update(targets, targetId, hasMoved);
+ *   radar_sweep_update(frame, targetId, hasMoved);
  *   bsp_display_unlock();
  *
- * @param targets Array of radar_target_t structures
+ * Positions are mapped from x/y without trig, and the distance colour
+ * is chosen on squared distance, so no derived values are needed.
+ *
+ * @param frame Radar frame
  * @param targetId Target ID to update (0-2)
  * @param hasMoved Boolean indicating if the target has moved
  */
-void radar_sweep_update(radar_target_t *targets, int targetId, bool hasMoved);
+void radar_sweep_update(const radar_frame_t *frame, int targetId, bool hasMoved);
+
+/**
+ * @brief Select how markers move between sensor frames
+ *
+ * In RADAR_MOTION_INTERPOLATE mode each marker is extrapolated from its
+ * screen velocity by an LVGL timer (CONFIG_RADAR_MOTION_FRAME_MS) and
+ * blends towards each new measurement over CONFIG_RADAR_MOTION_BLEND_MS.
+ * The initial mode comes from menuconfig.
+ *
+ * @param mode Motion mode
+ */
+void radar_sweep_set_motion_mode(radar_motion_mode_t mode);
+
+/**
+ * @brief Get the current motion mode
+ *
+ * @return Current radar_motion_mode_t value
+ */
+radar_motion_mode_t radar_sweep_get_motion_mode(void);
+
+/**
+ * @brief Get the prediction error statistics of interpolated markers
+ *
+ * Each new measurement is compared with where the extrapolation placed
+ * the target; the statistics are also logged every 100 measurements.
+ *
+ * @param stats Filled with the statistics since boot
+ */
+void radar_sweep_get_motion_stats(radar_motion_stats_t *stats);
+
+/**
+ * @brief Select the range shown at the rim
+ *
+ * Ring labels, scale and colour thresholds of every level are computed at
+ * compile time, so switching relabels the rings and re-places the markers
+ * without rebuilding widgets or any trig. Trails restart at the new scale.
+ * The level is kept across view switches. Call with the display locked.
+ *
+ * @param level Range level
+ */
+void radar_sweep_set_zoom(radar_zoom_t level);
+
+/**
+ * @brief Get the range shown at the rim
+ */
+radar_zoom_t radar_sweep_get_zoom(void);
+
+/**
+ * @brief Step to the next range level, wrapping from 8 m back to 2 m
+ *
+ * Call with the display locked.
+ */
+void radar_sweep_cycle_zoom(void);
 
 /**
  * @brief Update info label with target count
@@ -75,6 +159,27 @@ void radar_sweep_stop_animation(void);
  */
 void radar_sweep_start_animation(void);
 
+/**
+ * @brief Limit the number of segments shown per trail
+ *
+ * Older segments are hidden at once. The limit is kept across view
+ * switches. Call with the display locked.
+ *
+ * @param segments Segments per trail, 0 for the full length
+ */
+void radar_sweep_set_trail_limit(uint16_t segments);
+
+/**
+ * @brief Set the sweep animation period
+ *
+ * Rounded down to a multiple of 50 ms; the sweep takes bigger steps at
+ * longer periods, so it moves at the same speed with fewer redraws. The
+ * period is kept across view switches. Call with the display locked.
+ *
+ * @param period_ms Timer period, 50 for full quality
+ */
+void radar_sweep_set_sweep_period(uint32_t period_ms);
+
 /**
  * @brief Clean up and delete all UI elements
  *
@@ -0,0 +1,164 @@
+/*
+ * activity_test.c
+ * Host-side checks for the activity classifier: scripted trajectories
+ * through the device's own radar_activity.c, with the decision tree's
+ * thresholds probed from both sides.
+ *
+ * Build on Linux from the repository root:
+ *   cc -O2 -Imain -o activity_test tools/activity_test.c main/radar_activity.c
+ *
+ * Usage:
+ *   activity_test [-v]
+ *
+ * Each case feeds one target at 10 Hz and checks the label shown at the
+ * end. Prints one line per case with -v, then "ok" or "FAILED"; exits
+ * non-zero on any failure.
+ */
+
+#include "radar_activity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_US        100000      // 10 Hz, as the sensor
+#define WALK_FRAMES     20
+#define STILL_FRAMES    20          // Longer than the tree's 1.2 s stillness split
+
+static radar_frame_t frame;
+static int16_t pos_x;
+static int16_t pos_y;
+static int verbose = 0;
+
+/**
+ * @brief Feed one frame with target 0 at the current position
+ */
+static void feed(int16_t speed)
+{
+    frame.timestamp_us += FRAME_US;
+    frame.seq++;
+    frame.detected = 1;
+    frame.target_count = 1;
+    frame.targets[0].x = pos_x;
+    frame.targets[0].y = pos_y;
+    frame.targets[0].speed = speed;
+    radar_activity_update(&frame);
+}
+
+/**
+ * @brief Lose the target, which resets its track, and place it again
+ */
+static void restart(int16_t x, int16_t y)
+{
+    frame.timestamp_us += FRAME_US;
+    frame.detected = 0;
+    frame.target_count = 0;
+    radar_activity_update(&frame);
+    pos_x = x;
+    pos_y = y;
+}
+
+/**
+ * @brief Walk straight away from the sensor; Doppler speed matches the range change
+ */
+static void walk(int frames, int16_t mm_per_frame)
+{
+    for (int i = 0; i < frames; i++) {
+        pos_y += mm_per_frame;
+        feed((int16_t)(mm_per_frame * 1000000 / FRAME_US));
+    }
+}
+
+/**
+ * @brief Move in place: Doppler speed with no change of floor position
+ */
+static void move_in_place(int frames, int16_t speed)
+{
+    for (int i = 0; i < frames; i++) {
+        feed(speed);
+    }
+}
+
+static int check(const char *name, radar_activity_t want)
+{
+    radar_activity_t got = radar_activity_get(0);
+    int ok = got == want;
+
+    if (verbose || !ok) {
+        printf("%-40s %-9s %s\n", name, radar_activity_name(got)[0] ? radar_activity_name(got) : "-",
+               ok ? "ok" : "FAILED");
+        if (!ok) {
+            printf("%40s wanted %s\n", "", radar_activity_name(want));
+        }
+    }
+    return !ok;
+}
+
+/**
+ * @brief Walk up, move in place at a speed, then keep still
+ *
+ * The in-place speed becomes the drop peak the tree splits sitting and
+ * falls on.
+ */
+static int settle(const char *name, int16_t drop_speed, radar_activity_t want)
+{
+    restart(0, 1000);
+    walk(WALK_FRAMES, 100);
+    move_in_place(4, drop_speed);
+    move_in_place(STILL_FRAMES, 0);
+    return check(name, want);
+}
+
+int main(int argc, char **argv)
+{
+    int failures = 0;
+
+    verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+    // Nothing shown until the track has enough frames
+    restart(0, 1000);
+    feed(0);
+    feed(0);
+    failures += check("new target, no label yet", RADAR_ACTIVITY_NONE);
+
+    restart(0, 1000);
+    walk(WALK_FRAMES, 100);
+    failures += check("walking 1 m/s", RADAR_ACTIVITY_WALKING);
+
+    // Moving, mean Doppler speed either side of 250 mm/s
+    restart(0, 1000);
+    walk(WALK_FRAMES, 25);
+    failures += check("shuffling 250 mm/s", RADAR_ACTIVITY_STANDING);
+    restart(0, 1000);
+    walk(WALK_FRAMES, 27);
+    failures += check("walking 270 mm/s", RADAR_ACTIVITY_WALKING);
+
+    // Moving at speed but turning more than 160/1024 of a turn a step
+    restart(0, 2000);
+    for (int i = 0; i < WALK_FRAMES; i++) {
+        pos_x += i % 2 ? 100 : -100;
+        pos_y += 100;
+        feed(1000);
+    }
+    failures += check("zigzag, turning 90 deg a step", RADAR_ACTIVITY_STANDING);
+
+    restart(0, 1000);
+    move_in_place(STILL_FRAMES, 0);
+    failures += check("still from the start", RADAR_ACTIVITY_STANDING);
+
+    // Drop peak either side of 400 and 1500 mm/s
+    failures += settle("stop, 400 mm/s in place, still", 400, RADAR_ACTIVITY_STANDING);
+    failures += settle("stop, 410 mm/s in place, still", 410, RADAR_ACTIVITY_SITTING);
+    failures += settle("stop, 1500 mm/s in place, still", 1500, RADAR_ACTIVITY_SITTING);
+    failures += settle("stop, 1510 mm/s in place, still", 1510, RADAR_ACTIVITY_FALL);
+    failures += settle("stop, 3000 mm/s in place, still", 3000, RADAR_ACTIVITY_FALL);
+
+    // Walking away again ends the fall
+    walk(WALK_FRAMES, 100);
+    failures += check("fall, then walking again", RADAR_ACTIVITY_WALKING);
+
+    restart(0, 1000);
+    failures += check("lost target", RADAR_ACTIVITY_NONE);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+golden_pull.py
+Writes the render benchmark's logged golden images into spiffs/golden/.
+
+With "Record golden images" on, main/radar_bench.c logs each checkpoint
+thumbnail as hex lines:
+  GOLDEN <name> <offset> <hex>
+  GOLDEN <name> end <length>
+An image is written only if every byte up to the end line arrived, so a
+log cut short or with dropped lines leaves the existing file alone.
+
+Usage:
+  idf.py monitor | tee bench.log
+  tools/golden_pull.py bench.log [--out spiffs/golden]
+
+Then commit the files and rebuild with recording off; they are flashed
+with the storage image. Uses only the Python standard library.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+LINE = re.compile(r"GOLDEN (\S+) (\d+|end) ([0-9a-f]+)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("log", help="monitor log, - for stdin")
+    parser.add_argument("--out", default=os.path.join(os.path.dirname(__file__), "..", "spiffs", "golden"))
+    args = parser.parse_args()
+
+    images = {}
+    ends = {}
+    with (sys.stdin if args.log == "-" else open(args.log, errors="replace")) as f:
+        for line in f:
+            m = LINE.search(line)
+            if not m:
+                continue
+            name, where, data = m.groups()
+            if where == "end":
+                ends[name] = int(data)
+            else:
+                # A later recording in the same log replaces an earlier one
+                if int(where) == 0:
+                    images[name] = {}
+                images.setdefault(name, {})[int(where)] = bytes.fromhex(data)
+
+    os.makedirs(args.out, exist_ok=True)
+    failed = 0
+    for name, length in sorted(ends.items()):
+        chunks = images.get(name, {})
+        data = bytearray()
+        for offset in sorted(chunks):
+            if offset != len(data):
+                break
+            data += chunks[offset]
+        if len(data) != length:
+            print("%s: %d of %d bytes logged, skipped" % (name, len(data), length))
+            failed += 1
+            continue
+        path = os.path.join(args.out, name + ".bin")
+        with open(path, "wb") as out:
+            out.write(data)
+        print("%s: %d bytes" % (path, length))
+    if not ends:
+        print("no golden images in the log")
+        return 1
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,481 @@
+/*
+ * mirror_test.c
+ * Host-side checks for the display mirror: a round trip of the device's
+ * run-length coder, a synthetic mirror server and a measuring client.
+ *
+ * Build on Linux from the repository root:
+ *   cc -O2 -Imain -o mirror_test tools/mirror_test.c main/radar_mirror.c -lm
+ *
+ * Usage:
+ *   mirror_test selftest [--frames 50]
+ *   mirror_test serve [--port 5006] [--fps 20] [--lines 24]
+ *   mirror_test HOST[:PORT] [--frames 100] [--ppm out.ppm]
+ *
+ *   selftest   Encode and decode synthetic radar-like frames, native and
+ *              byte swapped, plus pure noise as the worst case, and report
+ *              the compression ratio. Exits non-zero on any mismatch.
+ *   serve      Stream synthetic frames in stripes of --lines rows with the
+ *              device's encoder, so tools/mirror_view.py can be tried
+ *              without a device.
+ *   HOST       Connect to a device or a serve instance, decode every rect
+ *              and report frames per second, bandwidth, compression and
+ *              frames dropped by the device. --ppm saves the last picture.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "radar_mirror.h"
+#include <arpa/inet.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef PI
+#define PI (3.14159265358979)
+#endif
+
+#define WIDTH       320
+#define HEIGHT      240
+#define OUT_SIZE    (1 << 18)   // Holds the worst case of a full frame
+
+static uint8_t out[OUT_SIZE];
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0) {
+        struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: mirror_test selftest [--frames N]\n"
+                    "       mirror_test serve [--port P] [--fps F] [--lines L]\n"
+                    "       mirror_test HOST[:PORT] [--frames N] [--ppm FILE]\n");
+    return 2;
+}
+
+static uint16_t rgb565(int r, int g, int b)
+{
+    return (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+}
+
+/**
+ * @brief Draw a frame that looks like the sweep view
+ *
+ * Black field, range rings, a fading sweep wedge, three moving targets
+ * and a status bar with text-like blocks; the wedge's gradient is the
+ * hard part for a run-length coder.
+ */
+static void render(uint16_t *fb, int t)
+{
+    const int cx = WIDTH / 2;
+    const int cy = HEIGHT - 10;
+    double sweep = fmod(t * 0.08, PI);
+    int tx[3], ty[3];
+
+    for (int i = 0; i < 3; i++) {
+        tx[i] = cx + (int)(90 * sin(t * 0.03 + i * 2.1));
+        ty[i] = cy - 60 - (int)(50 * (1 + cos(t * 0.02 + i)));
+    }
+
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint16_t px = 0;
+            double dx = x - cx;
+            double dy = cy - y;
+            double r = sqrt(dx * dx + dy * dy);
+
+            if (y < 20) {
+                // Status bar: 8 px glyph cells, some lit, like a line of text
+                int glyph = (x / 8 * 7 + y / 3 * 13 + t / 10) % 11;
+                px = (y > 5 && y < 15 && x % 8 < 6 && glyph < 4) ? 0xFFFF : rgb565(32, 32, 32);
+            } else if (dy >= 0 && r < 220) {
+                double a = atan2(dy, dx);
+                double behind = sweep - a;
+                if (behind >= 0 && behind < 0.5) {
+                    px = rgb565(0, (int)(200 * (1 - behind / 0.5)), 0);
+                }
+                if (fabs(r - 70) < 0.8 || fabs(r - 140) < 0.8 || fabs(r - 210) < 0.8) {
+                    px = rgb565(0, 120, 0);
+                }
+            }
+            for (int i = 0; i < 3; i++) {
+                int ddx = x - tx[i];
+                int ddy = y - ty[i];
+                if (ddx * ddx + ddy * ddy <= 25) {
+                    px = rgb565(255, 40, 40);
+                }
+            }
+            fb[y * WIDTH + x] = px;
+        }
+    }
+}
+
+static int round_trip(const uint16_t *fb, int stride, int w, int h, int swapped, size_t *coded)
+{
+    static uint16_t in[WIDTH * HEIGHT];
+    static uint16_t back[WIDTH * HEIGHT];
+    const uint16_t *src = fb;
+
+    if (swapped) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                uint16_t p = fb[y * stride + x];
+                in[y * stride + x] = (uint16_t)(p << 8 | p >> 8);
+            }
+        }
+        src = in;
+    }
+    size_t len = radar_mirror_encode(out, OUT_SIZE - 1, 0, OUT_SIZE, src, w, h, stride, swapped);
+    if (len == 0 || !radar_mirror_decode(out, len, back, (size_t)w * h)) {
+        return 0;
+    }
+    for (int y = 0; y < h; y++) {
+        if (memcmp(back + y * w, fb + y * stride, w * sizeof(uint16_t)) != 0) {
+            return 0;
+        }
+    }
+    // Too little room must fail cleanly rather than write past it
+    if (radar_mirror_encode(out, OUT_SIZE - 1, 0, len - 1, src, w, h, stride, swapped) != 0) {
+        return 0;
+    }
+    *coded += len;
+    return 1;
+}
+
+static int run_selftest(int argc, char **argv)
+{
+    static uint16_t fb[WIDTH * HEIGHT];
+    int frames = 50;
+    size_t coded = 0;
+    int failures = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        }
+    }
+
+    for (int t = 0; t < frames; t++) {
+        render(fb, t);
+        failures += !round_trip(fb, WIDTH, WIDTH, HEIGHT, 0, &coded);
+        failures += !round_trip(fb, WIDTH, WIDTH, HEIGHT, 1, &coded);
+        // A stripe narrower than its buffer, as in a partial refresh
+        failures += !round_trip(fb + 40 * WIDTH + 17, WIDTH, 101, 24, 0, &(size_t){0});
+    }
+    double raw = (double)frames * 2 * WIDTH * HEIGHT * 2;
+    printf("synthetic: %d frames, %.1f KB per frame coded, %.1f:1\n", frames,
+           coded / 2.0 / frames / 1024, raw / coded);
+
+    size_t noise = 0;
+    srand(1);
+    for (int i = 0; i < WIDTH * HEIGHT; i++) {
+        fb[i] = (uint16_t)rand();
+    }
+    failures += !round_trip(fb, WIDTH, WIDTH, HEIGHT, 0, &noise);
+    printf("noise: %zu bytes for %d raw, %.3f:1\n", noise, WIDTH * HEIGHT * 2,
+           (double)WIDTH * HEIGHT * 2 / noise);
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = send(sock, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return 0;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+static void serve_client(int sock, int fps, int lines)
+{
+    static uint16_t fb[WIDTH * HEIGHT];
+    uint8_t hello[RADAR_MIRROR_HELLO_LEN] = {'R', 'D', 'M', 'R', RADAR_MIRROR_VERSION, 0};
+    uint8_t head[RADAR_MIRROR_RECT_LEN];
+    uint8_t frame[RADAR_MIRROR_FRAME_LEN];
+    int64_t next = now_us();
+
+    put_u16(hello + 6, WIDTH);
+    put_u16(hello + 8, HEIGHT);
+    if (!send_all(sock, hello, sizeof(hello))) {
+        return;
+    }
+    for (uint32_t t = 1;; t++) {
+        render(fb, t);
+        for (int y = 0; y < HEIGHT; y += lines) {
+            int h = y + lines > HEIGHT ? HEIGHT - y : lines;
+            size_t len = radar_mirror_encode(out, OUT_SIZE - 1, 0, OUT_SIZE, fb + y * WIDTH,
+                                             WIDTH, h, WIDTH, false);
+            head[0] = RADAR_MIRROR_MSG_RECT;
+            put_u16(head + 1, 0);
+            put_u16(head + 3, y);
+            put_u16(head + 5, WIDTH);
+            put_u16(head + 7, h);
+            put_u32(head + 9, len);
+            if (!send_all(sock, head, sizeof(head)) || !send_all(sock, out, len)) {
+                return;
+            }
+        }
+        frame[0] = RADAR_MIRROR_MSG_FRAME;
+        put_u32(frame + 1, t);
+        put_u32(frame + 5, 0);
+        if (!send_all(sock, frame, sizeof(frame))) {
+            return;
+        }
+        next += 1000000 / fps;
+        sleep_us(next - now_us());
+    }
+}
+
+static int run_serve(int argc, char **argv)
+{
+    int port = RADAR_MIRROR_DEFAULT_PORT;
+    int fps = 20;
+    int lines = 24;
+    int one = 1;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--port") == 0) {
+            port = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--fps") == 0) {
+            fps = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--lines") == 0) {
+            lines = atoi(argv[i + 1]);
+        } else {
+            return usage();
+        }
+    }
+    if (fps < 1 || lines < 1) {
+        return usage();
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port),
+                               .sin_addr.s_addr = htonl(INADDR_ANY)};
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0) {
+        perror("listen");
+        return 1;
+    }
+    fprintf(stderr, "serving %dx%d at %d fps on port %d\n", WIDTH, HEIGHT, fps, port);
+    while (1) {
+        int sock = accept(listener, NULL, NULL);
+        if (sock < 0) {
+            continue;
+        }
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fprintf(stderr, "viewer connected\n");
+        serve_client(sock, fps, lines);
+        close(sock);
+        fprintf(stderr, "viewer left\n");
+    }
+}
+
+static int recv_all(int sock, void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    while (len) {
+        ssize_t n = recv(sock, p, len, 0);
+        if (n <= 0) {
+            return 0;
+        }
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+static int save_ppm(const char *path, const uint16_t *fb, int w, int h)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (int i = 0; i < w * h; i++) {
+        uint16_t p = fb[i];
+        uint8_t rgb[3] = {(p >> 11) << 3, ((p >> 5) & 0x3F) << 2, (p & 0x1F) << 3};
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    return 1;
+}
+
+static int run_client(int argc, char **argv)
+{
+    char host[256];
+    const char *port = "5006";
+    const char *ppm = NULL;
+    int frames = 100;
+
+    snprintf(host, sizeof(host), "%s", argv[1]);
+    char *colon = strchr(host, ':');
+    if (colon) {
+        *colon = '\0';
+        port = argv[1] + (colon - host) + 1;
+    }
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--ppm") == 0) {
+            ppm = argv[i + 1];
+        } else {
+            return usage();
+        }
+    }
+
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *res;
+    if (getaddrinfo(host, port, &hints, &res) != 0) {
+        fprintf(stderr, "cannot resolve %s\n", host);
+        return 1;
+    }
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(sock, res->ai_addr, res->ai_addrlen) != 0) {
+        perror("connect");
+        return 1;
+    }
+    freeaddrinfo(res);
+
+    uint8_t hello[RADAR_MIRROR_HELLO_LEN];
+    if (!recv_all(sock, hello, sizeof(hello)) || memcmp(hello, "RDMR", 4) != 0 ||
+        hello[4] != RADAR_MIRROR_VERSION) {
+        fprintf(stderr, "not a display mirror\n");
+        return 1;
+    }
+    int w = get_u16(hello + 6);
+    int h = get_u16(hello + 8);
+    uint16_t *fb = calloc((size_t)w * h, sizeof(uint16_t));
+    uint16_t *rect = malloc((size_t)w * h * sizeof(uint16_t));
+    uint8_t *runs = NULL;
+    size_t runs_size = 0;
+    uint64_t bytes = 0, pixels = 0;
+    uint32_t rects = 0, dropped = 0;
+    int seen = 0;
+    int64_t start = 0;
+
+    printf("%dx%d display\n", w, h);
+    while (seen < frames) {
+        uint8_t type;
+        if (!recv_all(sock, &type, 1)) {
+            fprintf(stderr, "connection closed\n");
+            break;
+        }
+        if (type == RADAR_MIRROR_MSG_RECT) {
+            uint8_t m[RADAR_MIRROR_RECT_LEN - 1];
+            if (!recv_all(sock, m, sizeof(m))) {
+                break;
+            }
+            int rx = get_u16(m), ry = get_u16(m + 2), rw = get_u16(m + 4), rh = get_u16(m + 6);
+            uint32_t len = get_u32(m + 8);
+            if (len > runs_size) {
+                runs_size = len;
+                runs = realloc(runs, runs_size);
+            }
+            if (!recv_all(sock, runs, len)) {
+                break;
+            }
+            if (rx + rw > w || ry + rh > h || !radar_mirror_decode(runs, len, rect, (size_t)rw * rh)) {
+                fprintf(stderr, "bad rect %d,%d %dx%d\n", rx, ry, rw, rh);
+                return 1;
+            }
+            for (int y = 0; y < rh; y++) {
+                memcpy(fb + (ry + y) * w + rx, rect + y * rw, rw * sizeof(uint16_t));
+            }
+            if (start) {
+                bytes += RADAR_MIRROR_RECT_LEN + len;
+                pixels += (uint64_t)rw * rh;
+                rects++;
+            }
+        } else if (type == RADAR_MIRROR_MSG_FRAME) {
+            uint8_t m[RADAR_MIRROR_FRAME_LEN - 1];
+            if (!recv_all(sock, m, sizeof(m))) {
+                break;
+            }
+            dropped = get_u32(m + 4);
+            // Time from the first complete frame, past the connect redraw
+            if (!start) {
+                start = now_us();
+            } else {
+                seen++;
+                bytes += RADAR_MIRROR_FRAME_LEN;
+            }
+        } else {
+            fprintf(stderr, "unknown message %u\n", type);
+            return 1;
+        }
+    }
+
+    double secs = start ? (now_us() - start) / 1e6 : 0;
+    if (secs > 0 && bytes) {
+        printf("%d frames in %.1f s: %.1f fps, %.1f KB/s, %u rects, %.1f:1 compression, %u dropped\n",
+               seen, secs, seen / secs, bytes / secs / 1024, rects, pixels * 2.0 / bytes, dropped);
+    }
+    if (ppm && save_ppm(ppm, fb, w, h)) {
+        printf("saved %s\n", ppm);
+    }
+    close(sock);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "selftest") == 0) {
+        return run_selftest(argc, argv);
+    }
+    if (strcmp(argv[1], "serve") == 0) {
+        return run_serve(argc, argv);
+    }
+    if (argv[1][0] == '-') {
+        return usage();
+    }
+    return run_client(argc, argv);
+}
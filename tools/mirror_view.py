@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+mirror_view.py
+Shows the device's display mirror in a desktop window.
+
+The device sends its flushed stripes run-length coded; see
+main/radar_mirror.h for the stream. The window is redrawn at each
+frame message, so it shows whole refreshes only. The title carries the
+frame rate, bandwidth and the frames the device dropped because the
+network could not keep up.
+
+Usage:
+  tools/mirror_view.py <device-ip>[:5006] [--scale 2]
+  tools/mirror_view.py <device-ip>[:5006] --snapshot out.ppm [--frames 10]
+
+--snapshot runs without a window: it saves the picture after the given
+number of frames and exits. tools/mirror_test.c serve stands in for a
+device. Uses only the Python standard library; the window needs tkinter.
+"""
+
+import argparse
+import socket
+import struct
+import threading
+import time
+
+VERSION = 1
+MSG_RECT = 1
+MSG_FRAME = 2
+HELLO = struct.Struct("<4sBBHH")
+RECT = struct.Struct("<HHHHI")
+FRAME = struct.Struct("<II")
+
+
+def recv_exact(sock, n):
+    buf = bytearray()
+    while len(buf) < n:
+        chunk = sock.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        buf += chunk
+    return bytes(buf)
+
+
+def rgb888(px):
+    return bytes((((px >> 11) & 0x1F) << 3, ((px >> 5) & 0x3F) << 2, (px & 0x1F) << 3))
+
+
+class Mirror:
+    """Decodes the stream into an RGB888 picture."""
+
+    def __init__(self, sock):
+        self.sock = sock
+        magic, version, fmt, self.width, self.height = HELLO.unpack(recv_exact(sock, HELLO.size))
+        if magic != b"RDMR" or version != VERSION or fmt != 0:
+            raise ValueError("not a display mirror")
+        self.rgb = bytearray(self.width * self.height * 3)
+        self.frame = 0
+        self.dropped = 0
+        self.bytes = 0
+        self.colours = {}
+
+    def colour(self, px):
+        c = self.colours.get(px)
+        if c is None:
+            c = self.colours[px] = rgb888(px)
+        return c
+
+    def decode_rect(self, x, y, w, h, runs):
+        row = bytearray()
+        rows = []
+        i = 0
+        while i < len(runs):
+            token = runs[i]
+            n = (token & 0x7F) + 1
+            if token & 0x80:
+                row += self.colour(runs[i + 1] | runs[i + 2] << 8) * n
+                i += 3
+            else:
+                for k in range(n):
+                    row += self.colour(runs[i + 1 + 2 * k] | runs[i + 2 + 2 * k] << 8)
+                i += 1 + 2 * n
+        if len(row) != w * h * 3:
+            raise ValueError("rect %d,%d %dx%d does not decode" % (x, y, w, h))
+        for r in range(h):
+            start = ((y + r) * self.width + x) * 3
+            self.rgb[start:start + w * 3] = row[r * w * 3:(r + 1) * w * 3]
+
+    def next_frame(self):
+        """Apply messages up to and including the next frame message."""
+        while True:
+            kind = recv_exact(self.sock, 1)[0]
+            if kind == MSG_RECT:
+                x, y, w, h, length = RECT.unpack(recv_exact(self.sock, RECT.size))
+                if x + w > self.width or y + h > self.height:
+                    raise ValueError("rect outside the display")
+                self.decode_rect(x, y, w, h, recv_exact(self.sock, length))
+                self.bytes += 1 + RECT.size + length
+            elif kind == MSG_FRAME:
+                self.frame, self.dropped = FRAME.unpack(recv_exact(self.sock, FRAME.size))
+                self.bytes += 1 + FRAME.size
+                return
+            else:
+                raise ValueError("unknown message %d" % kind)
+
+    def ppm(self):
+        return b"P6\n%d %d\n255\n" % (self.width, self.height) + bytes(self.rgb)
+
+
+def connect(target):
+    host, _, port = target.partition(":")
+    sock = socket.create_connection((host, int(port or 5006)), timeout=10)
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    return sock
+
+
+def snapshot(mirror, path, frames):
+    for _ in range(frames):
+        mirror.next_frame()
+    with open(path, "wb") as f:
+        f.write(mirror.ppm())
+    print("frame %d saved to %s, %d dropped" % (mirror.frame, path, mirror.dropped))
+
+
+def show(mirror, scale):
+    import tkinter
+
+    root = tkinter.Tk()
+    label = tkinter.Label(root)
+    label.pack()
+    latest = {"ppm": None, "error": None}
+    lock = threading.Lock()
+
+    def reader():
+        try:
+            while True:
+                mirror.next_frame()
+                with lock:
+                    latest["ppm"] = mirror.ppm()
+        except (OSError, ValueError) as e:
+            latest["error"] = e
+
+    threading.Thread(target=reader, daemon=True).start()
+    stats = {"t": time.monotonic(), "frame": 0, "bytes": 0}
+
+    def refresh():
+        with lock:
+            ppm, latest["ppm"] = latest["ppm"], None
+        if ppm is not None:
+            image = tkinter.PhotoImage(data=ppm, format="PPM")
+            if scale > 1:
+                image = image.zoom(scale, scale)
+            label.configure(image=image)
+            label.image = image
+        now = time.monotonic()
+        if now - stats["t"] >= 1:
+            fps = (mirror.frame - stats["frame"]) / (now - stats["t"])
+            kbps = (mirror.bytes - stats["bytes"]) / (now - stats["t"]) / 1024
+            root.title("Radar mirror  %.1f fps  %.1f KB/s  %d dropped" % (fps, kbps, mirror.dropped))
+            stats.update(t=now, frame=mirror.frame, bytes=mirror.bytes)
+        if latest["error"] is not None:
+            root.title("Radar mirror  disconnected: %s" % latest["error"])
+            return
+        root.after(15, refresh)
+
+    root.title("Radar mirror")
+    refresh()
+    root.mainloop()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("target", help="device address, optionally with :port")
+    parser.add_argument("--scale", type=int, default=2)
+    parser.add_argument("--snapshot", metavar="PPM")
+    parser.add_argument("--frames", type=int, default=10)
+    args = parser.parse_args()
+
+    sock = connect(args.target)
+    mirror = Mirror(sock)
+    sock.settimeout(None)
+    print("%dx%d display" % (mirror.width, mirror.height))
+    if args.snapshot:
+        snapshot(mirror, args.snapshot, args.frames)
+    else:
+        show(mirror, args.scale)
+
+
+if __name__ == "__main__":
+    main()
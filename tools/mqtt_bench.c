@@ -0,0 +1,688 @@
+/*
+ * mqtt_bench.c
+ * Host-side MQTT stand-in and benchmark for the presence publisher: a
+ * minimal broker, and emulated sensor frames run through the device's own
+ * presence detector and published to a broker.
+ *
+ * Build on Linux from the repository root:
+ *   cc -O2 -Imain -o mqtt_bench tools/mqtt_bench.c main/radar_presence.c main/radar_emulator.c -lm -lpthread
+ *
+ * Usage:
+ *   mqtt_bench broker [--port 1883]
+ *   mqtt_bench bench [--host 127.0.0.1:1883] [--frames 36000] [--hz 0]
+ *                    [--walkers 3] [--noise 40] [--dropout 5]
+ *                    [--interval 500] [--hold 3000] [--move 150]
+ *
+ *   broker     Enough of MQTT 3.1.1 for the device and this bench:
+ *              CONNECT, SUBSCRIBE with + and # wildcards, QoS 0 PUBLISH
+ *              forwarding, PINGREQ and DISCONNECT. Retained messages are
+ *              forwarded but not stored. mosquitto works just as well.
+ *   bench      Frames from the sensor emulator, 100 ms of sensor time
+ *              each, go through radar_presence and are published as the
+ *              device publishes them, under bench/<pid>. A second
+ *              connection subscribes to them and times each message from
+ *              its frame to its arrival. --hz paces the frames in real
+ *              time; 0 sends them as fast as possible. Reports the
+ *              messages against one per topic per frame, serialisation
+ *              cost, throughput and latency percentiles, then clears the
+ *              retained topics.
+ *
+ * Example:
+ *   ./mqtt_bench broker &
+ *   ./mqtt_bench bench --frames 36000
+ *   mosquitto_sub -v -t 'humanradar/#'     # watch a device
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "radar_emulator.h"
+#include "radar_presence.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MQTT_CONNECT        0x10
+#define MQTT_CONNACK        0x20
+#define MQTT_PUBLISH        0x30
+#define MQTT_SUBSCRIBE      0x82
+#define MQTT_SUBACK         0x90
+#define MQTT_PINGREQ        0xC0
+#define MQTT_PINGRESP       0xD0
+#define MQTT_DISCONNECT     0xE0
+
+#define PACKET_MAX          4096
+#define BROKER_CLIENTS      32
+#define CLIENT_FILTERS      8
+#define FRAME_MS            100     // The sensor's frame period
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0) {
+        struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: mqtt_bench broker [--port 1883]\n"
+                    "       mqtt_bench bench [--host 127.0.0.1:1883] [options]\n");
+    return 2;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Put the fixed header; returns its length
+ */
+static size_t put_header(uint8_t *p, uint8_t type, size_t remaining)
+{
+    size_t n = 0;
+
+    p[n++] = type;
+    do {
+        uint8_t b = remaining & 0x7F;
+        remaining >>= 7;
+        p[n++] = b | (remaining ? 0x80 : 0);
+    } while (remaining);
+    return n;
+}
+
+static size_t put_string(uint8_t *p, const char *s, size_t len)
+{
+    p[0] = len >> 8;
+    p[1] = len & 0xFF;
+    memcpy(p + 2, s, len);
+    return 2 + len;
+}
+
+/**
+ * @brief Length of the complete packet at the start of buf, 0 if incomplete, -1 if bad
+ */
+static long packet_len(const uint8_t *buf, size_t have, size_t *header)
+{
+    size_t remaining = 0;
+
+    for (size_t i = 1; i < 5; i++) {
+        if (i >= have) {
+            return 0;
+        }
+        remaining |= (size_t)(buf[i] & 0x7F) << (7 * (i - 1));
+        if (!(buf[i] & 0x80)) {
+            *header = i + 1;
+            return *header + remaining > PACKET_MAX ? -1 : (long)(*header + remaining);
+        }
+    }
+    return -1;
+}
+
+/* ---- broker ---- */
+
+typedef struct {
+    int fd;
+    uint8_t buf[PACKET_MAX];
+    size_t have;
+    char filters[CLIENT_FILTERS][RADAR_PRESENCE_TOPIC_LEN];
+    int filter_count;
+} broker_client_t;
+
+/**
+ * @brief Topic filter match with + for one level and # for the rest
+ */
+static int topic_matches(const char *filter, const char *topic, size_t topic_len)
+{
+    const char *t = topic;
+    const char *end = topic + topic_len;
+
+    while (*filter) {
+        if (filter[0] == '#') {
+            return 1;
+        }
+        if (filter[0] == '+') {
+            while (t < end && *t != '/') {
+                t++;
+            }
+            filter++;
+        } else {
+            if (t >= end || *t != *filter) {
+                // "a/#" also matches "a"
+                return t == end && filter[0] == '/' && filter[1] == '#' && filter[2] == 0;
+            }
+            t++;
+            filter++;
+        }
+    }
+    return t == end;
+}
+
+static void forward(broker_client_t *clients, const uint8_t *packet, size_t len, size_t header)
+{
+    size_t topic_len = (size_t)packet[header] << 8 | packet[header + 1];
+    const char *topic = (const char *)packet + header + 2;
+    uint8_t copy[PACKET_MAX];
+
+    if (header + 2 + topic_len > len) {
+        return;
+    }
+    // Retain is cleared on messages to existing subscribers
+    memcpy(copy, packet, len);
+    copy[0] &= ~0x01;
+    for (int c = 0; c < BROKER_CLIENTS; c++) {
+        for (int f = 0; f < clients[c].filter_count; f++) {
+            if (clients[c].fd >= 0 && topic_matches(clients[c].filters[f], topic, topic_len)) {
+                write_all(clients[c].fd, copy, len);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Handle one packet; returns -1 to close the connection
+ */
+static int broker_packet(broker_client_t *clients, broker_client_t *c, const uint8_t *p, size_t len, size_t header)
+{
+    uint8_t out[16];
+
+    switch (p[0] & 0xF0) {
+    case MQTT_CONNECT:
+        out[0] = MQTT_CONNACK;
+        out[1] = 2;
+        out[2] = 0;
+        out[3] = 0;
+        return write_all(c->fd, out, 4);
+    case MQTT_PUBLISH:
+        if (p[0] & 0x06) {
+            return -1;      // QoS 0 only
+        }
+        forward(clients, p, len, header);
+        return 0;
+    case MQTT_SUBSCRIBE & 0xF0: {
+        size_t i = header + 2;
+        int granted = 0;
+        while (i + 2 < len) {
+            size_t n = (size_t)p[i] << 8 | p[i + 1];
+            if (i + 2 + n + 1 > len) {
+                return -1;
+            }
+            if (c->filter_count < CLIENT_FILTERS && n < RADAR_PRESENCE_TOPIC_LEN) {
+                memcpy(c->filters[c->filter_count], p + i + 2, n);
+                c->filters[c->filter_count++][n] = 0;
+            }
+            granted++;
+            i += 2 + n + 1;
+        }
+        size_t h = put_header(out, MQTT_SUBACK, 2 + granted);
+        out[h] = p[header];
+        out[h + 1] = p[header + 1];
+        memset(out + h + 2, 0, granted);
+        return write_all(c->fd, out, h + 2 + granted);
+    }
+    case MQTT_PINGREQ:
+        out[0] = MQTT_PINGRESP;
+        out[1] = 0;
+        return write_all(c->fd, out, 2);
+    case MQTT_DISCONNECT:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+static int run_broker(int argc, char **argv)
+{
+    static broker_client_t clients[BROKER_CLIENTS];
+    struct pollfd fds[BROKER_CLIENTS + 1];
+    int port = 1883;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--port") == 0) {
+            port = atoi(argv[i + 1]);
+        } else {
+            return usage();
+        }
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY)};
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 8) != 0) {
+        perror("listen");
+        return 1;
+    }
+    for (int c = 0; c < BROKER_CLIENTS; c++) {
+        clients[c].fd = -1;
+    }
+    printf("broker on port %d\n", port);
+    fflush(stdout);
+
+    while (1) {
+        fds[0] = (struct pollfd){.fd = listener, .events = POLLIN};
+        for (int c = 0; c < BROKER_CLIENTS; c++) {
+            fds[c + 1] = (struct pollfd){.fd = clients[c].fd, .events = POLLIN};
+        }
+        if (poll(fds, BROKER_CLIENTS + 1, -1) < 0) {
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            int c = 0;
+            while (c < BROKER_CLIENTS && clients[c].fd >= 0) {
+                c++;
+            }
+            if (c == BROKER_CLIENTS) {
+                close(fd);
+            } else if (fd >= 0) {
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                clients[c].fd = fd;
+                clients[c].have = 0;
+                clients[c].filter_count = 0;
+            }
+        }
+        for (int c = 0; c < BROKER_CLIENTS; c++) {
+            broker_client_t *client = &clients[c];
+            if (client->fd < 0 || !(fds[c + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            ssize_t n = recv(client->fd, client->buf + client->have, sizeof(client->buf) - client->have, 0);
+            int closing = n <= 0;
+            if (!closing) {
+                client->have += n;
+            }
+            // Handle every complete packet, keep a partial one for the next read
+            size_t used = 0;
+            while (!closing) {
+                size_t header;
+                long len = packet_len(client->buf + used, client->have - used, &header);
+                if (len < 0) {
+                    closing = 1;
+                } else if (len == 0 || (size_t)len > client->have - used) {
+                    break;
+                } else {
+                    closing = broker_packet(clients, client, client->buf + used, len, header) < 0;
+                    used += len;
+                }
+            }
+            if (closing) {
+                close(client->fd);
+                client->fd = -1;
+                continue;
+            }
+            memmove(client->buf, client->buf + used, client->have - used);
+            client->have -= used;
+        }
+    }
+}
+
+/* ---- bench ---- */
+
+static int mqtt_connect(const char *host, const char *client_id)
+{
+    char name[128];
+    const char *port = "1883";
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *res = NULL;
+    uint8_t p[128];
+    int one = 1;
+
+    snprintf(name, sizeof(name), "%s", host);
+    char *colon = strchr(name, ':');
+    if (colon) {
+        *colon = 0;
+        port = colon + 1;
+    }
+    if (getaddrinfo(name, port, &hints, &res) != 0) {
+        fprintf(stderr, "cannot resolve %s\n", host);
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        perror("connect");
+        freeaddrinfo(res);
+        return -1;
+    }
+    freeaddrinfo(res);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    size_t id_len = strlen(client_id);
+    size_t n = put_header(p, MQTT_CONNECT, 10 + 2 + id_len);
+    n += put_string(p + n, "MQTT", 4);
+    p[n++] = 4;             // 3.1.1
+    p[n++] = 0x02;          // Clean session
+    p[n++] = 0;
+    p[n++] = 60;            // Keepalive
+    n += put_string(p + n, client_id, id_len);
+    if (write_all(fd, p, n) != 0 || recv(fd, p, 4, MSG_WAITALL) != 4 || p[0] != MQTT_CONNACK || p[3] != 0) {
+        fprintf(stderr, "broker refused the connection\n");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Serialise a PUBLISH into buf as the device does: QoS 0, retained
+ */
+static size_t put_publish(uint8_t *buf, const char *topic, const char *payload, size_t payload_len)
+{
+    size_t topic_len = strlen(topic);
+    size_t n = put_header(buf, MQTT_PUBLISH | 0x01, 2 + topic_len + payload_len);
+    n += put_string(buf + n, topic, topic_len);
+    memcpy(buf + n, payload, payload_len);
+    return n + payload_len;
+}
+
+typedef struct {
+    int fd;
+    const char *prefix;
+    _Atomic long published;         // Messages the bench sent
+    _Atomic int stop;
+    int64_t *frame_us;              // Frame time of the k-th message sent
+    uint32_t *latency_us;           // Arrival latency of the k-th message received
+    long received;
+    long bad;
+} bench_sub_t;
+
+/**
+ * @brief Subscriber thread: times each message back in send order
+ */
+static void *subscriber(void *arg)
+{
+    bench_sub_t *s = arg;
+    uint8_t buf[PACKET_MAX * 2];
+    size_t have = 0;
+    struct timeval tv = {.tv_sec = 0, .tv_usec = 200000};
+
+    setsockopt(s->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while (!atomic_load(&s->stop) || s->received < atomic_load(&s->published)) {
+        ssize_t n = recv(s->fd, buf + have, sizeof(buf) - have, 0);
+        int64_t t = now_us();
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            // Give up on missing messages a second after the bench stops
+            static int idle = 0;
+            if (atomic_load(&s->stop) && ++idle > 5) {
+                break;
+            }
+            continue;
+        }
+        have += n;
+        size_t used = 0;
+        while (1) {
+            size_t header;
+            long len = packet_len(buf + used, have - used, &header);
+            if (len <= 0 || (size_t)len > have - used) {
+                break;
+            }
+            if ((buf[used] & 0xF0) == MQTT_PUBLISH) {
+                size_t topic_len = (size_t)buf[used + header] << 8 | buf[used + header + 1];
+                size_t prefix_len = strlen(s->prefix);
+                if (topic_len > prefix_len &&
+                    memcmp(buf + used + header + 2, s->prefix, prefix_len) == 0 &&
+                    s->received < atomic_load(&s->published)) {
+                    s->latency_us[s->received] = (uint32_t)(t - s->frame_us[s->received]);
+                    s->received++;
+                } else {
+                    s->bad++;
+                }
+            }
+            used += len;
+        }
+        memmove(buf, buf + used, have - used);
+        have -= used;
+    }
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Targets from an emulator frame, in the sensor's format
+ */
+static uint8_t decode_frame(const uint8_t *frame, size_t len, radar_presence_point_t *targets)
+{
+    uint8_t detected = 0;
+
+    memset(targets, 0, sizeof(*targets) * RADAR_PRESENCE_TARGETS);
+    if (len != RADAR_EMU_FRAME_LEN || frame[0] != 0xAA || frame[1] != 0xFF ||
+        frame[RADAR_EMU_FRAME_LEN - 2] != 0x55 || frame[RADAR_EMU_FRAME_LEN - 1] != 0xCC) {
+        return 0;
+    }
+    for (int s = 0; s < RADAR_EMU_SLOTS && s < RADAR_PRESENCE_TARGETS; s++) {
+        const uint8_t *p = frame + 4 + 8 * s;
+        int16_t v[3];
+        int empty = 1;
+        for (int k = 0; k < 8; k++) {
+            empty &= p[k] == 0;
+        }
+        if (empty) {
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            uint16_t raw = p[2 * k] | p[2 * k + 1] << 8;
+            v[k] = raw & 0x8000 ? (int16_t)(raw & 0x7FFF) : (int16_t)-(raw & 0x7FFF);
+        }
+        targets[s].x = v[0];
+        targets[s].y = v[1];
+        targets[s].speed = (int16_t)(v[2] * 10);    // cm/s to mm/s
+        detected |= 1 << s;
+    }
+    return detected;
+}
+
+static int run_bench(int argc, char **argv)
+{
+    const char *host = "127.0.0.1:1883";
+    long frames = 36000;
+    int hz = 0;
+    radar_emu_config_t emu_cfg = {.walkers = 3, .noise_mm = 40, .dropout_pct = 5, .seed = 1};
+    uint32_t interval_ms = 500;
+    uint32_t hold_ms = 3000;
+    int move_mm = 150;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *val = argv[i + 1];
+        if (strcmp(arg, "--host") == 0) {
+            host = val;
+        } else if (strcmp(arg, "--frames") == 0) {
+            frames = atol(val);
+        } else if (strcmp(arg, "--hz") == 0) {
+            hz = atoi(val);
+        } else if (strcmp(arg, "--walkers") == 0) {
+            emu_cfg.walkers = (uint8_t)atoi(val);
+        } else if (strcmp(arg, "--noise") == 0) {
+            emu_cfg.noise_mm = (uint16_t)atoi(val);
+        } else if (strcmp(arg, "--dropout") == 0) {
+            emu_cfg.dropout_pct = (uint8_t)atoi(val);
+        } else if (strcmp(arg, "--interval") == 0) {
+            interval_ms = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--hold") == 0) {
+            hold_ms = (uint32_t)atoi(val);
+        } else if (strcmp(arg, "--move") == 0) {
+            move_mm = atoi(val);
+        } else {
+            return usage();
+        }
+    }
+    if (frames <= 0) {
+        return usage();
+    }
+
+    char prefix[32];
+    char id[32];
+    snprintf(prefix, sizeof(prefix), "bench/%d", (int)getpid());
+    snprintf(id, sizeof(id), "bench-pub-%d", (int)getpid());
+    int pub = mqtt_connect(host, id);
+    snprintf(id, sizeof(id), "bench-sub-%d", (int)getpid());
+    bench_sub_t sub = {.fd = mqtt_connect(host, id), .prefix = prefix};
+    if (pub < 0 || sub.fd < 0) {
+        return 1;
+    }
+
+    // Subscribe to prefix/# and wait for the SUBACK
+    uint8_t packet[PACKET_MAX];
+    char filter[40];
+    snprintf(filter, sizeof(filter), "%s/#", prefix);
+    size_t filter_len = strlen(filter);
+    size_t n = put_header(packet, MQTT_SUBSCRIBE, 2 + 2 + filter_len + 1);
+    packet[n++] = 0;
+    packet[n++] = 1;
+    n += put_string(packet + n, filter, filter_len);
+    packet[n++] = 0;
+    if (write_all(sub.fd, packet, n) != 0 || recv(sub.fd, packet, 5, MSG_WAITALL) != 5 || packet[0] != MQTT_SUBACK) {
+        fprintf(stderr, "subscribe failed\n");
+        return 1;
+    }
+
+    size_t max_msgs = (size_t)frames * RADAR_PRESENCE_MAX_MSGS + RADAR_PRESENCE_MAX_MSGS;
+    sub.frame_us = calloc(max_msgs, sizeof(*sub.frame_us));
+    sub.latency_us = calloc(max_msgs, sizeof(*sub.latency_us));
+    if (!sub.frame_us || !sub.latency_us) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, subscriber, &sub);
+
+    radar_emu_t emu;
+    radar_presence_t presence;
+    radar_presence_msg_t batch[RADAR_PRESENCE_MAX_MSGS];
+    radar_presence_point_t targets[RADAR_PRESENCE_TARGETS];
+    uint8_t raw[RADAR_EMU_FRAME_LEN];
+    long topic_msgs[RADAR_PRESENCE_MAX_MSGS] = {0};
+    long bytes = 0;
+    int64_t detect_us = 0;
+
+    radar_emu_init(&emu, &emu_cfg);
+    radar_presence_init(&presence, prefix, interval_ms, hold_ms, (uint16_t)move_mm);
+
+    printf("%ld frames, %d walkers, noise %d mm, dropout %d%%, interval %u ms, hold %u ms, move %d mm\n",
+           frames, emu_cfg.walkers, emu_cfg.noise_mm, emu_cfg.dropout_pct, interval_ms, hold_ms, move_mm);
+    fflush(stdout);
+
+    int64_t start = now_us();
+    for (long f = 0; f < frames; f++) {
+        uint32_t t_ms = (uint32_t)(f * FRAME_MS);
+        if (hz > 0) {
+            sleep_us(start + f * 1000000 / hz - now_us());
+        }
+        size_t len = radar_emu_frame(&emu, t_ms, raw);
+        uint8_t detected = decode_frame(raw, len, targets);
+
+        int64_t t0 = now_us();
+        radar_presence_update(&presence, t0, detected, targets, t_ms);
+        int count = radar_presence_flush(&presence, t_ms, batch);
+        detect_us += now_us() - t0;
+
+        for (int m = 0; m < count; m++) {
+            const radar_presence_msg_t *msg = &batch[m];
+            size_t plen = put_publish(packet, msg->topic, msg->payload, msg->payload_len);
+            long k = atomic_load(&sub.published);
+            sub.frame_us[k] = msg->frame_us;
+            atomic_store(&sub.published, k + 1);
+            if (write_all(pub, packet, plen) != 0) {
+                fprintf(stderr, "broker closed the connection\n");
+                return 1;
+            }
+            bytes += plen;
+            const char *topic = msg->topic + strlen(prefix) + 1;
+            int slot = strcmp(topic, "presence") == 0 ? 0 : strcmp(topic, "count") == 0 ? 1 : 2 + (topic[7] - '0');
+            topic_msgs[slot]++;
+        }
+    }
+    int64_t elapsed = now_us() - start;
+    atomic_store(&sub.stop, 1);
+    pthread_join(thread, NULL);
+
+    // Clear the retained topics
+    const char *topics[] = {"presence", "count", "target/0", "target/1", "target/2"};
+    for (size_t t = 0; t < sizeof(topics) / sizeof(topics[0]); t++) {
+        char topic[RADAR_PRESENCE_TOPIC_LEN];
+        snprintf(topic, sizeof(topic), "%s/%s", prefix, topics[t]);
+        write_all(pub, packet, put_publish(packet, topic, "", 0));
+    }
+    packet[0] = MQTT_DISCONNECT;
+    packet[1] = 0;
+    write_all(pub, packet, 2);
+    write_all(sub.fd, packet, 2);
+    close(pub);
+    close(sub.fd);
+
+    long messages = atomic_load(&sub.published);
+    double sensor_s = frames * FRAME_MS / 1000.0;
+    printf("%.0f s of sensor time in %.2f s\n", sensor_s, elapsed / 1e6);
+    printf("messages %ld (presence %ld, count %ld, targets %ld/%ld/%ld), %.2f/s of sensor time\n",
+           messages, topic_msgs[0], topic_msgs[1], topic_msgs[2], topic_msgs[3], topic_msgs[4],
+           messages / sensor_s);
+    printf("every topic every frame would be %ld: %.1f%% sent, %ld bytes\n",
+           frames * RADAR_PRESENCE_MAX_MSGS, 100.0 * messages / (frames * RADAR_PRESENCE_MAX_MSGS), bytes);
+    printf("detect and serialise %.0f ns/frame, %.0f ns/message\n",
+           1000.0 * detect_us / frames, messages ? 1000.0 * detect_us / messages : 0.0);
+    printf("published %.0f msgs/s\n", messages / (elapsed / 1e6));
+    if (sub.received) {
+        qsort(sub.latency_us, sub.received, sizeof(*sub.latency_us), cmp_u32);
+        printf("received %ld, lost %ld, latency p50 %u us p99 %u us max %u us\n", sub.received,
+               messages - sub.received, sub.latency_us[sub.received / 2],
+               sub.latency_us[sub.received * 99 / 100], sub.latency_us[sub.received - 1]);
+    } else {
+        printf("received nothing back\n");
+    }
+    free(sub.frame_us);
+    free(sub.latency_us);
+    return sub.received == messages ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "broker") == 0) {
+        return run_broker(argc, argv);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return run_bench(argc, argv);
+    }
+    return usage();
+}
@@ -0,0 +1,337 @@
+/*
+ * radar_multi.c
+ * Host-side multi-unit stand-in: emulated peer units sending to a
+ * collector over UDP, and a collector that merges them, using the
+ * device's own report format and merge.
+ *
+ * Build on Linux from the repository root:
+ *   cc -O2 -Imain -o radar_multi tools/radar_multi.c main/radar_merge.c main/radar_emulator.c -lm
+ *
+ * Usage:
+ *   radar_multi send --unit 1 --pose X,Y,HEADING [--to 127.0.0.1:5005]
+ *                    [--walkers 3] [--hz 10] [--noise 40] [--loss 0]
+ *                    [--clock-ms 0] [--jitter-ms 0] [--seconds 0]
+ *   radar_multi collect --poses "0:0,0,0;1:6000,0,-90" [--port 5005]
+ *                       [--radius 600] [--max-age 500] [--hz 10] [--seconds 0]
+ *
+ *   send       One emulated unit mounted at the pose. The emulator's
+ *              walkers are placed on the floor plan, so every unit sees the
+ *              same people from its own position; only those within 8 m
+ *              and +-60 degrees of the unit are reported, three at most.
+ *              --clock-ms offsets the unit's clock and --jitter-ms delays
+ *              each report by up to that much, to exercise the alignment.
+ *              --to also accepts a collector unit's address.
+ *   collect    Merge reports and print the tracks once per output frame,
+ *              then each unit's clock offset every 5 s. A device peer can
+ *              send here too.
+ *
+ * Example, three units watching one room from three walls:
+ *   ./radar_multi collect --poses "0:0,0,0;1:-4000,4000,90;2:4000,4000,-90" &
+ *   ./radar_multi send --unit 0 --pose 0,0,0 &
+ *   ./radar_multi send --unit 1 --pose -4000,4000,90 --clock-ms 5000 --jitter-ms 30 &
+ *   ./radar_multi send --unit 2 --pose 4000,4000,-90 --clock-ms -800 --loss 5 &
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "radar_emulator.h"
+#include "radar_merge.h"
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef PI
+#define PI (3.14159265358979)
+#endif
+
+#define VIEW_RANGE_MM       8000
+#define VIEW_TAN60_X1000    1732
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0) {
+        struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: radar_multi send --unit N --pose X,Y,HEADING [options]\n"
+                    "       radar_multi collect --poses SPEC [options]\n");
+    return 2;
+}
+
+/**
+ * @brief A walker on the floor plan as one unit sees it
+ */
+static int unit_view(const radar_merge_pose_t *pose, double c, double s, int walker,
+                     uint32_t t_ms, int32_t *x, int32_t *y)
+{
+    int32_t wx, wy;
+
+    radar_emu_walker_position(walker, t_ms, &wx, &wy);
+    double dx = wx - pose->x_mm;
+    double dy = wy - pose->y_mm;
+    // Inverse of the turn radar_merge_ingest() applies
+    *x = (int32_t)lround(dx * c - dy * s);
+    *y = (int32_t)lround(dx * s + dy * c);
+    return *y > 0 && labs(*x) * 1000 <= (long)*y * VIEW_TAN60_X1000 &&
+           (int64_t)*x * *x + (int64_t)*y * *y <= (int64_t)VIEW_RANGE_MM * VIEW_RANGE_MM;
+}
+
+static int run_send(int argc, char **argv)
+{
+    radar_merge_pose_t pose = {0};
+    int unit = -1;
+    int have_pose = 0;
+    const char *to = "127.0.0.1:5005";
+    int walkers = 3;
+    int hz = 10;
+    int noise = 40;
+    int loss = 0;
+    int64_t clock_us = 0;
+    int jitter_ms = 0;
+    double seconds = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *val = argv[i + 1];
+        if (strcmp(arg, "--unit") == 0) {
+            unit = atoi(val);
+        } else if (strcmp(arg, "--pose") == 0) {
+            int x, y, h;
+            if (sscanf(val, "%d,%d,%d", &x, &y, &h) != 3) {
+                return usage();
+            }
+            pose.x_mm = x;
+            pose.y_mm = y;
+            pose.heading_deg = (int16_t)h;
+            have_pose = 1;
+        } else if (strcmp(arg, "--to") == 0) {
+            to = val;
+        } else if (strcmp(arg, "--walkers") == 0) {
+            walkers = atoi(val);
+        } else if (strcmp(arg, "--hz") == 0) {
+            hz = atoi(val);
+        } else if (strcmp(arg, "--noise") == 0) {
+            noise = atoi(val);
+        } else if (strcmp(arg, "--loss") == 0) {
+            loss = atoi(val);
+        } else if (strcmp(arg, "--clock-ms") == 0) {
+            clock_us = (int64_t)atoll(val) * 1000;
+        } else if (strcmp(arg, "--jitter-ms") == 0) {
+            jitter_ms = atoi(val);
+        } else if (strcmp(arg, "--seconds") == 0) {
+            seconds = atof(val);
+        } else {
+            return usage();
+        }
+    }
+    if (unit < 0 || unit >= RADAR_MERGE_MAX_UNITS || !have_pose || hz <= 0 || hz > 1000 ||
+        walkers < 0 || walkers > RADAR_EMU_MAX_WALKERS) {
+        return usage();
+    }
+
+    char host[64];
+    int port = RADAR_MERGE_DEFAULT_PORT;
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    if (sscanf(to, "%63[^:]:%d", host, &port) < 1 || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "--to must be IPv4:port\n");
+        return 2;
+    }
+    addr.sin_port = htons((uint16_t)port);
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    double a = pose.heading_deg * PI / 180.0;
+    double c = cos(a);
+    double s = sin(a);
+    int64_t period_us = 1000000 / hz;
+    int64_t start = now_us();
+    uint64_t frames = seconds > 0 ? (uint64_t)(seconds * hz) : UINT64_MAX;
+    uint32_t sent = 0;
+
+    srand((unsigned)unit * 7919 + 1);
+    for (uint64_t n = 0; n < frames; n++) {
+        int64_t sample_us = start + (int64_t)n * period_us;
+        uint32_t t_ms = (uint32_t)((sample_us - start) / 1000);
+        radar_merge_report_t report = {
+            .unit = (uint8_t)unit,
+            .seq = (uint32_t)n + 1,
+            .sent_us = sample_us + clock_us,
+        };
+        int slot = 0;
+
+        for (int w = 0; w < walkers && slot < RADAR_MERGE_SLOTS; w++) {
+            int32_t x, y, px, py;
+            if (!unit_view(&pose, c, s, w, t_ms, &x, &y)) {
+                continue;
+            }
+            unit_view(&pose, c, s, w, t_ms >= 100 ? t_ms - 100 : 0, &px, &py);
+            if (noise) {
+                x += rand() % (2 * noise + 1) - noise;
+                y += rand() % (2 * noise + 1) - noise;
+            }
+            report.targets[slot].x = (int16_t)x;
+            report.targets[slot].y = (int16_t)y;
+            report.targets[slot].speed = (int16_t)(hypot(x, y) - hypot(px, py));
+            report.detected |= 1 << slot;
+            slot++;
+        }
+
+        sleep_us(sample_us - now_us());
+        if (jitter_ms) {
+            sleep_us((int64_t)(rand() % (jitter_ms + 1)) * 1000);
+        }
+        if (loss && rand() % 100 < loss) {
+            continue;
+        }
+        uint8_t packet[RADAR_MERGE_PACKET_LEN];
+        size_t len = radar_merge_encode(&report, packet);
+        if (sendto(sock, packet, len, 0, (struct sockaddr *)&addr, sizeof(addr)) == (ssize_t)len) {
+            sent++;
+        }
+    }
+    fprintf(stderr, "unit %d: %u reports sent\n", unit, sent);
+    return 0;
+}
+
+static int run_collect(int argc, char **argv)
+{
+    static radar_merge_t merge;
+    const char *poses = NULL;
+    int port = RADAR_MERGE_DEFAULT_PORT;
+    int radius = 600;
+    int max_age = 500;
+    int hz = 10;
+    double seconds = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *val = argv[i + 1];
+        if (strcmp(arg, "--poses") == 0) {
+            poses = val;
+        } else if (strcmp(arg, "--port") == 0) {
+            port = atoi(val);
+        } else if (strcmp(arg, "--radius") == 0) {
+            radius = atoi(val);
+        } else if (strcmp(arg, "--max-age") == 0) {
+            max_age = atoi(val);
+        } else if (strcmp(arg, "--hz") == 0) {
+            hz = atoi(val);
+        } else if (strcmp(arg, "--seconds") == 0) {
+            seconds = atof(val);
+        } else {
+            return usage();
+        }
+    }
+    if (poses == NULL || hz <= 0 || hz > 1000) {
+        return usage();
+    }
+    radar_merge_init(&merge, (uint16_t)radius, (uint32_t)max_age);
+    if (radar_merge_parse_poses(&merge, poses) <= 0) {
+        fprintf(stderr, "malformed --poses\n");
+        return 2;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("bind");
+        return 1;
+    }
+
+    int64_t period_us = 1000000 / hz;
+    int64_t start = now_us();
+    int64_t next = start + period_us;
+    int64_t next_log = start + 5000000;
+    uint64_t outputs = 0;
+    uint64_t tracks_total = 0;
+
+    while (seconds <= 0 || now_us() - start < (int64_t)(seconds * 1000000)) {
+        int64_t wait = next - now_us();
+        if (wait > 0) {
+            struct timeval tv = {.tv_sec = wait / 1000000, .tv_usec = wait % 1000000};
+            uint8_t packet[RADAR_MERGE_PACKET_LEN + 1];
+            radar_merge_report_t report;
+
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            ssize_t len = recv(sock, packet, sizeof(packet), 0);
+            if (len > 0) {
+                if (radar_merge_decode(packet, (size_t)len, &report)) {
+                    radar_merge_ingest(&merge, &report, now_us());
+                } else {
+                    merge.rejected++;
+                }
+            }
+            continue;
+        }
+        next += period_us;
+
+        int64_t t = now_us();
+        int count = radar_merge_update(&merge, t);
+        int active = 0;
+        printf("%8.1f s", (t - start) / 1e6);
+        for (int i = 0; i < count; i++) {
+            const radar_merge_track_t *track = &merge.tracks[i];
+            if (track->active) {
+                printf("  [%d] %6d,%6d units %04x", i, (int)track->x, (int)track->y, track->units);
+                active++;
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+        outputs++;
+        tracks_total += (uint64_t)active;
+
+        if (t >= next_log) {
+            next_log += 5000000;
+            for (int id = 0; id < RADAR_MERGE_MAX_UNITS; id++) {
+                const radar_merge_unit_t *u = &merge.units[id];
+                if (u->configured) {
+                    fprintf(stderr, "unit %d: %u reports, %u late, offset %.1f ms, last %.0f ms ago\n",
+                            id, u->reports, u->out_of_order, u->offset_us / 1000.0,
+                            u->seen ? (t - u->aligned_us) / 1000.0 : -1.0);
+                }
+            }
+        }
+    }
+    fprintf(stderr, "%llu frames, %.2f people on average, %u packets rejected\n",
+            (unsigned long long)outputs, outputs ? (double)tracks_total / outputs : 0.0, merge.rejected);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "send") == 0) {
+        return run_send(argc, argv);
+    }
+    if (strcmp(argv[1], "collect") == 0) {
+        return run_collect(argc, argv);
+    }
+    return usage();
+}
@@ -0,0 +1,179 @@
+/*
+ * rd03d_emu.c
+ * Host-side RD-03D stand-in: writes emulated report frames to a serial
+ * port, a pseudo terminal or stdout, using the device's own generator.
+ *
+ * Build on Linux from the repository root:
+ *   cc -O2 -Imain -o rd03d_emu tools/rd03d_emu.c main/radar_emulator.c -lm
+ *
+ * Usage:
+ *   rd03d_emu [--out PATH | --pty | --hex] [--hz 10] [--seconds 0]
+ *             [--walkers 3] [--noise 40] [--dropout 2] [--swap 1]
+ *             [--corrupt 1] [--seed 1] [--fast]
+ *
+ *   --pty      Open a pseudo terminal and print its path, for a Linux
+ *              build of the firmware to use as its sensor UART (default)
+ *   --out      Write to a file or serial device, e.g. a USB serial adapter
+ *              wired to the sensor pins; set it up first with
+ *              stty -F /dev/ttyUSB0 256000 raw
+ *   --hex      Print each frame as hex, one per line
+ *   --fast     Do not pace frames in real time; scene time still advances
+ *              by 1/hz per frame
+ *   --seconds  Stop after this much scene time, 0 runs until interrupted
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include "radar_emulator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static int open_pty(void)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    struct termios tio;
+
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        perror("pty");
+        exit(1);
+    }
+    // Raw bytes, no echo or line discipline in the way
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+    // Drop frames rather than stall while nothing reads the other end
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    printf("%s\n", ptsname(fd));
+    fflush(stdout);
+    return fd;
+}
+
+static void write_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EIO) {
+                return;     // Nobody reading the pty yet; the frame is lost, as on a wire
+            }
+            perror("write");
+            exit(1);
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    radar_emu_config_t config = {
+        .walkers = 3,
+        .noise_mm = 40,
+        .dropout_pct = 2,
+        .swap_pct = 1,
+        .corrupt_pct = 1,
+        .seed = 1,
+    };
+    const char *out = NULL;
+    int hex = 0;
+    int fast = 0;
+    int hz = 10;
+    double seconds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--pty") == 0) {
+            out = NULL;
+        } else if (strcmp(arg, "--hex") == 0) {
+            hex = 1;
+        } else if (strcmp(arg, "--fast") == 0) {
+            fast = 1;
+        } else if (val == NULL) {
+            fprintf(stderr, "unknown or incomplete option %s\n", arg);
+            return 2;
+        } else {
+            i++;
+            if (strcmp(arg, "--out") == 0) {
+                out = val;
+            } else if (strcmp(arg, "--hz") == 0) {
+                hz = atoi(val);
+            } else if (strcmp(arg, "--seconds") == 0) {
+                seconds = atof(val);
+            } else if (strcmp(arg, "--walkers") == 0) {
+                config.walkers = (uint8_t)atoi(val);
+            } else if (strcmp(arg, "--noise") == 0) {
+                config.noise_mm = (uint16_t)atoi(val);
+            } else if (strcmp(arg, "--dropout") == 0) {
+                config.dropout_pct = (uint8_t)atoi(val);
+            } else if (strcmp(arg, "--swap") == 0) {
+                config.swap_pct = (uint8_t)atoi(val);
+            } else if (strcmp(arg, "--corrupt") == 0) {
+                config.corrupt_pct = (uint8_t)atoi(val);
+            } else if (strcmp(arg, "--seed") == 0) {
+                config.seed = (uint32_t)strtoul(val, NULL, 0);
+            } else {
+                fprintf(stderr, "unknown option %s\n", arg);
+                return 2;
+            }
+        }
+    }
+    if (hz <= 0 || hz > 10000) {
+        fprintf(stderr, "--hz must be 1-10000\n");
+        return 2;
+    }
+
+    int fd = STDOUT_FILENO;
+    if (!hex) {
+        fd = out ? open(out, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644) : open_pty();
+        if (fd < 0) {
+            perror(out);
+            return 1;
+        }
+    }
+
+    radar_emu_t emu;
+    uint8_t frame[RADAR_EMU_FRAME_LEN];
+    uint64_t period_ns = 1000000000ULL / (uint64_t)hz;
+    uint64_t frames = seconds > 0 ? (uint64_t)(seconds * hz) : UINT64_MAX;
+    struct timespec next;
+
+    radar_emu_init(&emu, &config);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (uint64_t n = 0; n < frames; n++) {
+        uint32_t t_ms = (uint32_t)(n * 1000 / (uint64_t)hz);
+        size_t len = radar_emu_frame(&emu, t_ms, frame);
+
+        if (hex) {
+            for (size_t i = 0; i < len; i++) {
+                printf("%02X%s", frame[i], i + 1 < len ? " " : "\n");
+            }
+        } else {
+            write_all(fd, frame, len);
+        }
+
+        if (!fast) {
+            next.tv_nsec += (long)(period_ns % 1000000000ULL);
+            next.tv_sec += (time_t)(period_ns / 1000000000ULL) + next.tv_nsec / 1000000000L;
+            next.tv_nsec %= 1000000000L;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+    }
+
+    fprintf(stderr, "%u frames, %u dropouts, %u swaps, %u corrupted, %u truncated\n",
+            emu.stats.frames, emu.stats.dropouts, emu.stats.swaps,
+            emu.stats.corrupted, emu.stats.truncated);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+soak_check.py
+Turns the view soak run's log into an exit status for a test runner.
+
+With "View soak test" as the startup task, main/radar_soak.c logs a
+baseline, one line per heap sample and a verdict:
+  RadarSoak: Baseline: LVGL used <bytes> (frag <pct>%), heap free <bytes> (largest <bytes>)
+  RadarSoak: Cycle <n>: LVGL used <+bytes> (frag <pct>%), heap free <+bytes> (largest <bytes>)
+  RadarSoak: Soak PASSED after <cycles> cycles
+Exits 0 only if the run reached "Soak PASSED". A "Soak FAILED", a reset
+or panic after the baseline, or a log that ends without a verdict all
+exit 1. The largest drift seen in the samples is printed either way.
+
+Usage:
+  idf.py monitor | tools/soak_check.py -
+  tools/soak_check.py soak.log
+
+Reading stdin, it stops at the verdict, so the pipe ends with the run.
+Uses only the Python standard library.
+"""
+
+import argparse
+import re
+import sys
+
+BASELINE = re.compile(r"RadarSoak: Baseline: LVGL used (\d+)")
+SAMPLE = re.compile(r"RadarSoak: Cycle (\d+): LVGL used ([+-]\d+) \(frag (\d+)%\), heap free ([+-]\d+)")
+VERDICT = re.compile(r"RadarSoak: Soak (PASSED|FAILED)")
+CRASH = re.compile(r"Guru Meditation|abort\(\) was called|^rst:0x|Rebooting\.\.\.")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("log", help="monitor log, - for stdin")
+    args = parser.parse_args()
+
+    started = False
+    samples = 0
+    lvgl_max = 0
+    heap_min = 0
+    frag_max = 0
+    verdict = None
+    with (sys.stdin if args.log == "-" else open(args.log, errors="replace")) as f:
+        for line in f:
+            if BASELINE.search(line):
+                started = True
+                continue
+            m = SAMPLE.search(line)
+            if m:
+                samples += 1
+                lvgl_max = max(lvgl_max, int(m.group(2)))
+                frag_max = max(frag_max, int(m.group(3)))
+                heap_min = min(heap_min, int(m.group(4)))
+                continue
+            m = VERDICT.search(line)
+            if m:
+                verdict = m.group(1)
+                break
+            if started and CRASH.search(line):
+                verdict = "CRASHED"
+                print(line.rstrip())
+                break
+
+    print("%d samples: LVGL used up to %+d bytes (frag up to %d%%), heap free down to %+d bytes"
+          % (samples, lvgl_max, frag_max, heap_min))
+    if verdict is None:
+        print("no verdict in the log" if started else "no soak run in the log")
+        return 1
+    print("soak %s" % verdict)
+    return 0 if verdict == "PASSED" else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
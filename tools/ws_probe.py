@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+ws_probe.py
+Connects to the device's WebSocket dashboard feed from a Linux host and
+measures update rate, throughput and latency.
+
+Latency is reported in two parts:
+  - device age: sensor read to send, carried in every message
+  - network: half the WebSocket ping round trip
+Their sum estimates sensor-to-browser latency without synchronised clocks.
+
+Usage:
+  tools/ws_probe.py <device-ip> [--seconds 30] [--clients 1] [--slow-ms 0]
+
+Several clients can be opened at once to check that the device keeps
+serving all of them; each is reported separately. --slow-ms makes the
+last client pause between reads, like a stalled browser; the others
+should keep their rate and latency. Uses only the Python
+standard library.
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import threading
+import time
+
+HEADER = struct.Struct("<BBBBII")
+MSG_DELTA = 1
+
+
+def percentile(values, pct):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100))]
+
+
+class Probe:
+    def __init__(self, host, port, name, delay_s=0.0):
+        self.name = name
+        self.delay_s = delay_s
+        self.sock = socket.create_connection((host, port), timeout=5)
+        key = base64.b64encode(os.urandom(16)).decode()
+        request = (
+            f"GET /ws HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\n"
+            f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n"
+        )
+        self.sock.sendall(request.encode())
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("connection closed during handshake")
+            response += chunk
+        if b" 101 " not in response.split(b"\r\n")[0]:
+            raise ConnectionError(response.split(b"\r\n")[0].decode())
+        self.buf = response.split(b"\r\n\r\n", 1)[1]
+        self.messages = 0
+        self.bytes = 0
+        self.targets = 0
+        self.ages_us = []
+        self.gaps_ms = []
+        self.rtts_ms = []
+        self.seq_skips = 0
+        self.last_seq = None
+        self.last_arrival = None
+        self.ping_sent = None
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("connection closed")
+            self.buf += chunk
+        data, self.buf = self.buf[:n], self.buf[n:]
+        return data
+
+    def _send(self, opcode, payload=b""):
+        mask = os.urandom(4)
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.sock.sendall(bytes([0x80 | opcode, 0x80 | len(payload)]) + mask + masked)
+
+    def ping(self):
+        self.ping_sent = time.monotonic()
+        self._send(0x9, b"probe")
+
+    def read_message(self):
+        b0, b1 = self._read(2)
+        length = b1 & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", self._read(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", self._read(8))[0]
+        payload = self._read(length)
+        opcode = b0 & 0x0F
+
+        if opcode == 0xA and self.ping_sent is not None:
+            self.rtts_ms.append((time.monotonic() - self.ping_sent) * 1000)
+            self.ping_sent = None
+        elif opcode == 0x8:
+            raise ConnectionError("closed by device")
+        elif opcode == 0x2 and len(payload) >= HEADER.size:
+            self._on_delta(payload)
+
+    def _on_delta(self, payload):
+        now = time.monotonic()
+        kind, mask, _detected, _count, seq, age_us = HEADER.unpack_from(payload)
+        if kind != MSG_DELTA:
+            return
+        self.messages += 1
+        self.bytes += len(payload)
+        self.targets += bin(mask).count("1")
+        self.ages_us.append(age_us)
+        if self.last_arrival is not None:
+            self.gaps_ms.append((now - self.last_arrival) * 1000)
+        if self.last_seq is not None and seq - self.last_seq > 1:
+            self.seq_skips += seq - self.last_seq - 1
+        self.last_arrival = now
+        self.last_seq = seq
+
+    def run(self, seconds):
+        end = time.monotonic() + seconds
+        next_ping = time.monotonic()
+        self.sock.settimeout(0.2)
+        while time.monotonic() < end:
+            if time.monotonic() >= next_ping:
+                self.ping()
+                next_ping += 1.0
+            try:
+                self.read_message()
+            except socket.timeout:
+                continue
+            if self.delay_s:
+                time.sleep(self.delay_s)
+        self._send(0x8, struct.pack(">H", 1000))
+        self.sock.close()
+
+    def report(self, seconds):
+        rtt = percentile(self.rtts_ms, 50)
+        age50 = percentile(self.ages_us, 50) / 1000
+        age95 = percentile(self.ages_us, 95) / 1000
+        print(f"[{self.name}] {self.messages / seconds:.1f} msg/s, "
+              f"{self.bytes / seconds:.0f} B/s, "
+              f"{self.targets / max(self.messages, 1):.2f} targets/msg, "
+              f"{self.seq_skips} frames unchanged or coalesced")
+        print(f"[{self.name}] device age p50 {age50:.1f} ms p95 {age95:.1f} ms, "
+              f"ping RTT p50 {rtt:.1f} ms p95 {percentile(self.rtts_ms, 95):.1f} ms, "
+              f"gap p95 {percentile(self.gaps_ms, 95):.0f} ms")
+        print(f"[{self.name}] estimated sensor-to-host latency p50 {age50 + rtt / 2:.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--seconds", type=float, default=30)
+    parser.add_argument("--clients", type=int, default=1)
+    parser.add_argument("--slow-ms", type=float, default=0,
+                        help="pause after each message on the last client")
+    args = parser.parse_args()
+
+    probes = [Probe(args.host, args.port, f"client {i}",
+                    args.slow_ms / 1000 if i == args.clients - 1 else 0.0)
+              for i in range(args.clients)]
+    threads = [threading.Thread(target=p.run, args=(args.seconds,)) for p in probes]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for p in probes:
+        p.report(args.seconds)
+
+
+if __name__ == "__main__":
+    main()